@@ -1,188 +1,1057 @@
 #include "buffer/buffer_pool_manager.h"
+#include <sys/mman.h>
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <new>
 
 #include "common/config.h"
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
 static const char EMPTY_PAGE_DATA[PAGE_SIZE] = {0};
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+static constexpr uint32_t RESIDENT_PAGES_MAGIC_NUM = 0x57A4B7E1;
+static constexpr int DETACH_FILE_RETRIES = 1000;  // wait up to this many milliseconds for the pages to be unpinned
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager) {
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size_);
-  for (size_t i = 0; i < pool_size_; i++) {
-    free_list_.emplace_back(i);
+/** Page-aligned buffer of a batch of pages, which direct I/O can use as it is */
+using PageBuffer = std::unique_ptr<char, decltype(&free)>;
+
+static PageBuffer AllocatePageBuffer(size_t num_pages) {
+  PageBuffer buffer(static_cast<char *>(aligned_alloc(PAGE_SIZE, std::max<size_t>(num_pages, 1) * PAGE_SIZE)), &free);
+  if (buffer == nullptr) {
+    throw std::bad_alloc();
   }
+  return buffer;
+}
+
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, ReplacerType replacer_type)
+    : pool_size_(0),
+      chunks_(MAX_BUFFER_POOL_CHUNKS),
+      replacer_type_(replacer_type),
+      disk_manager_(disk_manager),
+      files_(MAX_BUFFER_POOL_FILES, nullptr) {
+  files_[DEFAULT_FILE_ID] = disk_manager;
+  ASSERT(pool_size <= static_cast<size_t>(BUFFER_POOL_CHUNK_PAGES) * MAX_BUFFER_POOL_CHUNKS, "Buffer pool too large.");
+  replacer_ = CreateReplacer(replacer_type, pool_size);
+  AddFrames(pool_size);
+}
+
+BufferPoolManager::BufferPoolManager(DiskManager *disk_manager)
+    : pool_size_(0),
+      replacer_type_(ReplacerType::LRU),
+      disk_manager_(disk_manager),
+      files_(MAX_BUFFER_POOL_FILES, nullptr),
+      replacer_(nullptr) {
+  files_[DEFAULT_FILE_ID] = disk_manager;
 }
 
 BufferPoolManager::~BufferPoolManager() {
-  for (auto page : page_table_) {
-    FlushPage(page.first);
+  StopIOWorkers();
+  StopBackgroundWriter();
+  std::vector<frame_id_t> frame_ids;
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (GetFrame(i).page_id_ != INVALID_PAGE_ID) {
+      frame_ids.push_back(i);
+    }
   }
-  delete[] pages_;
+  WriteBackFrames(frame_ids);
+  RemoveFrames(0);
   delete replacer_;
 }
 
 /**
  * TODO: Student Implement
  */
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
+Page *BufferPoolManager::FetchPage(page_id_t page_id) { return FetchPage(DEFAULT_FILE_ID, page_id, nullptr); }
+
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return FetchPage(DEFAULT_FILE_ID, page_id, strategy);
+}
+
+Page *BufferPoolManager::FetchPage(file_id_t file_id, page_id_t page_id, BufferAccessStrategy *strategy) {
   if (page_id <= INVALID_PAGE_ID) {
     // std::cerr << "FetchPage" << std::endl;
     return nullptr;
   }
-  auto iter = page_table_.find(page_id);
-  if (page_table_.find(page_id) != page_table_.end())  // 该页存在于内存中
-  {
-    frame_id_t frame_id = iter->second;
-    replacer_->Pin(frame_id);  // pin这一页，增加访问次数一次
-    pages_[frame_id].pin_count_++;
-    return &pages_[frame_id];  // 返回对应页指针
+  Page *page = PinCachedPage(file_id, page_id);  // 该页存在于内存中，不需要获取latch_
+  if (page != nullptr) {
+    return page;
   }
-  // 以下处理该页不存在于内存中的情况
-  if (free_list_.empty())  // 内存池中没有空页
-  {
-    frame_id_t frame_id;
-    replacer_->Victim(&frame_id);  // 获取一个可替换frame_id
-    if (frame_id == INVALID_FRAME_ID) return nullptr;
-    page_id_t replace_page_id = pages_[frame_id].GetPageId();  // 获取替换页的逻辑页号
-    if (pages_[frame_id].IsDirty()) {                          // 脏页，重新写回磁盘
-      disk_manager_->WritePage(replace_page_id, pages_[frame_id].GetData());
-    }
-    iter = page_table_.find(replace_page_id);
-    page_table_.erase(iter);
-
-    replacer_->Unpin(frame_id);                                    // 解除空页绑定
-    disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());  // 从硬盘中读取
-    pages_[frame_id].page_id_ = page_id;
-    pages_[frame_id].is_dirty_ = false;
-    pages_[frame_id].pin_count_ = 1;
-    replacer_->Pin(frame_id);
-    page_table_.insert({page_id, frame_id});  // 向page_table插入对应关系
-    return &pages_[frame_id];
-  } else  // 内存中有空页
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  page = PinCachedPage(file_id, page_id);  // 获取latch_期间可能已被其他线程载入
+  if (page != nullptr) {
+    return page;
+  }
+  // 以下处理该页不存在于内存中的情况，先尝试复用ring中的页帧，再从空页链表或replacer中获取一个页帧
+  BufferAccessStrategy::Slot *slot = (strategy != nullptr ? &strategy->NextSlot() : nullptr);
+  frame_id_t frame_id = (slot != nullptr ? TryToReuseRingFrame(*slot) : INVALID_FRAME_ID);
+  if (frame_id == INVALID_FRAME_ID) {
+    frame_id = TryToFindFreePage();
+  }
+  if (frame_id == INVALID_FRAME_ID) {
+    return nullptr;
+  }
+  if (slot != nullptr) {
+    *slot = {this, frame_id, file_id, page_id};
+  }
+  page = &GetFrame(frame_id);
+  GetDiskManager(file_id)->ReadPage(page_id, page->GetData());  // 从硬盘中读取
+  page->page_id_ = page_id;
+  page->file_id_ = file_id;
+  page->is_dirty_ = false;
+  page->pin_count_ = 1;
   {
-    frame_id_t frame_id = free_list_.front();  // 获取第一个空页的页帧
-    free_list_.erase(free_list_.begin());      // 从链表中删除第一个空页
-    replacer_->Unpin(frame_id);
-    disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());  // 从硬盘中读取数据
-    pages_[frame_id].page_id_ = page_id;
-    pages_[frame_id].is_dirty_ = false;
-    pages_[frame_id].pin_count_ = 1;
+    std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
     replacer_->Pin(frame_id);  // 固定当前页，有访问
-    page_table_.insert({page_id, frame_id});
-    return &pages_[frame_id];
   }
-  std::cerr << "FetchPage error" << std::endl;
-  return nullptr;
+  page_table_.Insert(file_id, page_id, frame_id);  // 载入完成后才插入对应关系，命中的线程不会读到未载入的页
+  InvalidatePrefetchReads(file_id, page_id);
+  return page;
+}
+
+Page *BufferPoolManager::PinCachedPage(file_id_t file_id, page_id_t page_id) {
+  Page *page = nullptr;
+  frame_id_t frame_id = INVALID_FRAME_ID;
+  int old_pin_count = 0;
+  // 在stripe的读latch下增加pin_count，替换页时在写latch下检查pin_count，因此命中的页不会被同时替换
+  page_table_.Find(file_id, page_id, [&](frame_id_t found_frame_id) {
+    frame_id = found_frame_id;
+    page = &GetFrame(frame_id);
+    old_pin_count = page->pin_count_.fetch_add(1);
+  });
+  if (page != nullptr && old_pin_count == 0) {
+    std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+    replacer_->Pin(frame_id);  // pin这一页，增加访问次数一次
+  }
+  return page;
 }
 
 /**
  * TODO: Student Implement
  */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-  if (!free_list_.empty())  // 内存中有空页
+Page *BufferPoolManager::NewPage(page_id_t &page_id) { return NewPage(DEFAULT_FILE_ID, page_id); }
+
+Page *BufferPoolManager::NewPage(file_id_t file_id, page_id_t &page_id) {
+  return NewPageWithHint(file_id, page_id, nullptr);
+}
+
+Page *BufferPoolManager::NewPageNear(page_id_t &page_id, page_id_t near_page_id) {
+  return NewPageNear(DEFAULT_FILE_ID, page_id, near_page_id);
+}
+
+Page *BufferPoolManager::NewPageNear(file_id_t file_id, page_id_t &page_id, page_id_t near_page_id) {
+  return NewPageWithHint(file_id, page_id, &near_page_id);
+}
+
+Page *BufferPoolManager::NewPageInSegment(segment_id_t segment_id, page_id_t &page_id) {
+  if (segment_id != MAIN_SEGMENT_ID) {
+    page_id = INVALID_PAGE_ID;
+    return nullptr;
+  }
+  return NewPageNear(page_id, INVALID_PAGE_ID);
+}
+
+Page *BufferPoolManager::NewPageWithHint(file_id_t file_id, page_id_t &page_id, const page_id_t *near_page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  // 根据replacer策略获得一个空页帧，如果所有页都被Pin了，返回nullptr
+  frame_id_t frame_id = TryToFindFreePage();
+  if (frame_id == INVALID_FRAME_ID) {
+    return nullptr;
+  }
+  DiskManager *disk_manager = GetDiskManager(file_id);
+  // 从磁盘中获取一个空的页(逻辑号)
+  page_id = (near_page_id != nullptr ? disk_manager->AllocatePageNear(*near_page_id) : disk_manager->AllocatePage());
+  if (page_id == INVALID_PAGE_ID)  // 磁盘没有空的页，归还页帧
   {
-    frame_id_t frame_id = free_list_.front();  // 获取第一个空页的页帧
-    free_list_.erase(free_list_.begin());      // 从空页链表中擦除第一个空页
-    page_id = AllocatePage();                  // 从磁盘中获取一个空的页(逻辑号)
-    if (page_id == INVALID_PAGE_ID)            // 磁盘没有空的页返回
-      return nullptr;
-    // 更新Page的信息,注意此时不能解除空页固定，空页相当于被Pin住了(空页不能被替换)
-    pages_[frame_id].page_id_ = page_id;  // 修改信息
-    pages_[frame_id].is_dirty_ = false;
-    pages_[frame_id].pin_count_ = 0;
-    pages_[frame_id].ResetMemory();           // 清空Page
-    page_table_.insert({page_id, frame_id});  // 向page table中插入对应关系
-    return &pages_[frame_id];
-  }
-  // 内存中没有空页
-  frame_id_t frame_id;
-  replacer_->Victim(&frame_id);      // 根据replacer策略获得一个替换的页R
-  if (frame_id == INVALID_FRAME_ID)  // 如果所有页都被Pin了，返回nullpter
+    free_list_.emplace_back(frame_id);
     return nullptr;
-  page_id = AllocatePage();        // 从磁盘中获取一个空的页(逻辑号)
-  if (page_id == INVALID_PAGE_ID)  // 磁盘没有空的页返回
+  }
+  // 更新Page的信息,注意此时不能解除空页固定，空页相当于被Pin住了(空页不能被替换)
+  Page &page = GetFrame(frame_id);
+  page.page_id_ = page_id;
+  page.file_id_ = file_id;
+  page.is_dirty_ = false;
+  page.pin_count_ = 0;
+  page.ResetMemory();                              // 清空Page
+  page_table_.Insert(file_id, page_id, frame_id);  // 向page table中插入对应关系
+  InvalidatePrefetchReads(file_id, page_id);
+  return &page;
+}
+
+Page *BufferPoolManager::NewPageWithId(file_id_t file_id, page_id_t page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  frame_id_t frame_id = TryToFindFreePage();
+  if (frame_id == INVALID_FRAME_ID) {
     return nullptr;
-  page_id_t replace_page_id = pages_[frame_id].GetPageId();  // 获取替换页对应的逻辑页号
-  if (pages_[frame_id].IsDirty())                            // 替换页是脏的，需要重新写回磁盘
-    disk_manager_->WritePage(replace_page_id, pages_[frame_id].GetData());
-  auto iter = page_table_.find(replace_page_id);  // 从page_table_中删除替换页的映射关系
-  page_table_.erase(iter);
-  pages_[frame_id].page_id_ = page_id;  // 修改信息
-  pages_[frame_id].is_dirty_ = false;
-  pages_[frame_id].pin_count_ = 0;
-  pages_[frame_id].ResetMemory();
-  page_table_.insert({page_id, frame_id});  // 向page table中插入对应关系
-  return &pages_[frame_id];
+  }
+  Page &page = GetFrame(frame_id);
+  page.page_id_ = page_id;
+  page.file_id_ = file_id;
+  page.is_dirty_ = false;
+  page.pin_count_ = 0;
+  page.ResetMemory();
+  page_table_.Insert(file_id, page_id, frame_id);
+  InvalidatePrefetchReads(file_id, page_id);
+  return &page;
 }
 
 /**
  * TODO: Student Implement
  */
-bool BufferPoolManager::DeletePage(page_id_t page_id) {
-  auto iter = page_table_.find(page_id);
-  if (iter != page_table_.end())  // 该页存在于内存中
+bool BufferPoolManager::DeletePage(page_id_t page_id) { return DeletePage(DEFAULT_FILE_ID, page_id); }
+
+bool BufferPoolManager::DeletePage(file_id_t file_id, page_id_t page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  frame_id_t frame_id = page_table_.Find(file_id, page_id);
+  if (frame_id != INVALID_FRAME_ID)  // 该页存在于内存中
   {
-    frame_id_t frame_id = page_table_[page_id];
-    if (pages_[frame_id].GetPinCount() > 0)  // 该页还在使用
-    {
+    // 该页还在使用
+    if (!page_table_.EraseIf(file_id, page_id,
+                             [this](frame_id_t frame_id) { return GetFrame(frame_id).pin_count_ == 0; })) {
       return false;
     }
-    replacer_->Reset(frame_id);  // replacer中将该页清除
-    page_table_.erase(iter);
+    {
+      std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+      replacer_->Reset(frame_id);  // replacer中将该页清除
+    }
     free_list_.emplace_back(frame_id);
-    pages_[frame_id].ResetMemory();  // 重置page信息
-    pages_[frame_id].is_dirty_ = false;
-    pages_[frame_id].pin_count_ = 0;
-    pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+    Page &page = GetFrame(frame_id);
+    page.ResetMemory();  // 重置page信息
+    page.is_dirty_ = false;
+    page.pin_count_ = 0;
+    page.page_id_ = INVALID_PAGE_ID;
   }
-  DeallocatePage(page_id);  // 无论在不在页面中都要从磁盘中释放该页
+  InvalidatePrefetchReads(file_id, page_id);
+  GetDiskManager(file_id)->DeAllocatePage(page_id);  // 无论在不在页面中都要从磁盘中释放该页
   return true;
 }
 
+Page *BufferPoolManager::RelocatePage(page_id_t page_id, page_id_t &new_page_id) {
+  return RelocatePage(DEFAULT_FILE_ID, page_id, new_page_id);
+}
+
+Page *BufferPoolManager::RelocatePage(file_id_t file_id, page_id_t page_id, page_id_t &new_page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  new_page_id = INVALID_PAGE_ID;
+  Page *old_page = FetchPage(file_id, page_id, nullptr);
+  if (old_page == nullptr) {
+    return nullptr;
+  }
+  DiskManager *disk_manager = GetDiskManager(file_id);
+  page_id_t target = disk_manager->AllocatePageBelow(page_id);
+  Page *new_page = (target == INVALID_PAGE_ID ? nullptr : NewPageWithId(file_id, target));
+  if (new_page == nullptr) {
+    if (target != INVALID_PAGE_ID) {
+      disk_manager->DeAllocatePage(target);
+    }
+    UnpinPage(file_id, page_id, false);
+    return nullptr;
+  }
+  memcpy(new_page->GetData(), old_page->GetData(), PAGE_SIZE);
+  new_page->is_dirty_ = true;
+  UnpinPage(file_id, page_id, false);
+  if (!DeletePage(file_id, page_id)) {
+    // 旧页还在被使用，不能移动
+    DeletePage(file_id, target);
+    return nullptr;
+  }
+  new_page_id = target;
+  return new_page;
+}
+
+void BufferPoolManager::TruncateFiles() {
+  FlushAllPages();
+  for (auto disk_manager : files_) {
+    if (disk_manager != nullptr) {
+      disk_manager->TruncateFile();
+    }
+  }
+}
+
 /**
  * TODO: Student Implement
  */
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  if (page_table_.find(page_id) == page_table_.end()) return false;
-  frame_id_t frame_id = page_table_[page_id];
-  pages_[frame_id].is_dirty_ = is_dirty;
-  if (pages_[frame_id].pin_count_ > 0) pages_[frame_id].pin_count_--;
-  if (pages_[frame_id].pin_count_ == 0) replacer_->Unpin(frame_id);
+  return UnpinPage(DEFAULT_FILE_ID, page_id, is_dirty);
+}
+
+bool BufferPoolManager::UnpinPage(file_id_t file_id, page_id_t page_id, bool is_dirty) {
+  frame_id_t frame_id = INVALID_FRAME_ID;
+  int pin_count = 0;
+  bool found = page_table_.Find(file_id, page_id, [&](frame_id_t found_frame_id) {
+    Page &page = GetFrame(found_frame_id);
+    frame_id = found_frame_id;
+    // 脏标记只能由写回磁盘清除，不能被之后的只读使用者覆盖
+    if (is_dirty) {
+      page.is_dirty_ = true;
+    }
+    pin_count = page.pin_count_;
+    while (pin_count > 0 && !page.pin_count_.compare_exchange_weak(pin_count, pin_count - 1)) {
+    }
+    pin_count = (pin_count > 0 ? pin_count - 1 : 0);
+  });
+  if (!found) {
+    return false;
+  }
+  if (pin_count == 0) {
+    // 重新查找一次，以免页帧已被替换给其他页；此时该页仍可能被再次pin，多出的可替换页会在替换时被跳过
+    std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+    page_table_.Find(file_id, page_id, [&](frame_id_t found_frame_id) {
+      if (found_frame_id == frame_id && GetFrame(frame_id).pin_count_ == 0) {
+        replacer_->Unpin(frame_id);
+      }
+    });
+  }
   return true;
 }
 
 /**
  * TODO: Student Implement
  */
-bool BufferPoolManager::FlushPage(page_id_t page_id) {
-  // 将内存中的所有页写回磁盘
-  frame_id_t frame_id = page_table_[page_id];
-  disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
+bool BufferPoolManager::FlushPage(page_id_t page_id) { return FlushPage(DEFAULT_FILE_ID, page_id); }
+
+bool BufferPoolManager::FlushPage(file_id_t file_id, page_id_t page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  frame_id_t frame_id = page_table_.Find(file_id, page_id);
+  if (frame_id == INVALID_FRAME_ID) {
+    return false;
+  }
+  GetDiskManager(file_id)->WritePage(page_id, GetFrame(frame_id).GetData());
+  GetFrame(frame_id).is_dirty_ = false;
   return true;
 }
 
+void BufferPoolManager::FlushAllPages() {
+  WriteBackDirtyPages(INVALID_FILE_ID);
+  for (auto disk_manager : files_) {
+    if (disk_manager != nullptr) {
+      disk_manager->Sync();
+    }
+  }
+}
+
+void BufferPoolManager::WriteBackDirtyPages(file_id_t file_id) {
+  std::vector<frame_id_t> dirty;
+  {
+    std::scoped_lock<std::recursive_mutex> lock(latch_);
+    for (size_t i = 0; i < pool_size_; i++) {
+      Page &page = GetFrame(i);
+      bool in_file = (file_id == INVALID_FILE_ID || page.file_id_ == file_id);
+      if (page.page_id_ != INVALID_PAGE_ID && page.IsDirty() && in_file) {
+        // 写回期间pin住该页，使其不会被替换或删除；先清除脏标记，写回期间的修改会重新标记
+        page.pin_count_++;
+        page.is_dirty_ = false;
+        dirty.push_back(i);
+      }
+    }
+  }
+  WriteBackFrames(dirty);
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  for (auto frame_id : dirty) {
+    if (--GetFrame(frame_id).pin_count_ == 0) {
+      std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+      replacer_->Unpin(frame_id);
+    }
+  }
+}
+
+frame_id_t BufferPoolManager::TryToFindFreePage() {
+  frame_id_t frame_id = INVALID_FRAME_ID;
+  if (!free_list_.empty()) {
+    frame_id = free_list_.front();  // 获取第一个空页的页帧
+    free_list_.pop_front();         // 从链表中删除第一个空页
+    WakeBackgroundWriterIfNeeded();
+    return frame_id;
+  }
+  WakeBackgroundWriterIfNeeded();
+  while (true) {
+    {
+      std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+      if (!replacer_->Victim(&frame_id) || frame_id == INVALID_FRAME_ID) {
+        return INVALID_FRAME_ID;
+      }
+    }
+    // 被选中的页可能在此之前又被pin住了，跳过它，它在unpin时会重新回到replacer
+    if (EvictFrame(frame_id)) {
+      return frame_id;
+    }
+  }
+}
+
+frame_id_t BufferPoolManager::TryToReuseRingFrame(const BufferAccessStrategy::Slot &slot) {
+  if (slot.owner_ != this || slot.frame_id_ == INVALID_FRAME_ID) {
+    return INVALID_FRAME_ID;
+  }
+  // 缓冲池缩小后ring中可能还留有已被移除的页帧
+  if (static_cast<size_t>(slot.frame_id_) >= pool_size_) {
+    return INVALID_FRAME_ID;
+  }
+  Page &page = GetFrame(slot.frame_id_);
+  if (page.page_id_ != slot.page_id_ || page.file_id_ != slot.file_id_ || !EvictFrame(slot.frame_id_)) {
+    return INVALID_FRAME_ID;
+  }
+  std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+  replacer_->Reset(slot.frame_id_);  // replacer中将该页清除
+  return slot.frame_id_;
+}
+
+bool BufferPoolManager::EvictFrame(frame_id_t frame_id) {
+  Page &page = GetFrame(frame_id);
+  page_id_t replace_page_id = page.page_id_;  // 获取替换页的逻辑页号
+  if (replace_page_id == INVALID_PAGE_ID ||
+      !page_table_.EraseIf(page.file_id_, replace_page_id, [&page](frame_id_t) { return page.pin_count_ == 0; })) {
+    return false;
+  }
+  if (page.IsDirty()) {  // 脏页，重新写回磁盘
+    GetDiskManager(page.file_id_)->WritePage(replace_page_id, page.GetData());
+  }
+  page.page_id_ = INVALID_PAGE_ID;
+  page.is_dirty_ = false;
+  return true;
+}
+
+void BufferPoolManager::StartBackgroundWriter(size_t low_watermark, size_t high_watermark) {
+  ASSERT(low_watermark <= high_watermark, "Low watermark is above high watermark.");
+  low_watermark_ = low_watermark;
+  high_watermark_ = std::min<size_t>(high_watermark, pool_size_);
+  if (!writer_thread_.joinable()) {
+    writer_stop_ = false;
+    writer_thread_ = std::thread(&BufferPoolManager::BackgroundWriterLoop, this);
+  }
+}
+
+void BufferPoolManager::StopBackgroundWriter() {
+  if (!writer_thread_.joinable()) {
+    return;
+  }
+  {
+    std::scoped_lock<std::mutex> lock(writer_latch_);
+    writer_stop_ = true;
+  }
+  writer_cv_.notify_one();
+  writer_thread_.join();
+}
+
+void BufferPoolManager::WakeBackgroundWriterIfNeeded() {
+  if (!writer_thread_.joinable() || free_list_.size() >= low_watermark_) {
+    return;
+  }
+  {
+    std::scoped_lock<std::mutex> lock(writer_latch_);
+    writer_wakeup_ = true;
+  }
+  writer_cv_.notify_one();
+}
+
+void BufferPoolManager::BackgroundWriterLoop() {
+  while (true) {
+    {
+      // 除了被唤醒之外也定期检查一次，以免错过前台线程的通知
+      std::unique_lock<std::mutex> lock(writer_latch_);
+      writer_cv_.wait_for(lock, std::chrono::milliseconds(BG_WRITER_INTERVAL_MS),
+                          [this] { return writer_stop_ || writer_wakeup_; });
+      if (writer_stop_) {
+        return;
+      }
+      writer_wakeup_ = false;
+    }
+    {
+      std::scoped_lock<std::recursive_mutex> lock(latch_);
+      if (free_list_.size() >= low_watermark_) {
+        continue;
+      }
+    }
+    while (WriteBackVictims()) {
+      std::scoped_lock<std::mutex> lock(writer_latch_);
+      if (writer_stop_) {
+        return;
+      }
+    }
+  }
+}
+
+bool BufferPoolManager::WriteBackVictims() {
+  std::unique_lock<std::recursive_mutex> lock(latch_);
+  if (free_list_.size() >= high_watermark_) {
+    return false;
+  }
+  size_t num_victims = std::min<size_t>(high_watermark_ - free_list_.size(), IO_URING_QUEUE_DEPTH);
+  std::vector<frame_id_t> victims;
+  {
+    std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+    frame_id_t frame_id = INVALID_FRAME_ID;
+    while (victims.size() < num_victims && replacer_->Victim(&frame_id) && frame_id != INVALID_FRAME_ID) {
+      victims.push_back(frame_id);
+    }
+  }
+  if (victims.empty()) {
+    return false;
+  }
+  std::vector<frame_id_t> pinned;
+  std::vector<frame_id_t> dirty;
+  for (auto frame_id : victims) {
+    Page &page = GetFrame(frame_id);
+    int unpinned = 0;
+    if (page.page_id_ == INVALID_PAGE_ID || !page.pin_count_.compare_exchange_strong(unpinned, 1)) {
+      continue;  // 该页已被再次pin住，unpin时会重新回到replacer
+    }
+    pinned.push_back(frame_id);
+    if (page.IsDirty()) {
+      // 先清除脏标记，写回期间的修改会重新标记
+      page.is_dirty_ = false;
+      dirty.push_back(frame_id);
+    }
+  }
+  if (!dirty.empty()) {
+    // 写回期间由后台线程持有一次pin，页仍可被命中，但不会被替换或删除
+    lock.unlock();
+    WriteBackFrames(dirty);
+    lock.lock();
+  }
+  for (auto frame_id : pinned) {
+    Page &page = GetFrame(frame_id);
+    page.pin_count_--;
+    if (!page.IsDirty() && EvictFrame(frame_id)) {
+      free_list_.emplace_back(frame_id);
+    } else if (page.pin_count_ == 0) {
+      std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+      replacer_->Unpin(frame_id);
+    }
+  }
+  return true;
+}
+
+void BufferPoolManager::WriteBackFrames(const std::vector<frame_id_t> &frame_ids) {
+  // 逐页在读latch下复制出来，不同时持有多个页的latch，以免与持有页latch再去fetch其他页的线程死锁
+  PageBuffer buffer = AllocatePageBuffer(frame_ids.size());
+  std::map<file_id_t, std::vector<PageIORequest>> requests;
+  for (size_t i = 0; i < frame_ids.size(); i++) {
+    Page &page = GetFrame(frame_ids[i]);
+    char *data = buffer.get() + i * PAGE_SIZE;
+    page.RLatch();
+    memcpy(data, page.GetData(), PAGE_SIZE);
+    page.RUnlatch();
+    requests[page.file_id_].push_back({page.page_id_, data});
+  }
+  for (auto &file_requests : requests) {
+    GetDiskManager(file_requests.first)->WritePages(file_requests.second);
+  }
+}
+
+void BufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  for (auto page_id : page_ids) {
+    EnqueuePrefetch(page_id, 1, nullptr);
+  }
+}
+
+void BufferPoolManager::PrefetchChain(page_id_t page_id, size_t count, NextPageIdFunc next_page_id) {
+  if (count > 0) {
+    EnqueuePrefetch(page_id, count, next_page_id);
+  }
+}
+
+void BufferPoolManager::EnqueuePrefetch(page_id_t page_id, size_t count, NextPageIdFunc next_page_id) {
+  if (page_id <= INVALID_PAGE_ID) {
+    return;
+  }
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    // 预读只是提示，队列过长时直接丢弃请求
+    if (io_workers_stop_ || prefetch_queue_.size() >= GetPoolSize()) {
+      return;
+    }
+    if (io_workers_.empty()) {
+      for (int i = 0; i < PREFETCH_IO_WORKERS; i++) {
+        io_workers_.emplace_back(&BufferPoolManager::IOWorkerLoop, this);
+      }
+    }
+    prefetch_queue_.push_back({page_id, count, next_page_id});
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManager::StopIOWorkers() {
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    io_workers_stop_ = true;
+    prefetch_queue_.clear();
+  }
+  prefetch_cv_.notify_all();
+  for (auto &worker : io_workers_) {
+    worker.join();
+  }
+  io_workers_.clear();
+  if (warm_up_thread_.joinable()) {
+    warm_up_thread_.join();
+  }
+}
+
+bool BufferPoolManager::IOWorkersStopped() {
+  std::scoped_lock<std::mutex> lock(prefetch_latch_);
+  return io_workers_stop_;
+}
+
+void BufferPoolManager::IOWorkerLoop() {
+  while (true) {
+    PrefetchRequest request;
+    {
+      std::unique_lock<std::mutex> lock(prefetch_latch_);
+      prefetch_cv_.wait(lock, [this] { return io_workers_stop_ || !prefetch_queue_.empty(); });
+      if (io_workers_stop_) {
+        return;
+      }
+      request = prefetch_queue_.front();
+      prefetch_queue_.pop_front();
+    }
+    page_id_t next_page_id = PrefetchPage(request.page_id_, request.next_page_id_);
+    if (request.count_ > 1 && next_page_id != INVALID_PAGE_ID) {
+      EnqueuePrefetch(next_page_id, request.count_ - 1, request.next_page_id_);
+    }
+  }
+}
+
+std::vector<page_id_t> BufferPoolManager::GetResidentPageIds() { return GetResidentPageIds(DEFAULT_FILE_ID); }
+
+std::vector<page_id_t> BufferPoolManager::GetResidentPageIds(file_id_t file_id) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  std::vector<frame_id_t> order;
+  {
+    std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+    order = replacer_->GetEvictionOrder();
+  }
+  std::vector<bool> listed(pool_size_, false);
+  std::vector<page_id_t> page_ids;
+  for (auto frame_id : order) {
+    Page &page = GetFrame(frame_id);
+    if (page.page_id_ != INVALID_PAGE_ID && page.file_id_ == file_id) {
+      page_ids.push_back(page.page_id_);
+      listed[frame_id] = true;
+    }
+  }
+  // 不在replacer中的页(被pin住的页)视为最热的页
+  for (size_t i = 0; i < pool_size_; i++) {
+    Page &page = GetFrame(i);
+    if (!listed[i] && page.page_id_ != INVALID_PAGE_ID && page.file_id_ == file_id) {
+      page_ids.push_back(page.page_id_);
+    }
+  }
+  return page_ids;
+}
+
+bool BufferPoolManager::DumpResidentPages(const std::string &file_name) {
+  std::vector<page_id_t> page_ids = GetResidentPageIds();
+  std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    return false;
+  }
+  uint32_t count = page_ids.size();
+  out.write(reinterpret_cast<const char *>(&RESIDENT_PAGES_MAGIC_NUM), sizeof(uint32_t));
+  out.write(reinterpret_cast<const char *>(&count), sizeof(uint32_t));
+  out.write(reinterpret_cast<const char *>(page_ids.data()), count * sizeof(page_id_t));
+  return out.good();
+}
+
+std::vector<page_id_t> BufferPoolManager::LoadResidentPages(const std::string &file_name) {
+  std::ifstream in(file_name, std::ios::binary);
+  uint32_t magic_num = 0;
+  uint32_t count = 0;
+  if (!in.read(reinterpret_cast<char *>(&magic_num), sizeof(uint32_t)) || magic_num != RESIDENT_PAGES_MAGIC_NUM ||
+      !in.read(reinterpret_cast<char *>(&count), sizeof(uint32_t))) {
+    return {};
+  }
+  std::vector<page_id_t> page_ids(count);
+  if (!in.read(reinterpret_cast<char *>(page_ids.data()), count * sizeof(page_id_t))) {
+    return {};
+  }
+  return page_ids;
+}
+
+void BufferPoolManager::StartWarmUp(std::vector<page_id_t> page_ids) {
+  if (page_ids.empty() || warm_up_thread_.joinable()) {
+    return;
+  }
+  warm_up_thread_ = std::thread(&BufferPoolManager::WarmUpLoop, this, std::move(page_ids));
+}
+
+void BufferPoolManager::WarmUpLoop(std::vector<page_id_t> page_ids) {
+  // 缓冲池放不下时只保留最热的页
+  if (page_ids.size() > GetPoolSize()) {
+    page_ids.erase(page_ids.begin(), page_ids.end() - GetPoolSize());
+  }
+  // 逻辑页号越大物理页号越大，按页号排序即按磁盘上的顺序读取
+  std::vector<page_id_t> physical_order(page_ids);
+  std::sort(physical_order.begin(), physical_order.end());
+  for (size_t i = 0; i < physical_order.size(); i += IO_URING_QUEUE_DEPTH) {
+    if (IOWorkersStopped()) {
+      return;
+    }
+    size_t end = std::min<size_t>(i + IO_URING_QUEUE_DEPTH, physical_order.size());
+    PrefetchBatch(std::vector<page_id_t>(physical_order.begin() + i, physical_order.begin() + end));
+  }
+  // 由冷到热重新登记到replacer中，恢复替换顺序；读盘时登记的顺序是物理顺序
+  if (!IOWorkersStopped()) {
+    RestoreEvictionOrder(page_ids);
+  }
+}
+
+void BufferPoolManager::RestoreEvictionOrder(const std::vector<page_id_t> &page_ids) {
+  RestoreEvictionOrder(DEFAULT_FILE_ID, page_ids);
+}
+
+void BufferPoolManager::RestoreEvictionOrder(file_id_t file_id, const std::vector<page_id_t> &page_ids) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  for (auto page_id : page_ids) {
+    frame_id_t frame_id = page_table_.Find(file_id, page_id);
+    if (frame_id != INVALID_FRAME_ID && GetFrame(frame_id).pin_count_ == 0) {
+      std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+      replacer_->Reset(frame_id);
+      replacer_->Unpin(frame_id);
+    }
+  }
+}
+
+page_id_t BufferPoolManager::PrefetchPage(page_id_t page_id, NextPageIdFunc next_page_id) {
+  return PrefetchPage(DEFAULT_FILE_ID, page_id, next_page_id);
+}
+
+page_id_t BufferPoolManager::PrefetchPage(file_id_t file_id, page_id_t page_id, NextPageIdFunc next_page_id) {
+  DiskManager *disk_manager;
+  {
+    std::scoped_lock<std::recursive_mutex> lock(latch_);
+    frame_id_t frame_id = page_table_.Find(file_id, page_id);
+    if (frame_id != INVALID_FRAME_ID) {  // 已在内存中，只需沿链表继续
+      return next_page_id != nullptr ? next_page_id(&GetFrame(frame_id)) : INVALID_PAGE_ID;
+    }
+    disk_manager = GetDiskManager(file_id);
+    if (disk_manager->GetLocalPageId(page_id) == INVALID_PAGE_ID || disk_manager->IsPageFree(page_id)) {
+      return INVALID_PAGE_ID;
+    }
+    BeginPrefetchRead(file_id, page_id);
+  }
+  alignas(PAGE_SIZE) char data[PAGE_SIZE];
+  disk_manager->ReadPage(page_id, data);  // 不持有latch_读盘，其他请求不必等待
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  // 读盘期间该页可能已被载入、修改后写回或删除，读到的内容可能已过期；其他页的写回不影响该页
+  if (!EndPrefetchRead(file_id, page_id)) {
+    return INVALID_PAGE_ID;
+  }
+  Page *page = InstallPrefetchedPage(file_id, page_id, data);
+  return page != nullptr && next_page_id != nullptr ? next_page_id(page) : INVALID_PAGE_ID;
+}
+
+void BufferPoolManager::PrefetchBatch(const std::vector<page_id_t> &page_ids) {
+  PrefetchBatch(DEFAULT_FILE_ID, page_ids);
+}
+
+void BufferPoolManager::PrefetchBatch(file_id_t file_id, const std::vector<page_id_t> &page_ids) {
+  DiskManager *disk_manager;
+  std::vector<page_id_t> missing;
+  {
+    std::scoped_lock<std::recursive_mutex> lock(latch_);
+    disk_manager = GetDiskManager(file_id);
+    for (auto page_id : page_ids) {
+      if (disk_manager->GetLocalPageId(page_id) != INVALID_PAGE_ID && !disk_manager->IsPageFree(page_id) &&
+          page_table_.Find(file_id, page_id) == INVALID_FRAME_ID) {
+        BeginPrefetchRead(file_id, page_id);
+        missing.push_back(page_id);
+      }
+    }
+  }
+  if (missing.empty()) {
+    return;
+  }
+  PageBuffer buffer = AllocatePageBuffer(missing.size());
+  std::vector<PageIORequest> requests;
+  for (size_t i = 0; i < missing.size(); i++) {
+    requests.push_back({missing[i], buffer.get() + i * PAGE_SIZE});
+  }
+  disk_manager->ReadPages(requests);  // 不持有latch_，一次提交整批读请求
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  for (const auto &request : requests) {
+    // 逐页检查，只丢弃读盘期间被载入或删除的页
+    if (EndPrefetchRead(file_id, request.page_id_)) {
+      InstallPrefetchedPage(file_id, request.page_id_, request.data_);
+    }
+  }
+}
+
+Page *BufferPoolManager::InstallPrefetchedPage(file_id_t file_id, page_id_t page_id, const char *data) {
+  if (page_table_.Find(file_id, page_id) != INVALID_FRAME_ID) {
+    return nullptr;
+  }
+  frame_id_t frame_id = TryToFindFreePage();
+  if (frame_id == INVALID_FRAME_ID) {
+    return nullptr;
+  }
+  Page &page = GetFrame(frame_id);
+  memcpy(page.GetData(), data, PAGE_SIZE);
+  page.page_id_ = page_id;
+  page.file_id_ = file_id;
+  page.is_dirty_ = false;
+  page.pin_count_ = 0;
+  {
+    std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+    replacer_->Unpin(frame_id);  // 预读的页未被固定，可以被替换
+  }
+  page_table_.Insert(file_id, page_id, frame_id);
+  InvalidatePrefetchReads(file_id, page_id);  // 同一页的其他预读可能在该页被修改并写回后才完成
+  return &page;
+}
+
+void BufferPoolManager::BeginPrefetchRead(file_id_t file_id, page_id_t page_id) {
+  prefetch_reads_[PageTable::MakeKey(file_id, page_id)].readers_++;
+}
+
+bool BufferPoolManager::EndPrefetchRead(file_id_t file_id, page_id_t page_id) {
+  auto iter = prefetch_reads_.find(PageTable::MakeKey(file_id, page_id));
+  ASSERT(iter != prefetch_reads_.end(), "Prefetch read was not registered.");
+  bool valid = !iter->second.stale_;
+  if (--iter->second.readers_ == 0) {
+    prefetch_reads_.erase(iter);
+  }
+  return valid;
+}
+
+void BufferPoolManager::InvalidatePrefetchReads(file_id_t file_id, page_id_t page_id) {
+  if (prefetch_reads_.empty()) {
+    return;
+  }
+  auto iter = prefetch_reads_.find(PageTable::MakeKey(file_id, page_id));
+  if (iter != prefetch_reads_.end()) {
+    iter->second.stale_ = true;
+  }
+}
+
+file_id_t BufferPoolManager::AttachFile(DiskManager *disk_manager) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  for (size_t i = 0; i < files_.size(); i++) {
+    if (files_[i] == nullptr) {
+      files_[i] = disk_manager;
+      return i;
+    }
+  }
+  return INVALID_FILE_ID;
+}
+
+void BufferPoolManager::DetachFile(file_id_t file_id, bool write_back) {
+  for (int retry = 0;; retry++) {
+    std::scoped_lock<std::recursive_mutex> lock(latch_);
+    bool all_evicted = true;
+    std::vector<frame_id_t> evicted;
+    for (size_t i = 0; i < pool_size_; i++) {
+      Page &page = GetFrame(i);
+      if (page.page_id_ == INVALID_PAGE_ID || page.file_id_ != file_id) {
+        continue;
+      }
+      // 后台线程写回时会短暂pin住页，稍后重试；超时仍被pin住的页还在被调用者使用，不能丢弃其页帧
+      if (page.pin_count_ != 0) {
+        if (retry >= DETACH_FILE_RETRIES) {
+          LOG(FATAL) << "Detaching file " << file_id << " whose page " << page.page_id_ << " is still pinned "
+                     << page.pin_count_ << " times";
+        }
+        all_evicted = false;
+        continue;
+      }
+      evicted.push_back(i);
+    }
+    // 先成批写回脏页，再逐个替换出去；先清除脏标记，写回期间的修改会重新标记。文件将被删除时直接丢弃脏页
+    std::vector<frame_id_t> dirty;
+    for (auto frame_id : evicted) {
+      if (GetFrame(frame_id).IsDirty()) {
+        GetFrame(frame_id).is_dirty_ = false;
+        if (write_back) {
+          dirty.push_back(frame_id);
+        }
+      }
+    }
+    WriteBackFrames(dirty);
+    for (auto frame_id : evicted) {
+      if (EvictFrame(frame_id)) {
+        std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+        replacer_->Reset(frame_id);
+        free_list_.emplace_back(frame_id);
+      }
+    }
+    if (all_evicted) {
+      files_[file_id] = nullptr;
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+bool BufferPoolManager::Resize(size_t pool_size) {
+  if (pool_size == 0 || pool_size > static_cast<size_t>(BUFFER_POOL_CHUNK_PAGES) * MAX_BUFFER_POOL_CHUNKS) {
+    return false;
+  }
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  size_t old_pool_size = pool_size_;
+  if (pool_size == old_pool_size) {
+    return true;
+  }
+  if (pool_size < old_pool_size) {
+    // 只能移出可以被替换的页，NewPage返回的页在unpin之前不在replacer中，但仍在被使用
+    std::vector<bool> evictable(old_pool_size, false);
+    {
+      std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+      for (auto frame_id : replacer_->GetEvictionOrder()) {
+        evictable[frame_id] = true;
+      }
+    }
+    bool all_evicted = true;
+    for (size_t i = pool_size; i < old_pool_size; i++) {
+      if (GetFrame(i).page_id_ == INVALID_PAGE_ID) {
+        continue;  // 未绑定页的页帧都在空页链表中
+      }
+      if (!evictable[i] || !EvictFrame(i)) {
+        all_evicted = false;
+        continue;
+      }
+      {
+        std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+        replacer_->Reset(i);
+      }
+      free_list_.emplace_back(i);
+    }
+    if (!all_evicted) {
+      return false;  // 已经写回的页帧留在空页链表中，缓冲池大小不变
+    }
+    free_list_.remove_if([pool_size](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= pool_size; });
+    RemoveFrames(pool_size);
+  }
+  {
+    // replacer的容量是固定的，按新的大小重建，并按原来的顺序登记可以被替换的页
+    std::scoped_lock<std::mutex> replacer_lock(replacer_latch_);
+    Replacer *replacer = CreateReplacer(replacer_type_, pool_size);
+    for (auto frame_id : replacer_->GetEvictionOrder()) {
+      if (static_cast<size_t>(frame_id) < pool_size && GetFrame(frame_id).page_id_ != INVALID_PAGE_ID) {
+        replacer->Unpin(frame_id);
+      }
+    }
+    delete replacer_;
+    replacer_ = replacer;
+  }
+  high_watermark_ = std::min<size_t>(high_watermark_, pool_size);
+  if (pool_size > old_pool_size) {
+    try {
+      AddFrames(pool_size);
+    } catch (std::bad_alloc &) {
+      return false;  // 已经加入的页帧仍可使用
+    }
+  }
+  return true;
+}
+
+void BufferPoolManager::AddFrames(size_t pool_size) {
+  for (size_t i = pool_size_; i < pool_size; i++) {
+    size_t chunk_index = i / BUFFER_POOL_CHUNK_PAGES;
+    if (chunks_[chunk_index].pages_ == nullptr) {
+      AllocateChunk(chunk_index, pool_size >= (chunk_index + 1) * BUFFER_POOL_CHUNK_PAGES);
+    }
+    FrameChunk &chunk = chunks_[chunk_index];
+    size_t offset = i % BUFFER_POOL_CHUNK_PAGES;
+    new (&chunk.pages_[offset]) Page(chunk.data_ + offset * PAGE_SIZE);
+    free_list_.emplace_back(i);
+    pool_size_ = i + 1;
+  }
+}
+
+void BufferPoolManager::RemoveFrames(size_t pool_size) {
+  size_t old_pool_size = pool_size_;
+  if (pool_size >= old_pool_size) {
+    return;
+  }
+  pool_size_ = pool_size;
+  for (size_t i = pool_size; i < old_pool_size; i++) {
+    GetFrame(i).~Page();
+  }
+  // 整个被移除的chunk直接释放，部分保留的chunk中被移除页帧的内存还给系统，再次使用时读到的是全零的页
+  size_t first_removed_chunk = (pool_size + BUFFER_POOL_CHUNK_PAGES - 1) / BUFFER_POOL_CHUNK_PAGES;
+  size_t end_chunk = (old_pool_size + BUFFER_POOL_CHUNK_PAGES - 1) / BUFFER_POOL_CHUNK_PAGES;
+  if (pool_size % BUFFER_POOL_CHUNK_PAGES != 0) {
+    FrameChunk &chunk = chunks_[pool_size / BUFFER_POOL_CHUNK_PAGES];
+    size_t end = std::min<size_t>(old_pool_size, first_removed_chunk * BUFFER_POOL_CHUNK_PAGES);
+    madvise(chunk.data_ + (pool_size % BUFFER_POOL_CHUNK_PAGES) * PAGE_SIZE, (end - pool_size) * PAGE_SIZE,
+            MADV_DONTNEED);
+  }
+  for (size_t i = first_removed_chunk; i < end_chunk; i++) {
+    FrameChunk &chunk = chunks_[i];
+    ::operator delete(chunk.pages_, std::align_val_t(alignof(Page)));
+    munmap(chunk.mapping_, chunk.mapping_size_);
+    chunk = FrameChunk();
+  }
+}
+
+void BufferPoolManager::AllocateChunk(size_t chunk_index, bool full) {
+  FrameChunk &chunk = chunks_[chunk_index];
+  size_t data_size = static_cast<size_t>(BUFFER_POOL_CHUNK_PAGES) * PAGE_SIZE;
+  bool huge_pages = BUFFER_POOL_HUGE_PAGES && full && data_size >= HUGE_PAGE_SIZE;
+  // 为整个chunk预留地址空间，只有用到的页帧才占用内存；多映射一个大页的长度，使数据可以按大页对齐；匿名映射的内存已清零
+  chunk.mapping_size_ = data_size + (huge_pages ? HUGE_PAGE_SIZE : 0);
+  chunk.mapping_ =
+      mmap(nullptr, chunk.mapping_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (chunk.mapping_ == MAP_FAILED) {
+    chunk = FrameChunk();
+    throw std::bad_alloc();
+  }
+  auto address = reinterpret_cast<uintptr_t>(chunk.mapping_);
+  if (huge_pages) {
+    address = (address + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MADV_HUGEPAGE
+    madvise(reinterpret_cast<void *>(address), data_size, MADV_HUGEPAGE);  // 只是提示，失败时仍使用普通页
+#endif
+  }
+  chunk.data_ = reinterpret_cast<char *>(address);
+  // 页描述符连续存放，每个按cache line对齐，数据指向chunk中对应的页帧
+  chunk.pages_ = static_cast<Page *>(
+      ::operator new(BUFFER_POOL_CHUNK_PAGES * sizeof(Page), std::align_val_t(alignof(Page))));
+}
+
+Replacer *BufferPoolManager::CreateReplacer(ReplacerType replacer_type, size_t num_pages) {
+  switch (replacer_type) {
+    case ReplacerType::CLOCK:
+      return new CLOCKReplacer(num_pages);
+    case ReplacerType::LRU_K:
+      return new LRUKReplacer(num_pages);
+    case ReplacerType::LRU:
+    default:
+      return new LRUReplacer(num_pages);
+  }
+}
+
 page_id_t BufferPoolManager::AllocatePage() {
   int next_page_id = disk_manager_->AllocatePage();
   return next_page_id;
 }
 
+page_id_t BufferPoolManager::AllocatePageNear(page_id_t near_page_id) {
+  return disk_manager_->AllocatePageNear(near_page_id);
+}
+
 void BufferPoolManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  InvalidatePrefetchReads(DEFAULT_FILE_ID, page_id);
   disk_manager_->DeAllocatePage(page_id);
 }
 
 bool BufferPoolManager::IsPageFree(page_id_t page_id) { return disk_manager_->IsPageFree(page_id); }
 
 // Only used for debug
-bool BufferPoolManager::CheckAllUnpinned() {
+bool BufferPoolManager::CheckAllUnpinned() { return CheckAllUnpinned(DEFAULT_FILE_ID); }
+
+bool BufferPoolManager::CheckAllUnpinned(file_id_t file_id) {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
   bool res = true;
   for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].pin_count_ != 0) {
+    if (GetFrame(i).pin_count_ != 0 && GetFrame(i).file_id_ == file_id) {
       res = false;
-      std::cerr << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << std::endl;
+      std::cerr << "page " << GetFrame(i).page_id_ << " pin count:" << GetFrame(i).pin_count_ << std::endl;
     }
   }
   return res;
-}
\ No newline at end of file
+}
@@ -68,4 +68,18 @@ size_t CLOCKReplacer::Size() {
 void CLOCKReplacer::Reset(frame_id_t frame_id) {
   frames_[frame_id].first = false;
   frames_[frame_id].second = false;
-}
\ No newline at end of file
+}
+
+std::vector<frame_id_t> CLOCKReplacer::GetEvictionOrder() {
+  // 从时钟指针开始，先是没有第二次机会的页，再是有第二次机会的页
+  std::vector<frame_id_t> order;
+  for (bool second_chance : {false, true}) {
+    for (size_t i = 0; i < frames_.size(); i++) {
+      size_t frame_id = (clock_hand_ + i) % frames_.size();
+      if (frames_[frame_id].first && frames_[frame_id].second == second_chance) {
+        order.push_back(frame_id);
+      }
+    }
+  }
+  return order;
+}
@@ -0,0 +1,88 @@
+#include "buffer/lru_k_replacer.h"
+
+#include <algorithm>
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k) : k_(k), history_(num_pages), is_evictable_(num_pages, false) {
+  ASSERT(k_ > 0, "LRU-K replacer needs k > 0.");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  *frame_id = INVALID_FRAME_ID;
+  bool victim_infinite = false;
+  uint64_t victim_timestamp = UINT64_MAX;
+  for (size_t i = 0; i < history_.size(); i++) {
+    if (!is_evictable_[i]) {
+      continue;
+    }
+    // front() is the earliest remembered access, i.e. the k-th most recent one if the frame has k accesses
+    bool infinite = history_[i].size() < k_;
+    uint64_t timestamp = history_[i].front();
+    if ((infinite && !victim_infinite) || (infinite == victim_infinite && timestamp < victim_timestamp)) {
+      victim_infinite = infinite;
+      victim_timestamp = timestamp;
+      *frame_id = static_cast<frame_id_t>(i);
+    }
+  }
+  if (*frame_id == INVALID_FRAME_ID) {
+    return false;
+  }
+  Reset(*frame_id);
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  RecordAccess(frame_id);
+  if (is_evictable_[frame_id]) {
+    is_evictable_[frame_id] = false;
+    evictable_size_--;
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  if (history_[frame_id].empty()) {
+    RecordAccess(frame_id);
+  }
+  if (!is_evictable_[frame_id]) {
+    is_evictable_[frame_id] = true;
+    evictable_size_++;
+  }
+}
+
+size_t LRUKReplacer::Size() { return evictable_size_; }
+
+std::vector<frame_id_t> LRUKReplacer::GetEvictionOrder() {
+  std::vector<frame_id_t> order;
+  for (size_t i = 0; i < history_.size(); i++) {
+    if (is_evictable_[i]) {
+      order.push_back(static_cast<frame_id_t>(i));
+    }
+  }
+  // same order as Victim: infinite backward k-distance first, then the earliest remembered access
+  std::stable_sort(order.begin(), order.end(), [this](frame_id_t a, frame_id_t b) {
+    bool a_infinite = history_[a].size() < k_;
+    bool b_infinite = history_[b].size() < k_;
+    if (a_infinite != b_infinite) {
+      return a_infinite;
+    }
+    return history_[a].front() < history_[b].front();
+  });
+  return order;
+}
+
+void LRUKReplacer::Reset(frame_id_t frame_id) {
+  if (is_evictable_[frame_id]) {
+    is_evictable_[frame_id] = false;
+    evictable_size_--;
+  }
+  history_[frame_id].clear();
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  auto &history = history_[frame_id];
+  history.push_back(current_timestamp_++);
+  if (history.size() > k_) {
+    history.pop_front();
+  }
+}
@@ -1,4 +1,6 @@
 #include "buffer/lru_replacer.h"
+#include <algorithm>
+
 #include "common/config.h"
 
 LRUReplacer::LRUReplacer(size_t num_pages) {
@@ -76,6 +78,18 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
 size_t LRUReplacer::Size() { return number_unpined_frame; }
 
 void LRUReplacer::Reset(frame_id_t frame_id) {
+  if (frame_used[frame_id] != -1 && !frame_isPin[frame_id]) number_unpined_frame--;  // 可替换页被清除
   frame_used[frame_id] = -1;
   frame_isPin[frame_id] = true;
 }
+
+std::vector<frame_id_t> LRUReplacer::GetEvictionOrder() {
+  std::vector<frame_id_t> order;
+  for (int i = 0; i < replacer_size; i++) {
+    if (frame_used[i] != -1 && !frame_isPin[i]) order.push_back(i);
+  }
+  // 与Victim一致：访问次数少的先被替换，次数相同时页帧号小的先被替换
+  std::stable_sort(order.begin(), order.end(),
+                   [this](frame_id_t a, frame_id_t b) { return frame_used[a] < frame_used[b]; });
+  return order;
+}
@@ -0,0 +1,200 @@
+#include "buffer/parallel_buffer_pool_manager.h"
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                                                     DiskManager *disk_manager, ReplacerType replacer_type)
+    : BufferPoolManager(disk_manager) {
+  ASSERT(num_instances > 0, "Buffer pool needs at least one instance.");
+  size_t instance_size = (pool_size + num_instances - 1) / num_instances;
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.emplace_back(new BufferPoolManager(instance_size, disk_manager, replacer_type));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  StopIOWorkers();
+  for (auto instance : instances_) {
+    delete instance;
+  }
+}
+
+BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
+  return instances_[static_cast<size_t>(page_id) % instances_.size()];
+}
+
+Page *ParallelBufferPoolManager::FetchPage(page_id_t page_id) {
+  if (page_id <= INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+  if (page_id <= INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, strategy);
+}
+
+bool ParallelBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  if (page_id <= INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPage(page_id_t page_id) {
+  if (page_id <= INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPages() {
+  for (auto instance : instances_) {
+    instance->WriteBackDirtyPages(INVALID_FILE_ID);
+  }
+  disk_manager_->Sync();
+}
+
+Page *ParallelBufferPoolManager::NewPage(page_id_t &page_id) {
+  std::scoped_lock<std::mutex> lock(allocate_latch_);
+  page_id = AllocatePage();
+  return NewPageInShard(page_id);
+}
+
+Page *ParallelBufferPoolManager::NewPageNear(page_id_t &page_id, page_id_t near_page_id) {
+  std::scoped_lock<std::mutex> lock(allocate_latch_);
+  page_id = AllocatePageNear(near_page_id);
+  return NewPageInShard(page_id);
+}
+
+Page *ParallelBufferPoolManager::NewPageInShard(page_id_t &page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  Page *page = GetBufferPoolManager(page_id)->NewPageWithId(DEFAULT_FILE_ID, page_id);
+  if (page == nullptr) {
+    // the owning shard is full of pinned pages, give the page back to disk
+    DeallocatePage(page_id);
+    page_id = INVALID_PAGE_ID;
+  }
+  return page;
+}
+
+page_id_t ParallelBufferPoolManager::PrefetchPage(page_id_t page_id, NextPageIdFunc next_page_id) {
+  return GetBufferPoolManager(page_id)->PrefetchPage(page_id, next_page_id);
+}
+
+void ParallelBufferPoolManager::PrefetchBatch(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> instance_page_ids(instances_.size());
+  for (auto page_id : page_ids) {
+    if (page_id > INVALID_PAGE_ID) {
+      instance_page_ids[static_cast<size_t>(page_id) % instances_.size()].push_back(page_id);
+    }
+  }
+  for (size_t i = 0; i < instances_.size(); i++) {
+    if (!instance_page_ids[i].empty()) {
+      instances_[i]->PrefetchBatch(instance_page_ids[i]);
+    }
+  }
+}
+
+bool ParallelBufferPoolManager::DeletePage(page_id_t page_id) {
+  if (page_id <= INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+Page *ParallelBufferPoolManager::RelocatePage(page_id_t page_id, page_id_t &new_page_id) {
+  new_page_id = INVALID_PAGE_ID;
+  if (page_id <= INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  std::scoped_lock<std::mutex> lock(allocate_latch_);
+  BufferPoolManager *instance = GetBufferPoolManager(page_id);
+  Page *old_page = instance->FetchPage(page_id);
+  if (old_page == nullptr) {
+    return nullptr;
+  }
+  page_id_t target = disk_manager_->AllocatePageBelow(page_id);
+  Page *new_page = NewPageInShard(target);
+  if (new_page == nullptr) {
+    instance->UnpinPage(page_id, false);
+    return nullptr;
+  }
+  memcpy(new_page->GetData(), old_page->GetData(), PAGE_SIZE);
+  new_page->is_dirty_ = true;  // the old page is deleted, the copy is the only one
+  instance->UnpinPage(page_id, false);
+  if (!instance->DeletePage(page_id)) {
+    // the old page is still in use, it can not move
+    GetBufferPoolManager(target)->DeletePage(target);
+    return nullptr;
+  }
+  new_page_id = target;
+  return new_page;
+}
+
+bool ParallelBufferPoolManager::CheckAllUnpinned() {
+  bool res = true;
+  for (auto instance : instances_) {
+    res = instance->CheckAllUnpinned() && res;
+  }
+  return res;
+}
+
+size_t ParallelBufferPoolManager::GetPoolSize() {
+  size_t pool_size = 0;
+  for (auto instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+bool ParallelBufferPoolManager::Resize(size_t pool_size) {
+  size_t num_instances = instances_.size();
+  if (pool_size < num_instances) {
+    return false;
+  }
+  for (auto instance : instances_) {
+    if (!instance->Resize((pool_size + num_instances - 1) / num_instances)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ParallelBufferPoolManager::StartBackgroundWriter(size_t low_watermark, size_t high_watermark) {
+  size_t num_instances = instances_.size();
+  for (auto instance : instances_) {
+    instance->StartBackgroundWriter((low_watermark + num_instances - 1) / num_instances,
+                                    (high_watermark + num_instances - 1) / num_instances);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundWriter() {
+  for (auto instance : instances_) {
+    instance->StopBackgroundWriter();
+  }
+}
+
+std::vector<page_id_t> ParallelBufferPoolManager::GetResidentPageIds() {
+  std::vector<page_id_t> page_ids;
+  for (auto instance : instances_) {
+    std::vector<page_id_t> instance_page_ids = instance->GetResidentPageIds();
+    page_ids.insert(page_ids.end(), instance_page_ids.begin(), instance_page_ids.end());
+  }
+  return page_ids;
+}
+
+void ParallelBufferPoolManager::StartWarmUp(std::vector<page_id_t> page_ids) {
+  std::vector<std::vector<page_id_t>> instance_page_ids(instances_.size());
+  for (auto page_id : page_ids) {
+    if (page_id > INVALID_PAGE_ID) {
+      instance_page_ids[static_cast<size_t>(page_id) % instances_.size()].push_back(page_id);
+    }
+  }
+  for (size_t i = 0; i < instances_.size(); i++) {
+    instances_[i]->StartWarmUp(std::move(instance_page_ids[i]));
+  }
+}
@@ -0,0 +1,136 @@
+#include "buffer/read_only_buffer_pool_manager.h"
+
+#include <sys/mman.h>
+
+#include <stdexcept>
+
+ReadOnlyBufferPoolManager::ReadOnlyBufferPoolManager(DiskManager *disk_manager)
+    : BufferPoolManager(disk_manager), pages_(disk_manager->GetFileSize() / PAGE_SIZE) {
+  if (!disk_manager->IsReadOnly()) {
+    throw std::invalid_argument("The database file is not opened in read-only mode.");
+  }
+  if (disk_manager->IsCompressed()) {
+    throw std::invalid_argument("The pages of a compressed database file can not be mapped.");
+  }
+}
+
+ReadOnlyBufferPoolManager::~ReadOnlyBufferPoolManager() {
+  // I/O线程会访问页的描述符，先停止它们
+  StopIOWorkers();
+  for (auto &page : pages_) {
+    delete page.load();
+  }
+}
+
+Page *ReadOnlyBufferPoolManager::FetchPage(page_id_t page_id) {
+  Page *page = GetPage(page_id);
+  if (page != nullptr) {
+    page->pin_count_++;
+  }
+  return page;
+}
+
+Page *ReadOnlyBufferPoolManager::FetchPage(page_id_t page_id,
+                                           __attribute__((unused)) BufferAccessStrategy *strategy) {
+  return FetchPage(page_id);
+}
+
+bool ReadOnlyBufferPoolManager::UnpinPage(page_id_t page_id, __attribute__((unused)) bool is_dirty) {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= pages_.size()) {
+    return false;
+  }
+  Page *page = pages_[page_id].load(std::memory_order_acquire);
+  if (page == nullptr) {
+    return false;
+  }
+  int pin_count = page->pin_count_;
+  while (pin_count > 0 && !page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1)) {
+  }
+  return pin_count > 0;
+}
+
+bool ReadOnlyBufferPoolManager::FlushPage(__attribute__((unused)) page_id_t page_id) { return false; }
+
+void ReadOnlyBufferPoolManager::FlushAllPages() {}
+
+Page *ReadOnlyBufferPoolManager::NewPage(page_id_t &page_id) {
+  page_id = INVALID_PAGE_ID;
+  return nullptr;
+}
+
+Page *ReadOnlyBufferPoolManager::NewPageNear(page_id_t &page_id, __attribute__((unused)) page_id_t near_page_id) {
+  return NewPage(page_id);
+}
+
+bool ReadOnlyBufferPoolManager::DeletePage(__attribute__((unused)) page_id_t page_id) { return false; }
+
+Page *ReadOnlyBufferPoolManager::RelocatePage(__attribute__((unused)) page_id_t page_id, page_id_t &new_page_id) {
+  new_page_id = INVALID_PAGE_ID;
+  return nullptr;
+}
+
+bool ReadOnlyBufferPoolManager::CheckAllUnpinned() {
+  bool res = true;
+  for (auto &entry : pages_) {
+    Page *page = entry.load(std::memory_order_acquire);
+    if (page != nullptr && page->pin_count_ != 0) {
+      res = false;
+      std::cerr << "page " << page->page_id_ << " pin count:" << page->pin_count_ << std::endl;
+    }
+  }
+  return res;
+}
+
+bool ReadOnlyBufferPoolManager::Resize(__attribute__((unused)) size_t pool_size) { return false; }
+
+void ReadOnlyBufferPoolManager::StartBackgroundWriter(__attribute__((unused)) size_t low_watermark,
+                                                      __attribute__((unused)) size_t high_watermark) {}
+
+void ReadOnlyBufferPoolManager::StopBackgroundWriter() {}
+
+std::vector<page_id_t> ReadOnlyBufferPoolManager::GetResidentPageIds() { return {}; }
+
+void ReadOnlyBufferPoolManager::StartWarmUp(__attribute__((unused)) std::vector<page_id_t> page_ids) {}
+
+page_id_t ReadOnlyBufferPoolManager::PrefetchPage(page_id_t page_id, NextPageIdFunc next_page_id) {
+  Page *page = FetchPage(page_id);
+  if (page == nullptr) {
+    return INVALID_PAGE_ID;
+  }
+  page_id_t next = (next_page_id == nullptr ? INVALID_PAGE_ID : next_page_id(page));
+  UnpinPage(page_id, false);
+  return next;
+}
+
+void ReadOnlyBufferPoolManager::PrefetchBatch(const std::vector<page_id_t> &page_ids) {
+  for (auto page_id : page_ids) {
+    char *data = (page_id < 0 ? nullptr : disk_manager_->GetMappedPage(page_id));
+    if (data != nullptr) {
+      madvise(data, PAGE_SIZE, MADV_WILLNEED);
+    }
+  }
+}
+
+void ReadOnlyBufferPoolManager::RestoreEvictionOrder(__attribute__((unused)) const std::vector<page_id_t> &page_ids) {}
+
+Page *ReadOnlyBufferPoolManager::GetPage(page_id_t page_id) {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= pages_.size()) {
+    return nullptr;
+  }
+  Page *page = pages_[page_id].load(std::memory_order_acquire);
+  if (page != nullptr) {
+    return page;
+  }
+  char *data = disk_manager_->GetMappedPage(page_id);
+  if (data == nullptr) {
+    return nullptr;
+  }
+  // 并发地首次访问同一页时只保留一个描述符
+  auto *created = new Page(data);
+  created->page_id_ = page_id;
+  if (pages_[page_id].compare_exchange_strong(page, created, std::memory_order_acq_rel)) {
+    return created;
+  }
+  delete created;
+  return page;
+}
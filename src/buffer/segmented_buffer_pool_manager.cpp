@@ -0,0 +1,322 @@
+#include "buffer/segmented_buffer_pool_manager.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+#include "glog/logging.h"
+
+SegmentedBufferPoolManager::SegmentedBufferPoolManager(size_t pool_size, DiskManager *disk_manager,
+                                                       ReplacerType replacer_type)
+    : BufferPoolManager(disk_manager),
+      owned_pool_(std::make_unique<BufferPoolManager>(pool_size, disk_manager, replacer_type)),
+      pool_(owned_pool_.get()),
+      segments_(MAX_SEGMENTS),
+      file_ids_(MAX_SEGMENTS, INVALID_FILE_ID) {
+  file_ids_[MAIN_SEGMENT_ID] = DEFAULT_FILE_ID;
+  OpenSegments();
+}
+
+SegmentedBufferPoolManager::SegmentedBufferPoolManager(BufferPoolManager *shared_pool, DiskManager *disk_manager)
+    : BufferPoolManager(disk_manager),
+      pool_(shared_pool),
+      segments_(MAX_SEGMENTS),
+      file_ids_(MAX_SEGMENTS, INVALID_FILE_ID) {
+  file_ids_[MAIN_SEGMENT_ID] = shared_pool->AttachFile(disk_manager);
+  if (file_ids_[MAIN_SEGMENT_ID] == INVALID_FILE_ID) {
+    throw std::length_error("Too many files attached to the shared buffer pool.");
+  }
+  OpenSegments();
+}
+
+SegmentedBufferPoolManager::~SegmentedBufferPoolManager() {
+  // 先停止预读和预热线程，之后不会再有读取这些文件的请求
+  StopIOWorkers();
+  for (segment_id_t i = 0; i < MAX_SEGMENTS; i++) {
+    // 自有的缓冲池析构时写回主文件的页，共享的缓冲池则要把主文件也卸下
+    if (file_ids_[i] != INVALID_FILE_ID && (i != MAIN_SEGMENT_ID || owned_pool_ == nullptr)) {
+      pool_->DetachFile(file_ids_[i]);
+    }
+  }
+}
+
+void SegmentedBufferPoolManager::OpenSegments() {
+  std::unique_lock<std::shared_mutex> lock(segment_latch_);
+  try {
+    for (segment_id_t i = MAIN_SEGMENT_ID + 1; i < MAX_SEGMENTS; i++) {
+      if (std::filesystem::exists(GetSegmentFileName(disk_manager_->GetFileName(), i)) && !AttachSegment(i)) {
+        throw std::length_error("Too many files attached to the buffer pool.");
+      }
+    }
+  } catch (...) {
+    // 析构函数不会执行，卸下已挂载的文件
+    for (segment_id_t i = 0; i < MAX_SEGMENTS; i++) {
+      if (file_ids_[i] != INVALID_FILE_ID && (i != MAIN_SEGMENT_ID || owned_pool_ == nullptr)) {
+        pool_->DetachFile(file_ids_[i]);
+      }
+    }
+    throw;
+  }
+}
+
+bool SegmentedBufferPoolManager::AttachSegment(segment_id_t segment_id) {
+  // 段文件沿用主文件的选项，已有文件的格式记录在它自己的meta page中
+  auto disk_manager =
+      std::make_unique<DiskManager>(GetSegmentFileName(disk_manager_->GetFileName(), segment_id),
+                                    disk_manager_->IsDirectIO(), false, disk_manager_->IsCompressed(), segment_id);
+  file_id_t file_id = pool_->AttachFile(disk_manager.get());
+  if (file_id == INVALID_FILE_ID) {
+    return false;
+  }
+  segments_[segment_id] = std::move(disk_manager);
+  file_ids_[segment_id] = file_id;
+  return true;
+}
+
+file_id_t SegmentedBufferPoolManager::GetFileId(page_id_t page_id) {
+  // 无效的页号交给主文件处理
+  segment_id_t segment_id = (page_id < 0 ? MAIN_SEGMENT_ID : DiskManager::SegmentOf(page_id));
+  std::shared_lock<std::shared_mutex> lock(segment_latch_);
+  return file_ids_[segment_id];
+}
+
+std::vector<file_id_t> SegmentedBufferPoolManager::GetFileIds() {
+  std::shared_lock<std::shared_mutex> lock(segment_latch_);
+  std::vector<file_id_t> file_ids;
+  for (auto file_id : file_ids_) {
+    if (file_id != INVALID_FILE_ID) {
+      file_ids.push_back(file_id);
+    }
+  }
+  return file_ids;
+}
+
+Page *SegmentedBufferPoolManager::FetchPage(page_id_t page_id) { return FetchPage(page_id, nullptr); }
+
+Page *SegmentedBufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+  file_id_t file_id = GetFileId(page_id);
+  return file_id == INVALID_FILE_ID ? nullptr : pool_->FetchPage(file_id, page_id, strategy);
+}
+
+bool SegmentedBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  file_id_t file_id = GetFileId(page_id);
+  return file_id != INVALID_FILE_ID && pool_->UnpinPage(file_id, page_id, is_dirty);
+}
+
+bool SegmentedBufferPoolManager::FlushPage(page_id_t page_id) {
+  file_id_t file_id = GetFileId(page_id);
+  return file_id != INVALID_FILE_ID && pool_->FlushPage(file_id, page_id);
+}
+
+void SegmentedBufferPoolManager::FlushAllPages() {
+  for (auto file_id : GetFileIds()) {
+    pool_->WriteBackDirtyPages(file_id);
+  }
+  disk_manager_->Sync();
+  std::shared_lock<std::shared_mutex> lock(segment_latch_);
+  for (auto &segment : segments_) {
+    if (segment != nullptr) {
+      segment->Sync();
+    }
+  }
+}
+
+Page *SegmentedBufferPoolManager::NewPage(page_id_t &page_id) {
+  // 主文件在构造时挂载，直到析构都不会改变
+  return pool_->NewPage(file_ids_[MAIN_SEGMENT_ID], page_id);
+}
+
+Page *SegmentedBufferPoolManager::NewPageNear(page_id_t &page_id, page_id_t near_page_id) {
+  file_id_t file_id = GetFileId(near_page_id);
+  if (file_id == INVALID_FILE_ID) {
+    page_id = INVALID_PAGE_ID;
+    return nullptr;
+  }
+  return pool_->NewPageNear(file_id, page_id, near_page_id);
+}
+
+Page *SegmentedBufferPoolManager::NewPageInSegment(segment_id_t segment_id, page_id_t &page_id) {
+  file_id_t file_id = INVALID_FILE_ID;
+  if (segment_id < MAX_SEGMENTS) {
+    std::shared_lock<std::shared_mutex> lock(segment_latch_);
+    file_id = file_ids_[segment_id];
+  }
+  if (file_id == INVALID_FILE_ID) {
+    page_id = INVALID_PAGE_ID;
+    return nullptr;
+  }
+  return pool_->NewPageNear(file_id, page_id, INVALID_PAGE_ID);
+}
+
+segment_id_t SegmentedBufferPoolManager::CreateSegment() {
+  std::unique_lock<std::shared_mutex> lock(segment_latch_);
+  for (segment_id_t i = MAIN_SEGMENT_ID + 1; i < MAX_SEGMENTS; i++) {
+    if (segments_[i] != nullptr) {
+      continue;
+    }
+    std::string file_name = GetSegmentFileName(disk_manager_->GetFileName(), i);
+    try {
+      if (AttachSegment(i)) {
+        return i;
+      }
+    } catch (std::exception &) {
+      LOG(WARNING) << "Failed to create segment file " << file_name;
+    }
+    remove(file_name.c_str());
+    break;
+  }
+  return MAIN_SEGMENT_ID;  // 段已用完，放到主文件中
+}
+
+bool SegmentedBufferPoolManager::DropSegment(segment_id_t segment_id) {
+  if (segment_id == MAIN_SEGMENT_ID || segment_id >= MAX_SEGMENTS) {
+    return false;
+  }
+  file_id_t file_id;
+  std::string file_name;
+  {
+    std::unique_lock<std::shared_mutex> lock(segment_latch_);
+    file_id = file_ids_[segment_id];
+    if (file_id == INVALID_FILE_ID) {
+      return false;
+    }
+    // 不再把请求路由到该段；磁盘管理器保留到文件删除之后，在此之前该段号不会被重新分配
+    file_ids_[segment_id] = INVALID_FILE_ID;
+    file_name = segments_[segment_id]->GetFileName();
+  }
+  pool_->DetachFile(file_id, false);
+  if (remove(file_name.c_str()) != 0) {
+    LOG(WARNING) << "Failed to remove segment file " << file_name;
+  }
+  std::unique_lock<std::shared_mutex> lock(segment_latch_);
+  segments_[segment_id].reset();
+  return true;
+}
+
+bool SegmentedBufferPoolManager::DeletePage(page_id_t page_id) {
+  file_id_t file_id = GetFileId(page_id);
+  return file_id != INVALID_FILE_ID && pool_->DeletePage(file_id, page_id);
+}
+
+Page *SegmentedBufferPoolManager::RelocatePage(page_id_t page_id, page_id_t &new_page_id) {
+  file_id_t file_id = GetFileId(page_id);
+  if (file_id == INVALID_FILE_ID) {
+    new_page_id = INVALID_PAGE_ID;
+    return nullptr;
+  }
+  return pool_->RelocatePage(file_id, page_id, new_page_id);
+}
+
+void SegmentedBufferPoolManager::TruncateFiles() {
+  for (auto file_id : GetFileIds()) {
+    pool_->WriteBackDirtyPages(file_id);
+  }
+  disk_manager_->TruncateFile();
+  std::shared_lock<std::shared_mutex> lock(segment_latch_);
+  for (auto &segment : segments_) {
+    if (segment != nullptr) {
+      segment->TruncateFile();
+    }
+  }
+}
+
+bool SegmentedBufferPoolManager::IsPageFree(page_id_t page_id) {
+  if (page_id < 0 || DiskManager::SegmentOf(page_id) == MAIN_SEGMENT_ID) {
+    return disk_manager_->IsPageFree(page_id);
+  }
+  std::shared_lock<std::shared_mutex> lock(segment_latch_);
+  DiskManager *segment = segments_[DiskManager::SegmentOf(page_id)].get();
+  return segment != nullptr && segment->IsPageFree(page_id);
+}
+
+bool SegmentedBufferPoolManager::CheckAllUnpinned() {
+  bool res = true;
+  for (auto file_id : GetFileIds()) {
+    res = pool_->CheckAllUnpinned(file_id) && res;
+  }
+  return res;
+}
+
+bool SegmentedBufferPoolManager::Resize(size_t pool_size) {
+  return owned_pool_ != nullptr && owned_pool_->Resize(pool_size);
+}
+
+void SegmentedBufferPoolManager::StartBackgroundWriter(size_t low_watermark, size_t high_watermark) {
+  if (owned_pool_ != nullptr) {
+    owned_pool_->StartBackgroundWriter(low_watermark, high_watermark);
+  }
+}
+
+void SegmentedBufferPoolManager::StopBackgroundWriter() {
+  if (owned_pool_ != nullptr) {
+    owned_pool_->StopBackgroundWriter();
+  }
+}
+
+std::vector<page_id_t> SegmentedBufferPoolManager::GetResidentPageIds() {
+  std::vector<page_id_t> page_ids;
+  for (auto file_id : GetFileIds()) {
+    std::vector<page_id_t> file_page_ids = pool_->GetResidentPageIds(file_id);
+    page_ids.insert(page_ids.end(), file_page_ids.begin(), file_page_ids.end());
+  }
+  return page_ids;
+}
+
+std::string SegmentedBufferPoolManager::GetSegmentFileName(const std::string &db_file, segment_id_t segment_id) {
+  return db_file + ".seg" + std::to_string(segment_id);
+}
+
+void SegmentedBufferPoolManager::RemoveSegmentFiles(const std::string &db_file) {
+  for (segment_id_t i = MAIN_SEGMENT_ID + 1; i < MAX_SEGMENTS; i++) {
+    remove(GetSegmentFileName(db_file, i).c_str());
+  }
+}
+
+bool SegmentedBufferPoolManager::HasSegmentFiles(const std::string &db_file) {
+  for (segment_id_t i = MAIN_SEGMENT_ID + 1; i < MAX_SEGMENTS; i++) {
+    if (std::filesystem::exists(GetSegmentFileName(db_file, i))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+page_id_t SegmentedBufferPoolManager::PrefetchPage(page_id_t page_id, NextPageIdFunc next_page_id) {
+  file_id_t file_id = GetFileId(page_id);
+  return file_id == INVALID_FILE_ID ? INVALID_PAGE_ID : pool_->PrefetchPage(file_id, page_id, next_page_id);
+}
+
+void SegmentedBufferPoolManager::PrefetchBatch(const std::vector<page_id_t> &page_ids) {
+  std::map<file_id_t, std::vector<page_id_t>> batches;
+  for (auto page_id : page_ids) {
+    file_id_t file_id = GetFileId(page_id);
+    if (file_id != INVALID_FILE_ID) {
+      batches[file_id].push_back(page_id);
+    }
+  }
+  for (const auto &batch : batches) {
+    pool_->PrefetchBatch(batch.first, batch.second);
+  }
+}
+
+void SegmentedBufferPoolManager::RestoreEvictionOrder(const std::vector<page_id_t> &page_ids) {
+  // 按原顺序把同一文件的连续页一起交给replacer，保持整体的替换顺序
+  std::vector<page_id_t> run;
+  file_id_t run_file_id = INVALID_FILE_ID;
+  for (auto page_id : page_ids) {
+    file_id_t file_id = GetFileId(page_id);
+    if (file_id != run_file_id && !run.empty()) {
+      pool_->RestoreEvictionOrder(run_file_id, run);
+      run.clear();
+    }
+    run_file_id = file_id;
+    if (file_id != INVALID_FILE_ID) {
+      run.push_back(page_id);
+    }
+  }
+  if (!run.empty()) {
+    pool_->RestoreEvictionOrder(run_file_id, run);
+  }
+}
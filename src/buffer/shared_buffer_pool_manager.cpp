@@ -0,0 +1,74 @@
+#include "buffer/shared_buffer_pool_manager.h"
+
+#include <stdexcept>
+
+SharedBufferPoolManager::SharedBufferPoolManager(BufferPoolManager *shared_pool, DiskManager *disk_manager)
+    : BufferPoolManager(disk_manager), shared_pool_(shared_pool), file_id_(shared_pool->AttachFile(disk_manager)) {
+  if (file_id_ == INVALID_FILE_ID) {
+    throw std::length_error("Too many files attached to the shared buffer pool.");
+  }
+}
+
+SharedBufferPoolManager::~SharedBufferPoolManager() {
+  // 先停止本文件的预读和预热线程，之后不会再有读取该文件的请求
+  StopIOWorkers();
+  shared_pool_->DetachFile(file_id_);
+}
+
+Page *SharedBufferPoolManager::FetchPage(page_id_t page_id) {
+  return shared_pool_->FetchPage(file_id_, page_id, nullptr);
+}
+
+Page *SharedBufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return shared_pool_->FetchPage(file_id_, page_id, strategy);
+}
+
+bool SharedBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  return shared_pool_->UnpinPage(file_id_, page_id, is_dirty);
+}
+
+bool SharedBufferPoolManager::FlushPage(page_id_t page_id) { return shared_pool_->FlushPage(file_id_, page_id); }
+
+void SharedBufferPoolManager::FlushAllPages() {
+  shared_pool_->WriteBackDirtyPages(file_id_);
+  disk_manager_->Sync();
+}
+
+Page *SharedBufferPoolManager::NewPage(page_id_t &page_id) { return shared_pool_->NewPage(file_id_, page_id); }
+
+Page *SharedBufferPoolManager::NewPageNear(page_id_t &page_id, page_id_t near_page_id) {
+  return shared_pool_->NewPageNear(file_id_, page_id, near_page_id);
+}
+
+bool SharedBufferPoolManager::DeletePage(page_id_t page_id) { return shared_pool_->DeletePage(file_id_, page_id); }
+
+Page *SharedBufferPoolManager::RelocatePage(page_id_t page_id, page_id_t &new_page_id) {
+  return shared_pool_->RelocatePage(file_id_, page_id, new_page_id);
+}
+
+bool SharedBufferPoolManager::CheckAllUnpinned() { return shared_pool_->CheckAllUnpinned(file_id_); }
+
+size_t SharedBufferPoolManager::GetPoolSize() { return shared_pool_->GetPoolSize(); }
+
+bool SharedBufferPoolManager::Resize(__attribute__((unused)) size_t pool_size) { return false; }
+
+void SharedBufferPoolManager::StartBackgroundWriter(__attribute__((unused)) size_t low_watermark,
+                                                    __attribute__((unused)) size_t high_watermark) {}
+
+void SharedBufferPoolManager::StopBackgroundWriter() {}
+
+std::vector<page_id_t> SharedBufferPoolManager::GetResidentPageIds() {
+  return shared_pool_->GetResidentPageIds(file_id_);
+}
+
+page_id_t SharedBufferPoolManager::PrefetchPage(page_id_t page_id, NextPageIdFunc next_page_id) {
+  return shared_pool_->PrefetchPage(file_id_, page_id, next_page_id);
+}
+
+void SharedBufferPoolManager::PrefetchBatch(const std::vector<page_id_t> &page_ids) {
+  shared_pool_->PrefetchBatch(file_id_, page_ids);
+}
+
+void SharedBufferPoolManager::RestoreEvictionOrder(const std::vector<page_id_t> &page_ids) {
+  shared_pool_->RestoreEvictionOrder(file_id_, page_ids);
+}
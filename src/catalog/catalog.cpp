@@ -100,10 +100,15 @@ CatalogManager::CatalogManager(BufferPoolManager *buffer_pool_manager, LockManag
       TableMetadata::DeserializeFrom(table_meta_page->GetData(), table_meta);  // 反序列化表的元信息
       table_names_[table_meta->GetTableName()] = table_meta->GetTableId();     // 获取表名
       auto table_heap = TableHeap::Create(buffer_pool_manager, table_meta->GetFirstPageId(), table_meta->GetSchema(),
-                                          log_manager_, lock_manager_);
+                                          log_manager_, lock_manager_, table_meta->GetFreeSpaceMapPageId());
       TableInfo *table_info = TableInfo::Create();
       table_info->Init(table_meta, table_heap);        // 初始化table_info
       tables_[table_meta->GetTableId()] = table_info;  // 赋值
+      if (table_heap->GetFreeSpaceMapPageId() != table_meta->GetFreeSpaceMapPageId()) {
+        // 旧的表没有空闲空间表，打开时建好并记录到表的元信息中
+        table_info->SetFreeSpaceMapPageId(table_heap->GetFreeSpaceMapPageId());
+        FlushTableMetaPage(table_meta->GetTableId());
+      }
       if (table_meta->GetTableId() >= next_table_id_) {
         next_table_id_ = table_meta->GetTableId() + 1;  // 更新next
       }
@@ -139,6 +144,9 @@ CatalogManager::~CatalogManager() {
  * TODO: Student Implement
  */
 dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schema, Txn *txn, TableInfo *&table_info) {
+  if (buffer_pool_manager_->IsReadOnly()) {  // 只读的数据库不能修改
+    return DB_FAILED;
+  }
   auto temp = table_names_.find(table_name);
   if (temp != table_names_.end()) {  // 表名已经存在
     // table_info = tables_[temp->second];
@@ -150,9 +158,11 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
   page_id_t id;
   auto page = buffer_pool_manager_->NewPage(id);
   auto copy_schema = Schema::DeepCopySchema(schema);  // 深拷贝，如果schema在函数执行期间被修改，不会影响到正在创建的表
-  TableHeap *heap_ = TableHeap::Create(buffer_pool_manager_, copy_schema, txn, log_manager_,
-                                       lock_manager_);  // 创建堆表和表的元信息并序列化到page
-  TableMetadata *table_meta_ = TableMetadata::Create(next_table_id_, table_name, heap_->GetFirstPageId(), copy_schema);
+  segment_id_t segment_id = buffer_pool_manager_->CreateSegment();  // 支持段文件时表的页单独存放在一个文件中
+  TableHeap *heap_ = TableHeap::Create(buffer_pool_manager_, copy_schema, txn, log_manager_, lock_manager_,
+                                       segment_id);  // 创建堆表和表的元信息并序列化到page
+  TableMetadata *table_meta_ = TableMetadata::Create(next_table_id_, table_name, heap_->GetFirstPageId(), copy_schema,
+                                                     heap_->GetFreeSpaceMapPageId());
   table_meta_->SerializeTo(page->GetData());
   buffer_pool_manager_->UnpinPage(id, true);
   table_info->Init(table_meta_, heap_);  // 创建table信息并存储到tables_中
@@ -198,6 +208,9 @@ dberr_t CatalogManager::GetTables(vector<TableInfo *> &tables) const {
 dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string &index_name,
                                     const std::vector<std::string> &index_keys, Txn *txn, IndexInfo *&index_info,
                                     const string &index_type) {
+  if (buffer_pool_manager_->IsReadOnly()) {  // 只读的数据库不能修改
+    return DB_FAILED;
+  }
   auto iter_find_table = table_names_.find(table_name);  // table要存在的
   if (iter_find_table == table_names_.end()) {
     return DB_TABLE_NOT_EXIST;
@@ -233,16 +246,19 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
   }
   meta_page = buffer_pool_manager_->NewPage(meta_page_id);  // 获取一个新页来存储索引元信息
   index_id = catalog_meta_->GetNextIndexId();
-  index_meta_ = IndexMetadata::Create(index_id, index_name, table_id, key_map);  // 创建索引元信息
+  // 支持段文件时索引的页单独存放在一个文件中
+  index_meta_ = IndexMetadata::Create(index_id, index_name, table_id, key_map,
+                                      buffer_pool_manager_->CreateSegment());  // 创建索引元信息
   index_meta_->SerializeTo(meta_page->GetData());                                // 索引元信息序列化
   index_info->Init(index_meta_, table_info, buffer_pool_manager_);
   index_names_[table_name][index_name] = index_id;  // 存储indexinfo
   indexes_[index_id] = index_info;
 
-  // 创建索引时遍历tableheap中所有元素
+  // 创建索引时遍历tableheap中所有元素，使用buffer ring避免冲刷缓冲池
   auto table_heap = table_info->GetTableHeap();
   vector<Field> f;
-  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); iter++) {
+  BufferAccessStrategy strategy;
+  for (auto iter = table_heap->Begin(nullptr, &strategy); iter != table_heap->End(); iter++) {
     f.clear();
     for (auto pos : key_map) {  // 对于堆表中每一条记录获取对应搜索键的每一个元组
       f.push_back(*(iter->GetField(pos)));
@@ -294,6 +310,9 @@ dberr_t CatalogManager::GetTableIndexes(const std::string &table_name, std::vect
  * TODO: Student Implement
  */
 dberr_t CatalogManager::DropTable(const string &table_name) {
+  if (buffer_pool_manager_->IsReadOnly()) {  // 只读的数据库不能修改
+    return DB_FAILED;
+  }
   if (table_names_.find(table_name) == table_names_.end()) {
     return DB_TABLE_NOT_EXIST;  // 确保table存在
   }
@@ -302,9 +321,25 @@ dberr_t CatalogManager::DropTable(const string &table_name) {
   if (table_info == nullptr) {
     return DB_FAILED;
   }
+  // 先删除表上的索引
+  auto table_indexes = index_names_.find(table_name);
+  if (table_indexes != index_names_.end()) {
+    std::vector<std::string> index_names;
+    for (const auto &iter : table_indexes->second) {
+      index_names.push_back(iter.first);
+    }
+    for (const auto &index_name : index_names) {
+      DropIndex(table_name, index_name);
+    }
+    index_names_.erase(table_name);
+  }
+  // 表独占一个段时直接删除段文件，否则逐页释放
+  table_info->GetTableHeap()->FreeTableHeap();
+  catalog_meta_->DeleteTableMetaPage(buffer_pool_manager_, table_id);
   tables_.erase(table_id);         // 清除id对应的映射
   table_names_.erase(table_name);  // 清除num对应的映射
-  table_info->~TableInfo();        // 析构table对应的tableInfo
+  delete table_info;               // 析构table对应的tableInfo
+  FlushCatalogMetaPage();
   return DB_SUCCESS;
 }
 
@@ -312,6 +347,9 @@ dberr_t CatalogManager::DropTable(const string &table_name) {
  * TODO: Student Implement
  */
 dberr_t CatalogManager::DropIndex(const string &table_name, const string &index_name) {
+  if (buffer_pool_manager_->IsReadOnly()) {  // 只读的数据库不能修改
+    return DB_FAILED;
+  }
   auto table_indexes = index_names_.find(table_name);
   if (table_indexes == index_names_.end()) {
     return DB_TABLE_NOT_EXIST;  // 确保table存在
@@ -324,17 +362,67 @@ dberr_t CatalogManager::DropIndex(const string &table_name, const string &index_
   if (index_nametoid == index_tabletonametoid->second.end()) {
     return DB_INDEX_NOT_FOUND;
   } else {
-    delete indexes_[index_nametoid->second];          // index_id对应的info删掉
+    index_id_t index_id = index_nametoid->second;
+    // 索引独占一个段时直接删除段文件，否则逐页释放
+    indexes_[index_id]->GetIndex()->Destroy();
+    catalog_meta_->DeleteIndexMetaPage(buffer_pool_manager_, index_id);
+    delete indexes_[index_id];                        // index_id对应的info删掉
     index_tabletonametoid->second.erase(index_name);  // 删除映射关系name,id
-    indexes_.erase(index_nametoid->second);           // 删除映射关系id,info
+    indexes_.erase(index_id);                         // 删除映射关系id,info
+    FlushCatalogMetaPage();
     return DB_SUCCESS;
   }
 }
 
+dberr_t CatalogManager::Compact() {
+  if (buffer_pool_manager_->IsReadOnly()) {  // 只读的数据库不能修改
+    return DB_FAILED;
+  }
+  for (auto &[table_id, table_info] : tables_) {
+    std::vector<IndexInfo *> indexes;
+    GetTableIndexes(table_info->GetTableName(), indexes);
+    TableHeap *table_heap = table_info->GetTableHeap();
+    table_heap->Compact([&](__attribute__((unused)) page_id_t old_page_id, page_id_t new_page_id) {
+      if (indexes.empty()) {
+        return;
+      }
+      // 页中的行换了行号，索引中的条目随之更新
+      auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(new_page_id));
+      RowId rid;
+      for (bool found = page->GetFirstTupleRid(&rid); found; found = page->GetNextTupleRid(rid, &rid)) {
+        Row row(rid);
+        Row key_row;
+        table_heap->GetTuple(&row, nullptr);
+        for (auto index_info : indexes) {
+          row.GetKeyFromRow(table_info->GetSchema(), index_info->GetIndexKeySchema(), key_row);
+          index_info->GetIndex()->UpdateEntry(key_row, rid, nullptr);
+        }
+      }
+      buffer_pool_manager_->UnpinPage(new_page_id, false);
+    });
+    if (table_heap->GetFirstPageId() != table_info->GetRootPageId() ||
+        table_heap->GetFreeSpaceMapPageId() != table_info->GetTableMeta()->GetFreeSpaceMapPageId()) {
+      // 表或空闲空间表的首页移动了，更新表的元信息
+      table_info->SetRootPageId(table_heap->GetFirstPageId());
+      table_info->SetFreeSpaceMapPageId(table_heap->GetFreeSpaceMapPageId());
+      FlushTableMetaPage(table_id);
+    }
+  }
+  // 表的页移动时会更新索引，所以最后再整理索引的页
+  for (auto &[index_id, index_info] : indexes_) {
+    index_info->GetIndex()->Compact();
+  }
+  buffer_pool_manager_->TruncateFiles();
+  return DB_SUCCESS;
+}
+
 /**
  * TODO: Student Implement
  */
 dberr_t CatalogManager::FlushCatalogMetaPage() const {
+  if (buffer_pool_manager_->IsReadOnly()) {  // 只读的数据库不能修改
+    return DB_FAILED;
+  }
   auto CatalogMetaPage = buffer_pool_manager_->FetchPage(CATALOG_META_PAGE_ID);
   catalog_meta_->SerializeTo(reinterpret_cast<char *>(CatalogMetaPage->GetData()));
   buffer_pool_manager_->UnpinPage(CATALOG_META_PAGE_ID, false);
@@ -342,6 +430,12 @@ dberr_t CatalogManager::FlushCatalogMetaPage() const {
   return DB_SUCCESS;
 }
 
+void CatalogManager::FlushTableMetaPage(table_id_t table_id) {
+  page_id_t meta_page_id = catalog_meta_->table_meta_pages_[table_id];
+  tables_[table_id]->GetTableMeta()->SerializeTo(buffer_pool_manager_->FetchPage(meta_page_id)->GetData());
+  buffer_pool_manager_->UnpinPage(meta_page_id, true);
+}
+
 /**
  * TODO: Student Implement
  */
@@ -359,10 +453,18 @@ dberr_t CatalogManager::LoadTable(const table_id_t table_id, const page_id_t pag
   table_name = table_meta->GetTableName();
   schema = table_meta->GetSchema();
   table_page_id = table_meta->GetFirstPageId();
-  table_heap = table_heap->Create(buffer_pool_manager_, table_page_id, schema, nullptr, nullptr);
+  table_heap = table_heap->Create(buffer_pool_manager_, table_page_id, schema, nullptr, nullptr,
+                                  table_meta->GetFreeSpaceMapPageId());
   table_info->Init(table_meta, table_heap);  // 用反序列化出的table_meta和table_heap初始化table_info
   tables_[table_id] = table_info;
   table_names_[table_name] = table_id;
+  bool is_dirty = false;
+  if (table_heap->GetFreeSpaceMapPageId() != table_meta->GetFreeSpaceMapPageId()) {
+    table_info->SetFreeSpaceMapPageId(table_heap->GetFreeSpaceMapPageId());
+    table_meta->SerializeTo(meta_page->GetData());
+    is_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(page_id, is_dirty);
   return DB_SUCCESS;
 }
 
@@ -2,19 +2,20 @@
 #include <cstdint>
 
 IndexMetadata::IndexMetadata(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                             const std::vector<uint32_t> &key_map)
-    : index_id_(index_id), index_name_(index_name), table_id_(table_id), key_map_(key_map) {}
+                             const std::vector<uint32_t> &key_map, segment_id_t segment_id)
+    : index_id_(index_id), index_name_(index_name), table_id_(table_id), key_map_(key_map), segment_id_(segment_id) {}
 
 IndexMetadata *IndexMetadata::Create(const index_id_t index_id, const string &index_name, const table_id_t table_id,
-                                     const vector<uint32_t> &key_map) {
-  return new IndexMetadata(index_id, index_name, table_id, key_map);
+                                     const vector<uint32_t> &key_map, segment_id_t segment_id) {
+  return new IndexMetadata(index_id, index_name, table_id, key_map, segment_id);
 }
 
 uint32_t IndexMetadata::SerializeTo(char *buf) const {
-  /*content: MAGIC_NUM | index_id_ | index_name_ | table_id_ | key_map_ */
+  /*content: MAGIC_NUM | index_id_ | index_name_ | table_id_ | key_map_ [| segment_id_] */
   uint32_t offset = 0;
-  // magic num
-  MACH_WRITE_TO(uint32_t, buf, INDEX_METADATA_MAGIC_NUM);
+  // magic num, the segment id is only written for an index which has a segment of its own
+  bool has_segment = (segment_id_ != MAIN_SEGMENT_ID);
+  MACH_WRITE_TO(uint32_t, buf, has_segment ? INDEX_METADATA_SEGMENT_MAGIC_NUM : INDEX_METADATA_MAGIC_NUM);
   offset = sizeof(INDEX_METADATA_MAGIC_NUM);
   // index_id
   MACH_WRITE_TO(uint32_t, buf + offset, index_id_);
@@ -37,6 +38,11 @@ uint32_t IndexMetadata::SerializeTo(char *buf) const {
     MACH_WRITE_TO(uint32_t, buf + offset, key_map_[i]);
     offset += sizeof(uint32_t);
   }
+  // segment_id
+  if (has_segment) {
+    MACH_WRITE_TO(uint32_t, buf + offset, segment_id_);
+    offset += sizeof(segment_id_);
+  }
 
   return offset;
 }
@@ -46,6 +52,9 @@ uint32_t IndexMetadata::SerializeTo(char *buf) const {
  */
 uint32_t IndexMetadata::GetSerializedSize() const {
   uint32_t size = index_name_.size() + 4 * key_map_.size() + 4 * 5;
+  if (segment_id_ != MAIN_SEGMENT_ID) {
+    size += sizeof(segment_id_);
+  }
   return size;
 }
 
@@ -57,7 +66,8 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
   // magic num
   uint32_t magic_num = MACH_READ_UINT32(buf);
   buf += 4;
-  ASSERT(magic_num == INDEX_METADATA_MAGIC_NUM, "Failed to deserialize index info.");
+  ASSERT(magic_num == INDEX_METADATA_MAGIC_NUM || magic_num == INDEX_METADATA_SEGMENT_MAGIC_NUM,
+         "Failed to deserialize index info.");
   // index id
   index_id_t index_id = MACH_READ_FROM(index_id_t, buf);
   buf += 4;
@@ -79,8 +89,14 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
     buf += 4;
     key_map.push_back(key_index);
   }
+  // segment id
+  segment_id_t segment_id = MAIN_SEGMENT_ID;
+  if (magic_num == INDEX_METADATA_SEGMENT_MAGIC_NUM) {
+    segment_id = MACH_READ_UINT32(buf);
+    buf += 4;
+  }
   // allocate space for index meta data
-  index_meta = new IndexMetadata(index_id, index_name, table_id, key_map);
+  index_meta = new IndexMetadata(index_id, index_name, table_id, key_map, segment_id);
   return buf - p;
 }
 
@@ -108,5 +124,5 @@ Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const stri
   } else {
     return nullptr;
   }
-  return new BPlusTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager);
+  return new BPlusTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager, meta_data_->segment_id_);
 }
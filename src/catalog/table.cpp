@@ -5,7 +5,8 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
   uint32_t ofs = GetSerializedSize();
   ASSERT(ofs <= PAGE_SIZE, "Failed to serialize table info.");
   // magic num
-  MACH_WRITE_UINT32(buf, TABLE_METADATA_MAGIC_NUM);
+  bool has_free_space_map = (free_space_map_page_id_ != INVALID_PAGE_ID);
+  MACH_WRITE_UINT32(buf, has_free_space_map ? TABLE_METADATA_FSM_MAGIC_NUM : TABLE_METADATA_MAGIC_NUM);
   buf += 4;
   // table id
   MACH_WRITE_TO(table_id_t, buf, table_id_);
@@ -20,6 +21,11 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
   buf += 4;
   // table schema
   buf += schema_->SerializeTo(buf);
+  // free space map first page id
+  if (has_free_space_map) {
+    MACH_WRITE_TO(page_id_t, buf, free_space_map_page_id_);
+    buf += 4;
+  }
   ASSERT(buf - p == ofs, "Unexpected serialize size.");
   return ofs;
 }
@@ -28,7 +34,8 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
  * TODO: Student Implement
  */
 uint32_t TableMetadata::GetSerializedSize() const {
-  return 4 + 4 + MACH_STR_SERIALIZED_SIZE(table_name_) + 4 + schema_->GetSerializedSize();
+  return 4 + 4 + MACH_STR_SERIALIZED_SIZE(table_name_) + 4 + schema_->GetSerializedSize() +
+         (free_space_map_page_id_ != INVALID_PAGE_ID ? 4 : 0);
 }
 
 /**
@@ -43,7 +50,8 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
   // magic num
   uint32_t magic_num = MACH_READ_UINT32(buf);
   buf += 4;
-  ASSERT(magic_num == TABLE_METADATA_MAGIC_NUM, "Failed to deserialize table info.");
+  ASSERT(magic_num == TABLE_METADATA_MAGIC_NUM || magic_num == TABLE_METADATA_FSM_MAGIC_NUM,
+         "Failed to deserialize table info.");
   // table id
   table_id_t table_id = MACH_READ_FROM(table_id_t, buf);
   buf += 4;
@@ -58,8 +66,14 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
   // table schema
   TableSchema *schema = nullptr;
   buf += TableSchema::DeserializeFrom(buf, schema);
+  // free space map first page id
+  page_id_t free_space_map_page_id = INVALID_PAGE_ID;
+  if (magic_num == TABLE_METADATA_FSM_MAGIC_NUM) {
+    free_space_map_page_id = MACH_READ_FROM(page_id_t, buf);
+    buf += 4;
+  }
   // allocate space for table metadata
-  table_meta = new TableMetadata(table_id, table_name, root_page_id, schema);
+  table_meta = new TableMetadata(table_id, table_name, root_page_id, schema, free_space_map_page_id);
   return buf - p;
 }
 
@@ -69,10 +83,15 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
  * @param heap Memory heap passed by TableInfo
  */
 TableMetadata *TableMetadata::Create(table_id_t table_id, std::string table_name, page_id_t root_page_id,
-                                     TableSchema *schema) {
+                                     TableSchema *schema, page_id_t free_space_map_page_id) {
   // allocate space for table metadata
-  return new TableMetadata(table_id, table_name, root_page_id, schema);
+  return new TableMetadata(table_id, table_name, root_page_id, schema, free_space_map_page_id);
 }
 
-TableMetadata::TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema)
-    : table_id_(table_id), table_name_(table_name), root_page_id_(root_page_id), schema_(schema) {}
+TableMetadata::TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema,
+                             page_id_t free_space_map_page_id)
+    : table_id_(table_id),
+      table_name_(table_name),
+      root_page_id_(root_page_id),
+      schema_(schema),
+      free_space_map_page_id_(free_space_map_page_id) {}
@@ -3,16 +3,48 @@
 //
 #include "common/instance.h"
 
-DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size)
-    : db_file_name_(std::move(db_name)), init_(init) {
+DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size,
+                                 uint32_t buffer_pool_instances, ReplacerType replacer_type,
+                                 BufferPoolManager *shared_buffer_pool, bool read_only, bool segment_files)
+    : db_file_name_(std::move(db_name)), init_(init), read_only_(read_only) {
+  if (init_ && read_only_) {
+    throw std::invalid_argument("A read-only database can not be initialized.");
+  }
   // Init database file if needed
   db_file_name_ = "./databases/" + db_file_name_;
+  std::string resident_pages_file = db_file_name_ + RESIDENT_PAGES_FILE_SUFFIX;
   if (init_) {
     remove(db_file_name_.c_str());
+    SegmentedBufferPoolManager::RemoveSegmentFiles(db_file_name_);
+  }
+  segment_files = segment_files || SegmentedBufferPoolManager::HasSegmentFiles(db_file_name_);
+  if (read_only_ && segment_files) {
+    throw std::invalid_argument("A database with segment files can not be opened in read-only mode.");
+  }
+  // 上次正常关闭时缓冲池中的页，读取后即删除，异常退出后不会使用过期的列表；只读时页不在缓冲池中，保留该列表
+  std::vector<page_id_t> resident_pages;
+  if (!init_ && !read_only_) {
+    resident_pages = BufferPoolManager::LoadResidentPages(resident_pages_file);
+  }
+  if (!read_only_) {
+    remove(resident_pages_file.c_str());
   }
   // Initialize components
-  disk_mgr_ = new DiskManager(db_file_name_);
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  disk_mgr_ = new DiskManager(db_file_name_, DEFAULT_DIRECT_IO, read_only_);
+  if (read_only_) {
+    bpm_ = new ReadOnlyBufferPoolManager(disk_mgr_);
+  } else if (segment_files && shared_buffer_pool != nullptr) {
+    bpm_ = new SegmentedBufferPoolManager(shared_buffer_pool, disk_mgr_);
+  } else if (segment_files) {
+    bpm_ = new SegmentedBufferPoolManager(buffer_pool_size, disk_mgr_, replacer_type);
+  } else if (shared_buffer_pool != nullptr) {
+    bpm_ = new SharedBufferPoolManager(shared_buffer_pool, disk_mgr_);
+  } else if (buffer_pool_instances > 1) {
+    bpm_ = new ParallelBufferPoolManager(buffer_pool_instances, buffer_pool_size, disk_mgr_, replacer_type);
+  } else {
+    bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_, replacer_type);
+  }
+  StartBackgroundWriter();
 
   // Allocate static page for db storage engine
   if (init) {
@@ -39,14 +71,30 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
     ASSERT(!bpm_->IsPageFree(INDEX_ROOTS_PAGE_ID), "Invalid header page.");
   }
   catalog_mgr_ = new CatalogManager(bpm_, nullptr, nullptr, init);
+  bpm_->StartWarmUp(std::move(resident_pages));
 }
 
 DBStorageEngine::~DBStorageEngine() {
   delete catalog_mgr_;
+  if (!read_only_) {
+    bpm_->DumpResidentPages(db_file_name_ + RESIDENT_PAGES_FILE_SUFFIX);
+  }
   delete bpm_;
   delete disk_mgr_;
 }
 
+bool DBStorageEngine::ResizeBufferPool(uint32_t buffer_pool_size) {
+  bool resized = bpm_->Resize(buffer_pool_size);
+  StartBackgroundWriter();  // 缩小失败时缓冲池也可能已部分改变大小
+  return resized;
+}
+
+void DBStorageEngine::StartBackgroundWriter() {
+  size_t pool_size = bpm_->GetPoolSize();
+  bpm_->StartBackgroundWriter(pool_size * BG_WRITER_LOW_WATERMARK_PCT / 100,
+                              pool_size * BG_WRITER_HIGH_WATERMARK_PCT / 100);
+}
+
 std::unique_ptr<ExecuteContext> DBStorageEngine::MakeExecuteContext(Txn *txn) {
   return std::make_unique<ExecuteContext>(txn, catalog_mgr_, bpm_);
 }
@@ -4,12 +4,14 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <ostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "catalog/catalog.h"
@@ -30,7 +32,12 @@
 #include "record/type_id.h"
 #include "utils/utils.h"
 
-ExecuteEngine::ExecuteEngine() {
+ExecuteEngine::ExecuteEngine(bool shared_buffer_pool) {
+  if (shared_buffer_pool) {
+    shared_bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, nullptr);
+    shared_bpm_->StartBackgroundWriter(DEFAULT_BUFFER_POOL_SIZE * BG_WRITER_LOW_WATERMARK_PCT / 100,
+                                       DEFAULT_BUFFER_POOL_SIZE * BG_WRITER_HIGH_WATERMARK_PCT / 100);
+  }
   char path[] = "./databases";
   DIR *dir;
   if ((dir = opendir(path)) == nullptr) {
@@ -43,17 +50,24 @@ ExecuteEngine::ExecuteEngine() {
   /*struct dirent *stdir;
   while ((stdir = readdir(dir)) != nullptr) {
     if (strcmp(stdir->d_name, ".") == 0 || strcmp(stdir->d_name, "..") == 0 || stdir->d_name[0] == '.') continue;
-    dbs_[stdir->d_name] = new DBStorageEngine(stdir->d_name, false);
+    dbs_[stdir->d_name] = OpenDatabase(stdir->d_name, false);
   }*/
   closedir(dir);
 }
 
+DBStorageEngine *ExecuteEngine::OpenDatabase(const std::string &db_name, bool init) {
+  return new DBStorageEngine(db_name, init, DEFAULT_BUFFER_POOL_SIZE, DEFAULT_BUFFER_POOL_INSTANCES, ReplacerType::LRU,
+                             shared_bpm_);
+}
+
 std::unique_ptr<AbstractExecutor> ExecuteEngine::CreateExecutor(ExecuteContext *exec_ctx,
-                                                                const AbstractPlanNodeRef &plan) {
+                                                                const AbstractPlanNodeRef &plan, bool parallel) {
   switch (plan->GetType()) {
     // Create a new sequential scan executor
     case PlanType::SeqScan: {
-      return std::make_unique<SeqScanExecutor>(exec_ctx, dynamic_cast<const SeqScanPlanNode *>(plan.get()));
+      size_t num_workers = parallel ? std::min<size_t>(std::thread::hardware_concurrency(), MAX_SCAN_WORKERS) : 1;
+      return std::make_unique<SeqScanExecutor>(exec_ctx, dynamic_cast<const SeqScanPlanNode *>(plan.get()),
+                                               num_workers);
     }
     // Create a new index scan executor
     case PlanType::IndexScan: {
@@ -62,18 +76,18 @@ std::unique_ptr<AbstractExecutor> ExecuteEngine::CreateExecutor(ExecuteContext *
     // Create a new update executor
     case PlanType::Update: {
       auto update_plan = dynamic_cast<const UpdatePlanNode *>(plan.get());
-      auto child_executor = CreateExecutor(exec_ctx, update_plan->GetChildPlan());
+      auto child_executor = CreateExecutor(exec_ctx, update_plan->GetChildPlan(), false);
       return std::make_unique<UpdateExecutor>(exec_ctx, update_plan, std::move(child_executor));
     }
       // Create a new delete executor
     case PlanType::Delete: {
       auto delete_plan = dynamic_cast<const DeletePlanNode *>(plan.get());
-      auto child_executor = CreateExecutor(exec_ctx, delete_plan->GetChildPlan());
+      auto child_executor = CreateExecutor(exec_ctx, delete_plan->GetChildPlan(), false);
       return std::make_unique<DeleteExecutor>(exec_ctx, delete_plan, std::move(child_executor));
     }
     case PlanType::Insert: {
       auto insert_plan = dynamic_cast<const InsertPlanNode *>(plan.get());
-      auto child_executor = CreateExecutor(exec_ctx, insert_plan->GetChildPlan());
+      auto child_executor = CreateExecutor(exec_ctx, insert_plan->GetChildPlan(), false);
       return std::make_unique<InsertExecutor>(exec_ctx, insert_plan, std::move(child_executor));
     }
     case PlanType::Values: {
@@ -245,6 +259,24 @@ void ExecuteEngine::ExecuteInformation(dberr_t result) {
   }
 }
 
+dberr_t ExecuteEngine::ResizeBufferPool(const std::string &db_name, uint32_t buffer_pool_size) {
+  auto iter = dbs_.find(db_name);
+  if (iter == dbs_.end()) {
+    return DB_NOT_EXIST;
+  }
+  return iter->second->ResizeBufferPool(buffer_pool_size) ? DB_SUCCESS : DB_FAILED;
+}
+
+dberr_t ExecuteEngine::ResizeSharedBufferPool(uint32_t buffer_pool_size) {
+  if (shared_bpm_ == nullptr || !shared_bpm_->Resize(buffer_pool_size)) {
+    return DB_FAILED;
+  }
+  size_t pool_size = shared_bpm_->GetPoolSize();
+  shared_bpm_->StartBackgroundWriter(pool_size * BG_WRITER_LOW_WATERMARK_PCT / 100,
+                                     pool_size * BG_WRITER_HIGH_WATERMARK_PCT / 100);
+  return DB_SUCCESS;
+}
+
 dberr_t ExecuteEngine::ExecuteCreateDatabase(pSyntaxNode ast, ExecuteContext *context) {
 #ifdef ENABLE_EXECUTE_DEBUG
   LOG(INFO) << "ExecuteCreateDatabase" << std::endl;
@@ -253,7 +285,7 @@ dberr_t ExecuteEngine::ExecuteCreateDatabase(pSyntaxNode ast, ExecuteContext *co
   if (dbs_.find(db_name) != dbs_.end()) {
     return DB_ALREADY_EXIST;
   }
-  dbs_.insert(make_pair(db_name, new DBStorageEngine(db_name, true)));
+  dbs_.insert(make_pair(db_name, OpenDatabase(db_name, true)));
   return DB_SUCCESS;
 }
 
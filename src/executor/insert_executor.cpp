@@ -16,9 +16,26 @@ void InsertExecutor::Init() {
 }
 
 bool InsertExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
+  if (cursor_ == inserted_) {
+    inserted_ = InsertBatch();
+    cursor_ = 0;
+    if (inserted_ == 0) {
+      return false;
+    }
+  }
+  cursor_++;
+  return true;
+}
+
+size_t InsertExecutor::InsertBatch() {
+  batch_.clear();
   Row insert_row;
   RowId insert_rid;
-  if (child_executor_->Next(&insert_row, &insert_rid)) {
+  while (!done_ && batch_.size() < BATCH_SIZE) {
+    if (!child_executor_->Next(&insert_row, &insert_rid)) {
+      done_ = true;
+      break;
+    }
     for (auto info : index_info_) {
       Row key_row;
       insert_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), key_row);
@@ -26,17 +43,39 @@ bool InsertExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
       if (!key_row.GetFields().empty() &&
           info->GetIndex()->ScanKey(key_row, result, exec_ctx_->GetTransaction()) == DB_SUCCESS) {
         std::cout << "key already exists" << std::endl;
-        return false;
+        done_ = true;
+        break;
       }
     }
-    if (table_info_->GetTableHeap()->InsertTuple(insert_row, exec_ctx_->GetTransaction())) {
-      Row key_row;
-      for (auto info : index_info_) {  // 更新索引
-        insert_row.GetKeyFromRow(schema_, info->GetIndexKeySchema(), key_row);
-        info->GetIndex()->InsertEntry(key_row, insert_row.GetRowId(), exec_ctx_->GetTransaction());
+    if (!done_) {
+      batch_.push_back(insert_row);
+    }
+  }
+  size_t inserted = table_info_->GetTableHeap()->BulkInsert(batch_, exec_ctx_->GetTransaction());
+  if (inserted < batch_.size()) {
+    done_ = true;
+  }
+  for (size_t i = 0; i < inserted; i++) {  // 更新索引
+    Row &batch_row = batch_[i];
+    Row key_row;
+    for (size_t j = 0; j < index_info_.size(); j++) {
+      batch_row.GetKeyFromRow(schema_, index_info_[j]->GetIndexKeySchema(), key_row);
+      if (index_info_[j]->GetIndex()->InsertEntry(key_row, batch_row.GetRowId(), exec_ctx_->GetTransaction()) ==
+          DB_SUCCESS) {
+        continue;
       }
-      return true;
+      // 同一批中前面的行已经有这个键，撤销这一行以及之后的行
+      std::cout << "key already exists" << std::endl;
+      for (size_t k = 0; k < j; k++) {
+        batch_row.GetKeyFromRow(schema_, index_info_[k]->GetIndexKeySchema(), key_row);
+        index_info_[k]->GetIndex()->RemoveEntry(key_row, batch_row.GetRowId(), exec_ctx_->GetTransaction());
+      }
+      for (size_t k = i; k < inserted; k++) {
+        table_info_->GetTableHeap()->ApplyDelete(batch_[k].GetRowId(), exec_ctx_->GetTransaction());
+      }
+      done_ = true;
+      return i;
     }
   }
-  return false;
-}
\ No newline at end of file
+  return inserted;
+}
@@ -3,11 +3,16 @@
 //
 #include "executor/executors/seq_scan_executor.h"
 
-SeqScanExecutor::SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode *plan)
+#include <algorithm>
+
+SeqScanExecutor::SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode *plan, size_t num_workers)
     : AbstractExecutor(exec_ctx),
       plan_(plan),
-      iterator_(nullptr, RowId(INVALID_PAGE_ID, 0), nullptr),
-      is_schema_same_(false) {}
+      is_schema_same_(false),
+      num_workers_(num_workers),
+      max_pending_morsels_(2 * num_workers) {}
+
+SeqScanExecutor::~SeqScanExecutor() { StopWorkers(); }
 
 bool SeqScanExecutor::SchemaEqual(const Schema *table_schema, const Schema *output_schema) {
   auto table_columns = table_schema->GetColumns();
@@ -26,45 +31,157 @@ bool SeqScanExecutor::SchemaEqual(const Schema *table_schema, const Schema *outp
   return true;
 }
 
-void SeqScanExecutor::TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row,
+void SeqScanExecutor::TupleTransfer(const Schema *table_schema, const Schema *output_schema, const RowView *row,
                                     Row *output_row) {
   const auto &output_columns = output_schema->GetColumns();
   std::vector<Field> dest_row;
   dest_row.reserve(output_columns.size());
   for (const auto column : output_columns) {
     auto idx = column->GetTableInd();
-    dest_row.emplace_back(*row->GetField(idx));
+    dest_row.emplace_back(row->GetField(idx, true));  // 输出的行在迭代器移走后仍要可用
   }
   *output_row = Row(dest_row);
 }
 
 void SeqScanExecutor::Init() {
+  StopWorkers();
+  iterator_ = TableViewIterator();
   exec_ctx_->GetCatalog()->GetTable(plan_->GetTableName(), table_info_);
-  auto first_row = table_info_->GetTableHeap()->Begin(nullptr);
-  iterator_ = (table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction()));
   schema_ = plan_->OutputSchema();
   is_schema_same_ = SchemaEqual(table_info_->GetSchema(), schema_);
+  advance_ = false;
+  // 缓冲池要能同时容纳各个worker预读的页，否则退化为顺序扫描
+  auto table_heap = table_info_->GetTableHeap();
+  max_pending_morsels_ =
+      std::min(2 * num_workers_, exec_ctx_->GetBufferPoolManager()->GetPoolSize() / (4 * MORSEL_PAGES));
+  if (num_workers_ <= 1 || max_pending_morsels_ == 0 || !table_heap->HasPageDirectory()) {
+    iterator_ = table_heap->BeginView(&strategy_);
+    return;
+  }
+  // 按页目录预先切分morsel，只有一个morsel的表由调用线程直接扫描，不启动worker
+  morsels_ = std::make_unique<TableMorselQueue>(table_heap);
+  size_t morsel_id;
+  if (!morsels_->Next(iterator_, morsel_id, &strategy_) || morsels_->GetMorselCount() <= 1) {
+    return;
+  }
+  size_t num_workers = std::min(num_workers_, morsels_->GetMorselCount() - 1);
+  stop_ = false;
+  failed_ = false;
+  num_taken_ = 0;
+  num_merged_ = 0;
+  num_running_ = num_workers;
+  merged_.clear();
+  merged_pos_ = 0;
+  for (size_t i = 0; i < num_workers; i++) {
+    workers_.emplace_back(&SeqScanExecutor::WorkerLoop, this);
+  }
 }
 
 bool SeqScanExecutor::Next(Row *row, RowId *rid) {
+  // 上层执行器可能已原地修改了上次返回的行所在的页（如更新），此时才移到下一行，使其从页中重新读取
+  if (advance_ && !iterator_.IsEnd()) {
+    ++iterator_;
+  }
+  advance_ = false;
+  for (; !iterator_.IsEnd(); ++iterator_) {
+    if (Produce(&(*iterator_), row)) {
+      *rid = iterator_->GetRowId();
+      advance_ = true;
+      return true;
+    }
+  }
+  if (iterator_.IsFailed()) {
+    throw std::runtime_error("Failed to fetch a page of table " + plan_->GetTableName() + ", the buffer pool is full.");
+  }
+  if (workers_.empty()) {
+    return false;
+  }
+  // 第一个morsel扫描完后，按顺序合并worker扫描出的morsel
+  while (merged_pos_ == merged_.size()) {
+    std::unique_lock<std::mutex> lock(latch_);
+    size_t morsel_id = num_merged_ + 1;
+    cv_.wait(lock, [&] { return results_.count(morsel_id) > 0 || num_running_ == 0 || failed_; });
+    if (failed_) {
+      throw std::runtime_error("Failed to fetch a page of table " + plan_->GetTableName() +
+                               ", the buffer pool is full.");
+    }
+    auto iter = results_.find(morsel_id);
+    if (iter == results_.end()) {
+      return false;
+    }
+    merged_ = std::move(iter->second);
+    merged_pos_ = 0;
+    results_.erase(iter);
+    num_merged_++;
+    cv_.notify_all();
+  }
+  *row = std::move(merged_[merged_pos_++]);
+  *rid = row->GetRowId();
+  return true;
+}
+
+bool SeqScanExecutor::Produce(const RowView *row, Row *output_row) {
   auto predicate = plan_->GetPredicate();
-  auto table_schema = table_info_->GetSchema();
-  while (iterator_ != table_info_->GetTableHeap()->End()) {
-    auto p_row = &(*iterator_);
-    if (predicate != nullptr) {
-      if (!predicate->Evaluate(p_row).CompareEquals(Field(kTypeInt, 1))) {
-        iterator_++;
-        continue;
+  if (predicate != nullptr && !predicate->EvaluateView(row).CompareEquals(Field(kTypeInt, 1))) {
+    return false;
+  }
+  if (!is_schema_same_) {
+    TupleTransfer(table_info_->GetSchema(), schema_, row, output_row);
+    output_row->SetRowId(row->GetRowId());
+  } else {
+    row->ToRow(*output_row);
+  }
+  return true;
+}
+
+void SeqScanExecutor::WorkerLoop() {
+  BufferAccessStrategy strategy;  // 每个worker各用一个ring
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      // 未合并的morsel太多时等待合并，限制固定的页和缓存的结果
+      cv_.wait(lock, [&] { return stop_ || num_taken_ - num_merged_ < max_pending_morsels_; });
+      if (stop_) {
+        break;
       }
+      num_taken_++;
     }
-    *rid = iterator_->GetRowId();
-    if (!is_schema_same_) {
-      TupleTransfer(table_schema, schema_, p_row, row);
-    } else {
-      *row = *p_row;
+    TableViewIterator iterator;
+    size_t morsel_id;
+    if (!morsels_->Next(iterator, morsel_id, &strategy)) {
+      break;
     }
-    iterator_++;
-    return true;
+    std::vector<Row> rows;
+    for (; !iterator.IsEnd(); ++iterator) {
+      Row row;
+      if (Produce(&(*iterator), &row)) {
+        rows.emplace_back(std::move(row));
+      }
+    }
+    std::lock_guard<std::mutex> guard(latch_);
+    if (iterator.IsFailed()) {  // 少了该morsel的行，Next会报错
+      failed_ = true;
+      cv_.notify_all();
+      break;
+    }
+    results_.emplace(morsel_id, std::move(rows));
+    cv_.notify_all();
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  num_running_--;
+  cv_.notify_all();
+}
+
+void SeqScanExecutor::StopWorkers() {
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
   }
-  return false;
+  workers_.clear();
+  results_.clear();
+  morsels_.reset();
 }
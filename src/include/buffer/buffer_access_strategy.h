@@ -0,0 +1,53 @@
+#ifndef MINISQL_BUFFER_ACCESS_STRATEGY_H
+#define MINISQL_BUFFER_ACCESS_STRATEGY_H
+
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+class BufferPoolManager;
+
+/**
+ * BufferAccessStrategy is a small private ring of frames for operations which read a lot of pages once, e.g. a
+ * sequential scan over a big table or freeing a table heap. Pages missed through a strategy are loaded into the frame
+ * of the current ring slot if that frame is unpinned and still holds the page the ring put there, so such an operation
+ * keeps recycling a few frames instead of evicting the working set of the whole buffer pool.
+ *
+ * A strategy belongs to one operation and must not be shared between threads.
+ */
+class BufferAccessStrategy {
+  friend class BufferPoolManager;
+
+ public:
+  explicit BufferAccessStrategy(size_t ring_size = DEFAULT_BUFFER_RING_SIZE) : ring_(ring_size) {
+    ASSERT(ring_size > 0, "Buffer ring needs at least one slot.");
+  }
+
+  ~BufferAccessStrategy() = default;
+
+  DISALLOW_COPY(BufferAccessStrategy);
+
+  /** @return the number of frames in the ring */
+  inline size_t GetRingSize() const { return ring_.size(); }
+
+ private:
+  struct Slot {
+    BufferPoolManager *owner_{nullptr};  // buffer pool (shard) of the frame
+    frame_id_t frame_id_{INVALID_FRAME_ID};
+    file_id_t file_id_{DEFAULT_FILE_ID};  // file of the page loaded into the frame by this ring
+    page_id_t page_id_{INVALID_PAGE_ID};  // page loaded into the frame by this ring
+  };
+
+  /** Advance to the next slot of the ring */
+  inline Slot &NextSlot() {
+    current_ = (current_ + 1) % ring_.size();
+    return ring_[current_];
+  }
+
+ private:
+  std::vector<Slot> ring_;
+  size_t current_{0};
+};
+
+#endif  // MINISQL_BUFFER_ACCESS_STRATEGY_H
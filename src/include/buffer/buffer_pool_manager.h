@@ -1,58 +1,460 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <list>
 #include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
 #include "storage/disk_manager.h"
 
 using namespace std;
 
+/** Read the id of the page following a page in a linked list of pages, INVALID_PAGE_ID at the end of the list */
+using NextPageIdFunc = page_id_t (*)(Page *page);
+
+/**
+ * BufferPoolManager caches disk pages in a fixed number of frames. A cache hit only takes the read latch of one page
+ * table stripe and, when the page was unpinned, the replacer latch; misses, evictions and page allocation are
+ * serialized by latch_.
+ *
+ * The frames can be shared by the files of several databases: every file attached to the buffer pool gets a file id,
+ * and its pages are identified by (file id, page id). The methods taking no file id work on DEFAULT_FILE_ID, the file
+ * of the disk manager the buffer pool is built with.
+ */
 class BufferPoolManager {
+  friend class ParallelBufferPoolManager;
+  friend class SharedBufferPoolManager;
+  friend class SegmentedBufferPoolManager;
+
  public:
-  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+  /**
+   * @param disk_manager disk manager of DEFAULT_FILE_ID, may be nullptr for a buffer pool which only caches the pages
+   * of attached files
+   */
+  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
+                             ReplacerType replacer_type = ReplacerType::LRU);
 
-  ~BufferPoolManager();
+  virtual ~BufferPoolManager();
 
-  Page *FetchPage(page_id_t page_id);
+  virtual Page *FetchPage(page_id_t page_id);
 
-  bool UnpinPage(page_id_t page_id, bool is_dirty);
+  /**
+   * Fetch a page, loading it into a frame of the strategy's ring on a miss.
+   */
+  virtual Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy);
 
-  bool FlushPage(page_id_t page_id);
+  virtual bool UnpinPage(page_id_t page_id, bool is_dirty);
 
-  Page *NewPage(page_id_t &page_id);
+  virtual bool FlushPage(page_id_t page_id);
 
-  bool DeletePage(page_id_t page_id);
+  /**
+   * Checkpoint: write every dirty page back, sorted by its place on disk so that contiguous pages are written together,
+   * then make the files durable with a single sync each. The pages stay cached and can be used meanwhile.
+   */
+  virtual void FlushAllPages();
 
-  bool IsPageFree(page_id_t page_id);
+  virtual Page *NewPage(page_id_t &page_id);
 
-  bool CheckAllUnpinned();
+  /**
+   * Create a page physically close to another one, see DiskManager::AllocatePageNear.
+   * @param near_page_id last page allocated to the same table or index, INVALID_PAGE_ID for its first page
+   */
+  virtual Page *NewPageNear(page_id_t &page_id, page_id_t near_page_id);
+
+  /**
+   * Create the first page of a table or index in a segment, see CreateSegment. Later pages follow it through
+   * NewPageNear, which allocates in the segment of near_page_id.
+   * @return nullptr if the segment does not exist, or if no page can be created
+   */
+  virtual Page *NewPageInSegment(segment_id_t segment_id, page_id_t &page_id);
+
+  /**
+   * Create a segment, i.e. a file of its own, to store the pages of a new table or index in, so that its I/O does not
+   * contend with the other files and dropping it only removes the file.
+   * @return id of the segment, MAIN_SEGMENT_ID if this buffer pool does not support segments or none is left, in which
+   * case the pages go to the main database file
+   */
+  virtual segment_id_t CreateSegment() { return MAIN_SEGMENT_ID; }
+
+  /**
+   * Remove a segment with all its pages, which are dropped from the buffer pool without being written back. Its pages
+   * must not be in use.
+   * @return false if the segment does not exist, the main segment can not be dropped
+   */
+  virtual bool DropSegment(__attribute__((unused)) segment_id_t segment_id) { return false; }
+
+  virtual bool DeletePage(page_id_t page_id);
+
+  /**
+   * Move a page to the lowest free page of its file if one lies before it, see DiskManager::AllocatePageBelow, to
+   * compact the file. Its content is copied and the old page is deleted. The page must not be in use, and the caller
+   * must fix every reference to the old page id, including the one the page may keep in its own header.
+   * @param new_page_id id of the page it has moved to, INVALID_PAGE_ID if it has not moved
+   * @return the page it has moved to, to be unpinned dirty like a page created by NewPage; nullptr if it has not moved
+   */
+  virtual Page *RelocatePage(page_id_t page_id, page_id_t &new_page_id);
+
+  /**
+   * Write the dirty pages back, then cut the free pages at the end of the files of the database off, see
+   * DiskManager::TruncateFile.
+   */
+  virtual void TruncateFiles();
+
+  virtual bool IsPageFree(page_id_t page_id);
+
+  virtual bool CheckAllUnpinned();
+
+  /** @return true if the pages can only be read, in which case no page can be created, deleted or written back */
+  virtual bool IsReadOnly() const { return false; }
+
+  /** @return the number of frames managed by this buffer pool */
+  virtual size_t GetPoolSize() { return pool_size_; }
+
+  /**
+   * Change the number of frames while the buffer pool is in use. Growing adds free frames; shrinking evicts the pages
+   * of the frames beyond the new size, writing dirty ones back, and gives their memory back to the system.
+   * @return false if the new size is zero or above the limit, or if a page to evict is in use, in which case the size
+   * is left unchanged
+   */
+  virtual bool Resize(size_t pool_size);
+
+  /**
+   * Start a background writer which evicts unpinned pages (writing dirty ones back to disk) whenever fewer than
+   * low_watermark frames are free, until high_watermark frames are free again, so that most misses find a clean frame
+   * without doing any write themselves. Calling it again while the writer is running only changes the watermarks.
+   */
+  virtual void StartBackgroundWriter(size_t low_watermark, size_t high_watermark);
+
+  /**
+   * Stop the background writer and wait for it to exit, no-op if it is not running.
+   */
+  virtual void StopBackgroundWriter();
+
+  /**
+   * Ask the I/O workers to bring pages into the buffer pool, unpinned, without waiting for them. Pages which are
+   * already cached, or which can not get a frame, are skipped.
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * Ask the I/O workers to bring up to count pages of a linked list into the buffer pool, starting at page_id. The
+   * workers follow the list by calling next_page_id on each page once it is cached.
+   */
+  void PrefetchChain(page_id_t page_id, size_t count, NextPageIdFunc next_page_id);
+
+  /**
+   * @return ids of the cached pages, the coldest first in the order of the replacer, unevictable pages last
+   */
+  virtual std::vector<page_id_t> GetResidentPageIds();
+
+  /**
+   * Save the ids of the cached pages to file_name, so that the buffer pool of the next run can be warmed up with them.
+   * @return false if the file can not be written
+   */
+  bool DumpResidentPages(const std::string &file_name);
+
+  /**
+   * Read the page ids saved by DumpResidentPages.
+   * @return the page ids, coldest first, empty if the file does not exist or is corrupted
+   */
+  static std::vector<page_id_t> LoadResidentPages(const std::string &file_name);
+
+  /**
+   * Bring pages into the buffer pool in the background. They are read in physical order, then handed to the replacer
+   * again from the coldest to the hottest to restore its order. Pages beyond the size of the pool are skipped, coldest
+   * first.
+   */
+  virtual void StartWarmUp(std::vector<page_id_t> page_ids);
+
+  /**
+   * Let the pages of another database file be cached in this buffer pool.
+   * @return id of the file in this buffer pool, INVALID_FILE_ID if MAX_BUFFER_POOL_FILES files are attached already
+   */
+  file_id_t AttachFile(DiskManager *disk_manager);
+
+  /**
+   * Write the cached pages of a file back and drop them, then forget the file. The pages must not be in use, only the
+   * short pins of the background writer are waited for; a page still pinned after that is a fatal error.
+   * @param write_back false to drop dirty pages without writing them back, for a file which is about to be removed
+   */
+  void DetachFile(file_id_t file_id, bool write_back = true);
+
+  Page *FetchPage(file_id_t file_id, page_id_t page_id, BufferAccessStrategy *strategy);
+
+  bool UnpinPage(file_id_t file_id, page_id_t page_id, bool is_dirty);
+
+  bool FlushPage(file_id_t file_id, page_id_t page_id);
+
+  Page *NewPage(file_id_t file_id, page_id_t &page_id);
+
+  Page *NewPageNear(file_id_t file_id, page_id_t &page_id, page_id_t near_page_id);
+
+  bool DeletePage(file_id_t file_id, page_id_t page_id);
+
+  Page *RelocatePage(file_id_t file_id, page_id_t page_id, page_id_t &new_page_id);
+
+  bool CheckAllUnpinned(file_id_t file_id);
+
+  /**
+   * @return ids of the cached pages of a file, the coldest first in the order of the replacer, unevictable pages last
+   */
+  std::vector<page_id_t> GetResidentPageIds(file_id_t file_id);
+
+ protected:
+  /**
+   * Create a buffer pool without any frame of its own, used by buffer pools which only dispatch requests to others.
+   */
+  explicit BufferPoolManager(DiskManager *disk_manager);
 
- private:
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
    */
   page_id_t AllocatePage();
 
+  /**
+   * Allocate a page close to near_page_id, see DiskManager::AllocatePageNear
+   */
+  page_id_t AllocatePageNear(page_id_t near_page_id);
+
   /**
    * Deallocate page (operations like drop index/table) Need bitmap in header page for tracking pages
    */
   void DeallocatePage(page_id_t page_id);
 
-  frame_id_t TryToFindFreePage();
+  /**
+   * Bring a page into the buffer pool unpinned, reading it from disk without holding latch_. The page is dropped if it
+   * was loaded into a frame or deleted while it was being read, writes of other pages do not matter.
+   * @param next_page_id to read the id of the next page once the page is cached, may be nullptr
+   * @return id of the next page, INVALID_PAGE_ID if there is none or the page could not be cached
+   */
+  virtual page_id_t PrefetchPage(page_id_t page_id, NextPageIdFunc next_page_id);
+
+  page_id_t PrefetchPage(file_id_t file_id, page_id_t page_id, NextPageIdFunc next_page_id);
+
+  /**
+   * Bring pages into the buffer pool unpinned like PrefetchPage, submitting the reads of the missing ones together.
+   * Each page is checked on its own, only the pages loaded into a frame or deleted while they were read are dropped.
+   */
+  virtual void PrefetchBatch(const std::vector<page_id_t> &page_ids);
+
+  void PrefetchBatch(file_id_t file_id, const std::vector<page_id_t> &page_ids);
+
+  /**
+   * Register a prefetch read of a page which is not cached, before reading it without latch_. Caller must hold latch_.
+   */
+  void BeginPrefetchRead(file_id_t file_id, page_id_t page_id);
+
+  /**
+   * Unregister a prefetch read after it completed. Caller must hold latch_.
+   * @return false if the page was loaded into a frame or deleted meanwhile, so the data read may be stale
+   */
+  bool EndPrefetchRead(file_id_t file_id, page_id_t page_id);
+
+  /**
+   * Hand the cached pages among page_ids to the replacer again, from the first to the last, so that they are evicted
+   * in that order.
+   */
+  virtual void RestoreEvictionOrder(const std::vector<page_id_t> &page_ids);
+
+  void RestoreEvictionOrder(file_id_t file_id, const std::vector<page_id_t> &page_ids);
+
+  /**
+   * Stop the I/O workers and drop pending prefetch requests. Must be called before the frames are destroyed.
+   */
+  void StopIOWorkers();
 
  private:
-  size_t pool_size_;                                 // number of pages in buffer pool
-  Page *pages_;                                      // array of pages
+  /**
+   * Bring a page of a file which has already been allocated on disk into a free frame, pinned by the caller.
+   * @return nullptr if all the frames are pinned
+   */
+  Page *NewPageWithId(file_id_t file_id, page_id_t page_id);
+
+  /**
+   * Allocate a page of a file and bring it into a free frame.
+   * @param near_page_id allocation hint passed to DiskManager::AllocatePageNear, nullptr to take any free page
+   * @return nullptr if all the frames are pinned or the file is full
+   */
+  Page *NewPageWithHint(file_id_t file_id, page_id_t &page_id, const page_id_t *near_page_id);
+
+  /** @return the disk manager of an attached file */
+  DiskManager *GetDiskManager(file_id_t file_id) { return files_[file_id]; }
+
+  /**
+   * Pick a frame from the free list, or evict a victim from the replacer (writing it back if dirty).
+   * @return id of a frame which is not bound to any page, INVALID_FRAME_ID if all the frames are pinned
+   */
+  frame_id_t TryToFindFreePage();
+
+  /**
+   * Take back the frame of a ring slot if it is unpinned and still holds the page the ring loaded into it.
+   * @return id of the frame which is not bound to any page now, INVALID_FRAME_ID if the frame can not be reused
+   */
+  frame_id_t TryToReuseRingFrame(const BufferAccessStrategy::Slot &slot);
+
+  /**
+   * Unbind a frame from its page, writing the page back if it is dirty. Caller must hold latch_.
+   * @return false if the frame is pinned, or not bound to any page
+   */
+  bool EvictFrame(frame_id_t frame_id);
+
+  /**
+   * Pin a cached page on the hit path, under the read latch of its page table stripe.
+   * @return the page, nullptr if the page is not cached
+   */
+  Page *PinCachedPage(file_id_t file_id, page_id_t page_id);
+
+  /**
+   * Wake the background writer up if the free list has fallen below the low watermark. Caller must hold latch_.
+   */
+  void WakeBackgroundWriterIfNeeded();
+
+  /**
+   * Main loop of the background writer thread.
+   */
+  void BackgroundWriterLoop();
+
+  /**
+   * Evict up to IO_URING_QUEUE_DEPTH victims into the free list if it holds fewer than high_watermark_ frames. Dirty
+   * victims are written back together without holding latch_, and a victim stays cached if it is pinned or dirtied
+   * again meanwhile.
+   * @return false if there is nothing to do
+   */
+  bool WriteBackVictims();
+
+  /**
+   * Write the pages of frames back to disk, one batch per file. Each page is copied out under its read latch so that
+   * no two page latches are held at once. The frames must stay bound to their pages until it returns.
+   */
+  void WriteBackFrames(const std::vector<frame_id_t> &frame_ids);
+
+  /**
+   * Write the dirty pages of a file back without syncing it, or the dirty pages of every file if file_id is
+   * INVALID_FILE_ID. The pages are pinned while they are written so that they are not evicted.
+   */
+  void WriteBackDirtyPages(file_id_t file_id);
+
+  /**
+   * Bind a free frame to a page read by a prefetch, unpinned. Caller must hold latch_.
+   * @return the page, nullptr if it is cached already or no frame is available
+   */
+  Page *InstallPrefetchedPage(file_id_t file_id, page_id_t page_id, const char *data);
+
+  /**
+   * Mark the prefetch reads in flight of a page as stale, called whenever the page is bound to a frame or deleted.
+   * A page can only be written after it is bound to a frame. Caller must hold latch_.
+   */
+  void InvalidatePrefetchReads(file_id_t file_id, page_id_t page_id);
+
+  /**
+   * Queue a prefetch request, starting the I/O workers on first use.
+   */
+  void EnqueuePrefetch(page_id_t page_id, size_t count, NextPageIdFunc next_page_id);
+
+  /**
+   * Main loop of an I/O worker thread.
+   */
+  void IOWorkerLoop();
+
+  /**
+   * Body of the warm-up thread, which stops early once the I/O workers are stopped.
+   */
+  void WarmUpLoop(std::vector<page_id_t> page_ids);
+
+  /** @return true once StopIOWorkers has been called */
+  bool IOWorkersStopped();
+
+  /** @return the descriptor of a frame, which must be below pool_size_ */
+  Page &GetFrame(frame_id_t frame_id) {
+    return chunks_[frame_id / BUFFER_POOL_CHUNK_PAGES].pages_[frame_id % BUFFER_POOL_CHUNK_PAGES];
+  }
+
+  /**
+   * Construct the frames from pool_size_ up to pool_size, reserving the memory of new chunks, and add them to the
+   * free list. Caller must hold latch_.
+   * @throw std::bad_alloc if a chunk can not be mapped
+   */
+  void AddFrames(size_t pool_size);
+
+  /**
+   * Destroy the frames from pool_size up to pool_size_, which must not be bound to any page, and release their memory.
+   * Caller must hold latch_.
+   */
+  void RemoveFrames(size_t pool_size);
+
+  /**
+   * Map the page-aligned, zeroed data of a chunk of BUFFER_POOL_CHUNK_PAGES frames and allocate their descriptors. The
+   * data is aligned to huge pages if BUFFER_POOL_HUGE_PAGES is set and the chunk is going to be full.
+   * @throw std::bad_alloc if the data can not be mapped
+   */
+  void AllocateChunk(size_t chunk_index, bool full);
+
+  /**
+   * Create the replacer of the given policy for num_pages frames
+   */
+  static Replacer *CreateReplacer(ReplacerType replacer_type, size_t num_pages);
+
+ protected:
+  /** Frames allocated together, their descriptors and data never move while the chunk exists */
+  struct FrameChunk {
+    Page *pages_{nullptr};     // descriptors of the frames, the first ones below pool_size_ are constructed
+    char *data_{nullptr};      // page data of the frames, pages_[i] owns the i-th page
+    void *mapping_{nullptr};   // start of the mapping which holds data_
+    size_t mapping_size_{0};   // length of the mapping which holds data_
+  };
+
+  /** Prefetch reads of a page done without latch_ */
+  struct PrefetchRead {
+    size_t readers_{0};  // number of reads in flight
+    bool stale_{false};  // the page was bound to a frame or deleted since the oldest read in flight began
+  };
+
+  std::atomic<size_t> pool_size_;                    // number of pages in buffer pool, only changed under latch_
+  std::vector<FrameChunk> chunks_;                   // never reallocated, frame i lives in chunk i / CHUNK_PAGES
+  ReplacerType replacer_type_;                       // policy of replacer_, kept to rebuild it when resizing
   DiskManager *disk_manager_;                        // pointer to the disk manager.
-  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
+  std::vector<DiskManager *> files_;                 // never reallocated, indexed by file id, changed under latch_
+  PageTable page_table_;                             // to keep track of pages, latched by itself
   Replacer *replacer_;                               // to find an unpinned page for replacement
+  std::mutex replacer_latch_;                        // to protect replacer_, only stripes are latched under it
   list<frame_id_t> free_list_;                       // to find a free page for replacement
-  recursive_mutex latch_;                            // to protect shared data structure
+  recursive_mutex latch_;                            // to protect free_list_ and the binding of frames to pages
+
+  std::unordered_map<uint64_t, PrefetchRead> prefetch_reads_;  // reads in flight by PageTable::MakeKey, under latch_
+
+ private:
+  struct PrefetchRequest {
+    page_id_t page_id_;
+    size_t count_;  // number of pages of the chain left to prefetch, including this one
+    NextPageIdFunc next_page_id_;
+  };
+
+  std::thread writer_thread_;              // background writer, not joinable if it is not running
+  std::atomic<size_t> low_watermark_{0};   // wake the writer up below this number of free frames
+  std::atomic<size_t> high_watermark_{0};  // the writer stops evicting at this number of free frames
+  std::mutex writer_latch_;                // to protect writer_stop_ and writer_wakeup_
+  std::condition_variable writer_cv_;      // to wake the writer up
+  bool writer_stop_{false};                // the writer should exit
+  bool writer_wakeup_{false};              // the free list has fallen below the low watermark
+  std::vector<std::thread> io_workers_;    // started on the first prefetch request
+  std::thread warm_up_thread_;             // not joinable if no warm-up has been started
+  std::deque<PrefetchRequest> prefetch_queue_;
+  std::mutex prefetch_latch_;              // to protect io_workers_, prefetch_queue_ and io_workers_stop_
+  std::condition_variable prefetch_cv_;    // to wake the I/O workers up
+  bool io_workers_stop_{false};            // the I/O workers should exit
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
@@ -42,6 +42,8 @@ class CLOCKReplacer : public Replacer {
 
   void Reset(frame_id_t frame_id) override;
 
+  std::vector<frame_id_t> GetEvictionOrder() override;
+
  private:
   frame_id_t clock_hand_;
   std::vector<std::pair<bool, bool>> frames_;
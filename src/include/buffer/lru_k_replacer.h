@@ -0,0 +1,65 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+using namespace std;
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The replacer remembers the timestamps of the last K accesses of every frame. The victim is the evictable frame whose
+ * backward K-distance, i.e. the time elapsed since its K-th most recent access, is the largest. A frame accessed fewer
+ * than K times has an infinite backward K-distance; ties among such frames are broken by plain LRU on their earliest
+ * access. So a page touched once by a large scan is evicted before a page which is accessed again and again.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k number of accesses remembered for each frame
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = DEFAULT_LRUK_REPLACER_K);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  /**
+   * Pins a frame and records an access to it.
+   */
+  void Pin(frame_id_t frame_id) override;
+
+  /**
+   * Unpins a frame. A frame which is not tracked yet (e.g. a new page) starts with one access.
+   */
+  void Unpin(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  void Reset(frame_id_t frame_id) override;
+
+  std::vector<frame_id_t> GetEvictionOrder() override;
+
+ private:
+  void RecordAccess(frame_id_t frame_id);
+
+ private:
+  size_t k_;
+  uint64_t current_timestamp_{0};
+  vector<deque<uint64_t>> history_;  // timestamps of the last k accesses of each frame, oldest first
+  vector<bool> is_evictable_;
+  size_t evictable_size_{0};
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
@@ -38,6 +38,8 @@ class LRUReplacer : public Replacer {
 
   void Reset(frame_id_t frame_id) override;
 
+  std::vector<frame_id_t> GetEvictionOrder() override;
+
  private:
   // add your own private member variables here
   vector<int32_t> frame_used;   // 记录缓冲区每一页帧的访问次数
@@ -0,0 +1,97 @@
+#ifndef MINISQL_PAGE_TABLE_H
+#define MINISQL_PAGE_TABLE_H
+
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+/**
+ * PageTable maps the pages cached by a buffer pool, identified by their file and their id in the file, to their frames.
+ * The map is split into stripes, each of which is protected by its own reader-writer latch, so lookups never block
+ * each other and only contend with updates of pages in the same stripe.
+ */
+class PageTable {
+ public:
+  explicit PageTable(size_t num_stripes = DEFAULT_PAGE_TABLE_STRIPES) : stripes_(num_stripes) {
+    ASSERT(num_stripes > 0, "Page table needs at least one stripe.");
+  }
+
+  DISALLOW_COPY(PageTable)
+
+  /**
+   * Look a page up and call func(frame_id) while holding the read latch of its stripe, so that the page can not be
+   * removed from the table before func returns.
+   * @return false if the page is not in the table
+   */
+  template <typename Func>
+  bool Find(file_id_t file_id, page_id_t page_id, Func &&func) {
+    uint64_t key = MakeKey(file_id, page_id);
+    Stripe &stripe = GetStripe(key);
+    std::shared_lock<std::shared_mutex> lock(stripe.latch_);
+    auto iter = stripe.map_.find(key);
+    if (iter == stripe.map_.end()) {
+      return false;
+    }
+    func(iter->second);
+    return true;
+  }
+
+  /** @return the frame holding the page, INVALID_FRAME_ID if the page is not in the table */
+  frame_id_t Find(file_id_t file_id, page_id_t page_id) {
+    frame_id_t frame_id = INVALID_FRAME_ID;
+    Find(file_id, page_id, [&frame_id](frame_id_t found) { frame_id = found; });
+    return frame_id;
+  }
+
+  void Insert(file_id_t file_id, page_id_t page_id, frame_id_t frame_id) {
+    uint64_t key = MakeKey(file_id, page_id);
+    Stripe &stripe = GetStripe(key);
+    std::scoped_lock<std::shared_mutex> lock(stripe.latch_);
+    stripe.map_[key] = frame_id;
+  }
+
+  /**
+   * Remove a page if pred(frame_id) holds, evaluating pred under the write latch of its stripe so that no lookup of the
+   * page runs concurrently.
+   * @return true if the page was removed
+   */
+  template <typename Pred>
+  bool EraseIf(file_id_t file_id, page_id_t page_id, Pred &&pred) {
+    uint64_t key = MakeKey(file_id, page_id);
+    Stripe &stripe = GetStripe(key);
+    std::scoped_lock<std::shared_mutex> lock(stripe.latch_);
+    auto iter = stripe.map_.find(key);
+    if (iter == stripe.map_.end() || !pred(iter->second)) {
+      return false;
+    }
+    stripe.map_.erase(iter);
+    return true;
+  }
+
+  /** Pack a file id and a page id into the key of the maps. */
+  static uint64_t MakeKey(file_id_t file_id, page_id_t page_id) {
+    return (static_cast<uint64_t>(file_id) << 32) | static_cast<uint32_t>(page_id);
+  }
+
+ private:
+  struct alignas(64) Stripe {
+    std::shared_mutex latch_;
+    std::unordered_map<uint64_t, frame_id_t> map_;
+  };
+
+  Stripe &GetStripe(uint64_t key) {
+    // page ids of a buffer pool shard share a residue, so mix the bits before picking a stripe
+    uint64_t hash = (key ^ (key >> 29)) * 0x9E3779B97F4A7C15ULL;
+    return stripes_[(hash >> 32) % stripes_.size()];
+  }
+
+ private:
+  std::vector<Stripe> stripes_;
+};
+
+#endif  // MINISQL_PAGE_TABLE_H
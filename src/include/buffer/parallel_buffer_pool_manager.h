@@ -0,0 +1,106 @@
+#ifndef MINISQL_PARALLEL_BUFFER_POOL_MANAGER_H
+#define MINISQL_PARALLEL_BUFFER_POOL_MANAGER_H
+
+#include <mutex>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+/**
+ * ParallelBufferPoolManager splits the frames into several independent BufferPoolManager instances (shards), each of
+ * which has its own page table, free list, replacer and latch. A page is always cached by the shard chosen by hashing
+ * its page id, so requests for different pages mostly take different latches.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @param num_instances number of shards
+   * @param pool_size total number of frames, divided evenly among the shards
+   * @param disk_manager disk manager shared by all the shards
+   * @param replacer_type replacement policy of every shard
+   */
+  explicit ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                     ReplacerType replacer_type = ReplacerType::LRU);
+
+  ~ParallelBufferPoolManager() override;
+
+  Page *FetchPage(page_id_t page_id) override;
+
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  bool FlushPage(page_id_t page_id) override;
+
+  Page *NewPage(page_id_t &page_id) override;
+
+  /**
+   * Write the dirty pages of every shard back, then sync the file once.
+   */
+  void FlushAllPages() override;
+
+  Page *NewPageNear(page_id_t &page_id, page_id_t near_page_id) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  /** Move a page within the shared file, the page it moves to may belong to another shard. */
+  Page *RelocatePage(page_id_t page_id, page_id_t &new_page_id) override;
+
+  bool CheckAllUnpinned() override;
+
+  size_t GetPoolSize() override;
+
+  /**
+   * Resize every shard, the frames are divided evenly among the shards.
+   * @return false if any shard could not be resized, the shards resized before it keep their new size
+   */
+  bool Resize(size_t pool_size) override;
+
+  /**
+   * Start a background writer in every shard, the watermarks are divided evenly among the shards.
+   */
+  void StartBackgroundWriter(size_t low_watermark, size_t high_watermark) override;
+
+  void StopBackgroundWriter() override;
+
+  /**
+   * @return ids of the cached pages of every shard in turn, each shard's coldest first
+   */
+  std::vector<page_id_t> GetResidentPageIds() override;
+
+  /**
+   * Warm every shard up with its own pages, in parallel.
+   */
+  void StartWarmUp(std::vector<page_id_t> page_ids) override;
+
+ protected:
+  /**
+   * Prefetch the page into its shard, the I/O workers of this buffer pool serve the requests of all the shards.
+   */
+  page_id_t PrefetchPage(page_id_t page_id, NextPageIdFunc next_page_id) override;
+
+  /**
+   * Split the batch among the shards, each shard reads its own pages together.
+   */
+  void PrefetchBatch(const std::vector<page_id_t> &page_ids) override;
+
+  /** @return the number of shards */
+  size_t GetNumInstances() const { return instances_.size(); }
+
+ private:
+  /** @return the shard responsible for page_id */
+  BufferPoolManager *GetBufferPoolManager(page_id_t page_id);
+
+  /**
+   * Bring a page just allocated into a frame of its shard, giving the page back to disk if the shard is full of
+   * pinned pages. Caller must hold allocate_latch_.
+   */
+  Page *NewPageInShard(page_id_t &page_id);
+
+ private:
+  std::vector<BufferPoolManager *> instances_;
+  // serialize page allocation so that the shard of a new page is known before its frame is taken
+  std::mutex allocate_latch_;
+};
+
+#endif  // MINISQL_PARALLEL_BUFFER_POOL_MANAGER_H
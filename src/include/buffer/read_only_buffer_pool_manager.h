@@ -0,0 +1,104 @@
+#ifndef MINISQL_READ_ONLY_BUFFER_POOL_MANAGER_H
+#define MINISQL_READ_ONLY_BUFFER_POOL_MANAGER_H
+
+#include <atomic>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+/**
+ * ReadOnlyBufferPoolManager serves the pages of a database file opened in read-only mode straight from the mapping of
+ * the file, see DiskManager::GetMappedPage. It owns no frame: a page is never copied, and the descriptor handed out
+ * for it points into the mapping, so there is nothing to evict and no replacer. Caching the pages is left to the page
+ * cache of the kernel.
+ *
+ * The page data is mapped read-only, so writing to a page faults. Pages can not be created, deleted or written back.
+ */
+class ReadOnlyBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @param disk_manager disk manager of a file opened in read-only mode
+   * @throw std::invalid_argument if the file is not opened in read-only mode, or is compressed
+   */
+  explicit ReadOnlyBufferPoolManager(DiskManager *disk_manager);
+
+  ~ReadOnlyBufferPoolManager() override;
+
+  /**
+   * Pin a page of the mapping.
+   * @return nullptr if the page lies beyond the end of the file
+   */
+  Page *FetchPage(page_id_t page_id) override;
+
+  /** Same as FetchPage(page_id), there is no frame to load the page into. */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Unpin a page. The page can not have been written to, so is_dirty is ignored.
+   */
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  /** @return false, no page is ever written back */
+  bool FlushPage(page_id_t page_id) override;
+
+  /** No-op, no page is ever dirty. */
+  void FlushAllPages() override;
+
+  /** @return nullptr, no page can be created */
+  Page *NewPage(page_id_t &page_id) override;
+
+  /** @return nullptr, no page can be created */
+  Page *NewPageNear(page_id_t &page_id, page_id_t near_page_id) override;
+
+  /** @return false, no page can be deleted */
+  bool DeletePage(page_id_t page_id) override;
+
+  /** @return nullptr, no page can be moved */
+  Page *RelocatePage(page_id_t page_id, page_id_t &new_page_id) override;
+
+  bool CheckAllUnpinned() override;
+
+  bool IsReadOnly() const override { return true; }
+
+  /** @return the number of pages the mapping can hold */
+  size_t GetPoolSize() override { return pages_.size(); }
+
+  /** @return false, the mapping always covers the whole file */
+  bool Resize(size_t pool_size) override;
+
+  /** No-op, there is nothing to write back. */
+  void StartBackgroundWriter(size_t low_watermark, size_t high_watermark) override;
+
+  void StopBackgroundWriter() override;
+
+  /** @return no page id, which pages of the file are resident is only known to the kernel */
+  std::vector<page_id_t> GetResidentPageIds() override;
+
+  /** No-op, pages are not cached by the buffer pool. */
+  void StartWarmUp(std::vector<page_id_t> page_ids) override;
+
+ protected:
+  /**
+   * Follow a linked list of pages without reading ahead, the kernel reads the pages of the mapping ahead by itself.
+   */
+  page_id_t PrefetchPage(page_id_t page_id, NextPageIdFunc next_page_id) override;
+
+  /**
+   * Ask the kernel to read the pages of the mapping ahead, without waiting for them.
+   */
+  void PrefetchBatch(const std::vector<page_id_t> &page_ids) override;
+
+  void RestoreEvictionOrder(const std::vector<page_id_t> &page_ids) override;
+
+ private:
+  /**
+   * @return the descriptor of a page, created on first use, nullptr if the page lies beyond the end of the file
+   */
+  Page *GetPage(page_id_t page_id);
+
+ private:
+  // descriptors of the pages indexed by logical page id, nullptr until first fetched, never reallocated
+  std::vector<std::atomic<Page *>> pages_;
+};
+
+#endif  // MINISQL_READ_ONLY_BUFFER_POOL_MANAGER_H
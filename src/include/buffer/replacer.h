@@ -2,9 +2,13 @@
 #define MINISQL_REPLACER_H
 
 #include <cstdio>
+#include <vector>
 
 #include "common/config.h"
 
+/** Replacement policies which a buffer pool can be built with. */
+enum class ReplacerType { LRU = 0, CLOCK, LRU_K };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -37,6 +41,11 @@ class Replacer {
   virtual size_t Size() = 0;
 
   virtual void Reset(frame_id_t frame_id) = 0;
+
+  /**
+   * @return the frames that can be victimized, in the order they would be victimized
+   */
+  virtual std::vector<frame_id_t> GetEvictionOrder() = 0;
 };
 
 #endif  // MINISQL_REPLACER_H
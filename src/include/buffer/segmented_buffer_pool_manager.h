@@ -0,0 +1,149 @@
+#ifndef MINISQL_SEGMENTED_BUFFER_POOL_MANAGER_H
+#define MINISQL_SEGMENTED_BUFFER_POOL_MANAGER_H
+
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+/**
+ * SegmentedBufferPoolManager stores each table and index of a database in a segment file of its own, next to the main
+ * database file, see CreateSegment. Every file has its own disk manager, so the I/O of different tables and indexes
+ * does not contend on one file descriptor and one latch, and dropping a table or an index removes its file instead of
+ * freeing its pages one by one.
+ *
+ * The segment of a page is carried by the high bits of its id, see DiskManager::SegmentOf, and requests are routed to
+ * the file of the segment. The main file, segment MAIN_SEGMENT_ID, keeps the catalog and the pages created through
+ * NewPage. Segment N of database file F is stored in F.segN, and the segment files which exist are opened on
+ * construction.
+ *
+ * The frames are those of a single buffer pool to which every file is attached, either owned by this buffer pool or
+ * shared with other databases, see SharedBufferPoolManager. Pages are not spread over several buffer pool instances.
+ */
+class SegmentedBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Cache the pages of the database in a buffer pool of its own.
+   * @param disk_manager disk manager of the main database file, whose options are used for the segment files
+   * @throw std::exception if a segment file can not be opened
+   */
+  explicit SegmentedBufferPoolManager(size_t pool_size, DiskManager *disk_manager,
+                                      ReplacerType replacer_type = ReplacerType::LRU);
+
+  /**
+   * Cache the pages of the database in a buffer pool shared with other databases, which must outlive this one.
+   * @throw std::length_error if too many files are attached to the shared buffer pool
+   * @throw std::exception if a segment file can not be opened
+   */
+  SegmentedBufferPoolManager(BufferPoolManager *shared_pool, DiskManager *disk_manager);
+
+  ~SegmentedBufferPoolManager() override;
+
+  Page *FetchPage(page_id_t page_id) override;
+
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  bool FlushPage(page_id_t page_id) override;
+
+  /**
+   * Write the dirty pages of the database back and sync its files.
+   */
+  void FlushAllPages() override;
+
+  /** Create a page in the main file. */
+  Page *NewPage(page_id_t &page_id) override;
+
+  /** Create a page in the segment of near_page_id, in the main file if it is INVALID_PAGE_ID. */
+  Page *NewPageNear(page_id_t &page_id, page_id_t near_page_id) override;
+
+  Page *NewPageInSegment(segment_id_t segment_id, page_id_t &page_id) override;
+
+  /**
+   * Create the file of the lowest free segment id.
+   * @return MAIN_SEGMENT_ID if all the MAX_SEGMENTS segments exist, or the file can not be created
+   */
+  segment_id_t CreateSegment() override;
+
+  /**
+   * Drop the pages of a segment from the buffer pool without writing them back, and remove its file.
+   */
+  bool DropSegment(segment_id_t segment_id) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  /** Move a page within the file of its segment. */
+  Page *RelocatePage(page_id_t page_id, page_id_t &new_page_id) override;
+
+  /** Write the dirty pages of the database back, then truncate the main file and every segment file. */
+  void TruncateFiles() override;
+
+  bool IsPageFree(page_id_t page_id) override;
+
+  bool CheckAllUnpinned() override;
+
+  size_t GetPoolSize() override { return pool_->GetPoolSize(); }
+
+  /**
+   * @return false if the buffer pool is shared, it can only be resized by its owner
+   */
+  bool Resize(size_t pool_size) override;
+
+  /** No-op if the buffer pool is shared, its background writer is started by its owner. */
+  void StartBackgroundWriter(size_t low_watermark, size_t high_watermark) override;
+
+  void StopBackgroundWriter() override;
+
+  /**
+   * @return ids of the cached pages of the database, file by file, the coldest first within each file
+   */
+  std::vector<page_id_t> GetResidentPageIds() override;
+
+  /** @return name of the file of a segment of a database file */
+  static std::string GetSegmentFileName(const std::string &db_file, segment_id_t segment_id);
+
+  /** Remove the segment files of a database file, for a database which is created anew. */
+  static void RemoveSegmentFiles(const std::string &db_file);
+
+  /** @return true if a database file has segment files */
+  static bool HasSegmentFiles(const std::string &db_file);
+
+ protected:
+  page_id_t PrefetchPage(page_id_t page_id, NextPageIdFunc next_page_id) override;
+
+  /** Prefetch the pages of each segment as a batch of its own. */
+  void PrefetchBatch(const std::vector<page_id_t> &page_ids) override;
+
+  void RestoreEvictionOrder(const std::vector<page_id_t> &page_ids) override;
+
+ private:
+  /** Attach the main file to the buffer pool and open the existing segment files. */
+  void OpenSegments();
+
+  /**
+   * Open the file of a segment and attach it to the buffer pool. Caller must hold segment_latch_ exclusively.
+   * @return false if too many files are attached to the buffer pool
+   */
+  bool AttachSegment(segment_id_t segment_id);
+
+  /** @return id of the file of the segment of a page in the buffer pool, INVALID_FILE_ID if it does not exist */
+  file_id_t GetFileId(page_id_t page_id);
+
+  /** @return ids of the files of the existing segments in the buffer pool */
+  std::vector<file_id_t> GetFileIds();
+
+ private:
+  std::unique_ptr<BufferPoolManager> owned_pool_;  // buffer pool of this database, nullptr if it is shared
+  BufferPoolManager *pool_;                        // buffer pool holding the frames
+  std::shared_mutex segment_latch_;                // to protect the members below
+  // disk managers of the segment files indexed by segment id, nullptr if the segment does not exist; the main file is
+  // not owned and left nullptr
+  std::vector<std::unique_ptr<DiskManager>> segments_;
+  // ids of the files of the segments in pool_ indexed by segment id, INVALID_FILE_ID if the segment does not exist
+  std::vector<file_id_t> file_ids_;
+};
+
+#endif  // MINISQL_SEGMENTED_BUFFER_POOL_MANAGER_H
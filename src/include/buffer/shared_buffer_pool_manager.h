@@ -0,0 +1,87 @@
+#ifndef MINISQL_SHARED_BUFFER_POOL_MANAGER_H
+#define MINISQL_SHARED_BUFFER_POOL_MANAGER_H
+
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+/**
+ * SharedBufferPoolManager caches the pages of one database file in a buffer pool shared with the files of other
+ * databases, so that the hot pages of every database compete for the same frames and the same replacer. It owns no
+ * frame: the file is attached to the shared buffer pool on construction and detached, after writing its pages back, on
+ * destruction. The shared buffer pool must outlive it, and its size and background writer are managed by its owner.
+ */
+class SharedBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @param shared_pool buffer pool holding the frames
+   * @param disk_manager disk manager of the database file whose pages are cached
+   * @throw std::length_error if MAX_BUFFER_POOL_FILES files are attached to the shared buffer pool already
+   */
+  explicit SharedBufferPoolManager(BufferPoolManager *shared_pool, DiskManager *disk_manager);
+
+  ~SharedBufferPoolManager() override;
+
+  Page *FetchPage(page_id_t page_id) override;
+
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+
+  bool FlushPage(page_id_t page_id) override;
+
+  Page *NewPage(page_id_t &page_id) override;
+
+  /**
+   * Write the dirty pages of this file back and sync it, the pages of other files are left alone.
+   */
+  void FlushAllPages() override;
+
+  Page *NewPageNear(page_id_t &page_id, page_id_t near_page_id) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  Page *RelocatePage(page_id_t page_id, page_id_t &new_page_id) override;
+
+  bool CheckAllUnpinned() override;
+
+  /** @return the number of frames of the shared buffer pool */
+  size_t GetPoolSize() override;
+
+  /**
+   * The shared buffer pool can only be resized by its owner.
+   * @return false
+   */
+  bool Resize(size_t pool_size) override;
+
+  /**
+   * No-op, the background writer of the shared buffer pool is started by its owner.
+   */
+  void StartBackgroundWriter(size_t low_watermark, size_t high_watermark) override;
+
+  void StopBackgroundWriter() override;
+
+  /**
+   * @return ids of the cached pages of this file, the coldest first
+   */
+  std::vector<page_id_t> GetResidentPageIds() override;
+
+  /** @return id of the file in the shared buffer pool */
+  file_id_t GetFileId() const { return file_id_; }
+
+ protected:
+  /**
+   * Prefetch a page of this file into the shared buffer pool, served by the I/O workers of this buffer pool.
+   */
+  page_id_t PrefetchPage(page_id_t page_id, NextPageIdFunc next_page_id) override;
+
+  void PrefetchBatch(const std::vector<page_id_t> &page_ids) override;
+
+  void RestoreEvictionOrder(const std::vector<page_id_t> &page_ids) override;
+
+ private:
+  BufferPoolManager *shared_pool_;
+  file_id_t file_id_;
+};
+
+#endif  // MINISQL_SHARED_BUFFER_POOL_MANAGER_H
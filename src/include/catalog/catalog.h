@@ -56,6 +56,18 @@ class CatalogMeta {
     return true;
   }
 
+  /**
+   * Delete table meta data and its meta page.
+   */
+  bool DeleteTableMetaPage(BufferPoolManager *bpm, table_id_t table_id) {
+    if (table_meta_pages_.find(table_id) == table_meta_pages_.end()) {
+      return false;
+    }
+    bpm->DeletePage(table_meta_pages_[table_id]);
+    table_meta_pages_.erase(table_id);
+    return true;
+  }
+
  private:
   CatalogMeta();
 
@@ -94,11 +106,23 @@ class CatalogManager {
 
   dberr_t DropIndex(const std::string &table_name, const std::string &index_name);
 
+  /**
+   * Compact the database files online: move the pages of every table and index towards the front of their files,
+   * fixing the links between the pages, the row ids held by the indexes and the root records of the indexes, then cut
+   * the free pages at the end of the files off. The catalog pages stay where they are. The tables must not be used
+   * meanwhile.
+   * @return DB_FAILED if the database is read-only
+   */
+  dberr_t Compact();
+
  private:
   dberr_t DropTable(table_id_t table_id);
 
   dberr_t FlushCatalogMetaPage() const;
 
+  /** Serialize the metadata of a table to its meta page again, after it has changed. */
+  void FlushTableMetaPage(table_id_t table_id);
+
   dberr_t LoadTable(const table_id_t table_id, const page_id_t page_id);
 
   dberr_t LoadIndex(const index_id_t index_id, const page_id_t page_id);
@@ -14,8 +14,11 @@ class IndexMetadata {
   friend class IndexInfo;
 
  public:
+  /**
+   * @param segment_id segment holding the pages of the index, see BufferPoolManager::CreateSegment
+   */
   static IndexMetadata *Create(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                               const std::vector<uint32_t> &key_map);
+                               const std::vector<uint32_t> &key_map, segment_id_t segment_id = MAIN_SEGMENT_ID);
 
   uint32_t SerializeTo(char *buf) const;
 
@@ -33,18 +36,22 @@ class IndexMetadata {
 
   inline index_id_t GetIndexId() const { return index_id_; }
 
+  inline segment_id_t GetSegmentId() const { return segment_id_; }
+
  private:
   IndexMetadata() = delete;
 
   explicit IndexMetadata(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                         const std::vector<uint32_t> &key_map);
+                         const std::vector<uint32_t> &key_map, segment_id_t segment_id);
 
  private:
   static constexpr uint32_t INDEX_METADATA_MAGIC_NUM = 344528;
+  static constexpr uint32_t INDEX_METADATA_SEGMENT_MAGIC_NUM = 344529;  // followed by the segment id after key_map_
   index_id_t index_id_;
   std::string index_name_;
   table_id_t table_id_;
   std::vector<uint32_t> key_map_; /** The mapping of index key to tuple key */
+  segment_id_t segment_id_;       /** The segment holding the pages of the index */
 };
 
 /**
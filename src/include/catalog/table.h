@@ -23,7 +23,7 @@ class TableMetadata {
    * will create new table schema and owned by mem heap
    */
   static TableMetadata *Create(table_id_t table_id, std::string table_name, page_id_t root_page_id,
-                               TableSchema *schema);
+                               TableSchema *schema, page_id_t free_space_map_page_id = INVALID_PAGE_ID);
 
   inline table_id_t GetTableId() const { return table_id_; }
 
@@ -33,17 +33,22 @@ class TableMetadata {
 
   inline Schema *GetSchema() const { return schema_; }
 
+  inline page_id_t GetFreeSpaceMapPageId() const { return free_space_map_page_id_; }
+
  private:
   TableMetadata() = delete;
 
-  TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema);
+  TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema,
+                page_id_t free_space_map_page_id);
 
  private:
   static constexpr uint32_t TABLE_METADATA_MAGIC_NUM = 344528;
+  static constexpr uint32_t TABLE_METADATA_FSM_MAGIC_NUM = 344530;  // the free space map page id follows schema_
   table_id_t table_id_;
   std::string table_name_;
   page_id_t root_page_id_;
   Schema *schema_;
+  page_id_t free_space_map_page_id_;  /** First page of the free space map, also the page directory of the table heap */
 };
 
 /**
@@ -73,6 +78,18 @@ class TableInfo {
 
   inline page_id_t GetRootPageId() const { return table_meta_->root_page_id_; }
 
+  /** Point the metadata at the first page of the table heap after it has moved, see TableHeap::Compact. */
+  inline void SetRootPageId(page_id_t root_page_id) { table_meta_->root_page_id_ = root_page_id; }
+
+  /**
+   * Record the free space map built for a table created without one, see TableHeap::Create, or the new place of its
+   * first page after compaction.
+   */
+  inline void SetFreeSpaceMapPageId(page_id_t page_id) { table_meta_->free_space_map_page_id_ = page_id; }
+
+  /** @return metadata of the table, to serialize to its meta page */
+  inline TableMetadata *GetTableMeta() const { return table_meta_; }
+
  private:
   explicit TableInfo(){};
 
@@ -8,13 +8,40 @@ static constexpr int INVALID_PAGE_ID = -1;   // invalid page id
 static constexpr int INVALID_FRAME_ID = -1;  // invalid recovery id
 static constexpr int INVALID_TXN_ID = -1;    // invalid recovery id
 static constexpr int INVALID_LSN = -1;       // invalid log sequence number
+static constexpr uint32_t INVALID_FILE_ID = UINT32_MAX;  // invalid file id
 
 static constexpr int META_PAGE_ID = 0;          // physical page id of the disk file meta info
 static constexpr int CATALOG_META_PAGE_ID = 0;  // logical page id of the catalog meta data
 static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index roots
 
-static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
-static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+static constexpr int PAGE_SIZE = 4096;                   // size of a data page in byte
+static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;   // default size of buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_INSTANCES = 1;  // default number of buffer pool shards
+static constexpr int DEFAULT_LRUK_REPLACER_K = 2;        // default number of accesses tracked by LRU-K
+static constexpr int DEFAULT_BUFFER_RING_SIZE = 32;      // default number of frames in a buffer access ring
+static constexpr int BG_WRITER_INTERVAL_MS = 100;        // period of the buffer pool background writer
+static constexpr int BG_WRITER_LOW_WATERMARK_PCT = 5;    // default percentage of free frames to start evicting
+static constexpr int BG_WRITER_HIGH_WATERMARK_PCT = 10;  // default percentage of free frames to stop evicting
+static constexpr int PREFETCH_IO_WORKERS = 2;            // number of I/O worker threads serving prefetch requests
+static constexpr int DEFAULT_PREFETCH_DISTANCE = 8;      // default number of pages read ahead by scans
+static constexpr int MORSEL_PAGES = 16;                  // pages taken at a time by a worker of a parallel scan
+static constexpr int MAX_SCAN_WORKERS = 32;              // max number of worker threads of a parallel scan
+static constexpr int DEFAULT_PAGE_TABLE_STRIPES = 64;    // default number of latched stripes of a page table
+static constexpr bool BUFFER_POOL_HUGE_PAGES = true;     // back the buffer pool data arena with transparent huge pages
+static constexpr int BUFFER_POOL_CHUNK_PAGES = 512;      // number of frames whose memory is reserved at a time
+static constexpr int MAX_BUFFER_POOL_CHUNKS = 4096;      // max number of frame chunks of a buffer pool
+static constexpr int MAX_BUFFER_POOL_FILES = 1024;       // max number of database files sharing a buffer pool
+static constexpr int DEFAULT_FILE_ID = 0;                // file id of the disk manager a buffer pool is built with
+static constexpr bool ENABLE_IO_URING = true;            // submit batched page I/O through io_uring if supported
+static constexpr int IO_URING_QUEUE_DEPTH = 64;          // max number of page requests in flight per thread
+static constexpr bool DEFAULT_DIRECT_IO = false;         // open database files with O_DIRECT, bypassing the page cache
+static constexpr int ALLOCATION_RUN_PAGES = 64;          // pages reserved at a time for a table or index to grow into
+static constexpr bool DEFAULT_PAGE_COMPRESSION = false;  // store the pages of new database files compressed
+static constexpr int COMPRESSION_SECTOR_SIZE = 256;      // unit of space allocation of compressed database files
+static constexpr bool DEFAULT_SEGMENT_FILES = false;     // store each table and index of new databases in its own file
+static constexpr int SEGMENT_PAGE_BITS = 25;             // low bits of a page id, numbering it within its segment
+static constexpr uint32_t MAX_SEGMENTS = 64;             // max number of segments of a database, the main one included
+static constexpr uint32_t MAIN_SEGMENT_ID = 0;           // segment of the pages of the main database file
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
 static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
@@ -22,6 +49,8 @@ static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of var
 // static std::string DB_META_FILE = "minisql.meta.db";
 
 using page_id_t = int32_t;
+using file_id_t = uint32_t;
+using segment_id_t = uint32_t;
 using frame_id_t = int32_t;
 using txn_id_t = int32_t;
 using lsn_t = int32_t;
@@ -5,6 +5,10 @@
 #include <string>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "buffer/read_only_buffer_pool_manager.h"
+#include "buffer/segmented_buffer_pool_manager.h"
+#include "buffer/shared_buffer_pool_manager.h"
 #include "catalog/catalog.h"
 #include "common/config.h"
 #include "common/dberr.h"
@@ -12,20 +16,53 @@
 #include "executor/execute_context.h"
 #include "storage/disk_manager.h"
 
+/** suffix of the file next to a database which lists the pages cached at its last clean shutdown */
+static constexpr char RESIDENT_PAGES_FILE_SUFFIX[] = ".resident";
+
 class DBStorageEngine {
  public:
-  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE);
+  /**
+   * @param shared_buffer_pool buffer pool shared with other databases to cache the pages of this one in, nullptr to
+   * give this database a buffer pool of its own built from buffer_pool_size, buffer_pool_instances and replacer_type
+   * @param read_only open an existing database which is never written, reading its pages in place from a memory mapping
+   * of the file, see ReadOnlyBufferPoolManager; the buffer pool parameters are ignored
+   * @param segment_files store each new table and index in a segment file of its own, see SegmentedBufferPoolManager;
+   * a database which has segment files already is always opened this way, and buffer_pool_instances is then ignored
+   * @throw std::invalid_argument if read_only is set along with init, or the database has segment files
+   */
+  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE,
+                           uint32_t buffer_pool_instances = DEFAULT_BUFFER_POOL_INSTANCES,
+                           ReplacerType replacer_type = ReplacerType::LRU,
+                           BufferPoolManager *shared_buffer_pool = nullptr, bool read_only = false,
+                           bool segment_files = DEFAULT_SEGMENT_FILES);
 
   ~DBStorageEngine();
 
   std::unique_ptr<ExecuteContext> MakeExecuteContext(Txn *txn);
 
+  /**
+   * Change the number of frames of the buffer pool while the database is open, and move the watermarks of the
+   * background writer along with it.
+   * @return false if the buffer pool could not be resized, or if it is shared with other databases
+   */
+  bool ResizeBufferPool(uint32_t buffer_pool_size);
+
+  /**
+   * Write the dirty pages of the database back and make them durable.
+   */
+  void Checkpoint() { bpm_->FlushAllPages(); }
+
+ private:
+  /** Start the background writer, or move its watermarks, according to the current size of the buffer pool */
+  void StartBackgroundWriter();
+
  public:
   DiskManager *disk_mgr_;
   BufferPoolManager *bpm_;
   CatalogManager *catalog_mgr_;
   std::string db_file_name_;
   bool init_;
+  bool read_only_;
 };
 
 #endif  // MINISQL_INSTANCE_H
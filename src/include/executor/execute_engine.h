@@ -22,12 +22,17 @@ extern "C" {
  */
 class ExecuteEngine {
  public:
-  ExecuteEngine();
+  /**
+   * @param shared_buffer_pool cache the pages of all the opened databases in one buffer pool of
+   * DEFAULT_BUFFER_POOL_SIZE frames, instead of giving every database a buffer pool of its own
+   */
+  explicit ExecuteEngine(bool shared_buffer_pool = false);
 
   ~ExecuteEngine() {
     for (auto it : dbs_) {
       delete it.second;
     }
+    delete shared_bpm_;
   }
 
   /**
@@ -40,8 +45,27 @@ class ExecuteEngine {
 
   void ExecuteInformation(dberr_t result);
 
+  /**
+   * Resize the buffer pool of an opened database, so that memory can be moved between databases without reopening
+   * them.
+   * @return DB_NOT_EXIST if the database is not opened, DB_FAILED if the buffer pool could not be resized or if it is
+   * shared
+   */
+  dberr_t ResizeBufferPool(const std::string &db_name, uint32_t buffer_pool_size);
+
+  /**
+   * Resize the buffer pool shared by all the opened databases.
+   * @return DB_FAILED if the buffer pool is not shared or could not be resized
+   */
+  dberr_t ResizeSharedBufferPool(uint32_t buffer_pool_size);
+
  private:
-  static std::unique_ptr<AbstractExecutor> CreateExecutor(ExecuteContext *exec_ctx, const AbstractPlanNodeRef &plan);
+  /**
+   * @param parallel whether a scan may run in parallel, which it must not under an executor changing the table, as
+   * the workers of the scan read the pages without latching them
+   */
+  static std::unique_ptr<AbstractExecutor> CreateExecutor(ExecuteContext *exec_ctx, const AbstractPlanNodeRef &plan,
+                                                          bool parallel = true);
 
   dberr_t ExecuteCreateDatabase(pSyntaxNode ast, ExecuteContext *context);
 
@@ -73,9 +97,13 @@ class ExecuteEngine {
 
   dberr_t ExecuteQuit(pSyntaxNode ast, ExecuteContext *context);
 
+  /** Open a database, in the shared buffer pool if there is one */
+  DBStorageEngine *OpenDatabase(const std::string &db_name, bool init);
+
  private:
   std::unordered_map<std::string, DBStorageEngine *> dbs_; /** all opened databases */
   std::string current_db_;                                 /** current database */
+  BufferPoolManager *shared_bpm_{nullptr};                 /** buffer pool of all databases, nullptr if not shared */
 };
 
 #endif  // MINISQL_EXECUTE_ENGINE_H
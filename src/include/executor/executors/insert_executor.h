@@ -12,7 +12,8 @@
 /**
  * InsertExecutor executes an insert on a table.
  *
- * Inserted values are always pulled from a child executor.
+ * Inserted values are always pulled from a child executor, in batches of up to BATCH_SIZE rows which are appended to
+ * the table at once, see TableHeap::BulkInsert.
  */
 class InsertExecutor : public AbstractExecutor {
  public:
@@ -41,6 +42,16 @@ class InsertExecutor : public AbstractExecutor {
   /** @return The output schema for the insert */
   const Schema *GetOutputSchema() const override { return plan_->OutputSchema(); }
 
+ private:
+  /**
+   * Pull the next batch of rows from the child executor and insert them into the table and its indexes. The insert
+   * stops at the first row whose key already exists in an index.
+   * @return number of rows inserted
+   */
+  size_t InsertBatch();
+
+  static constexpr size_t BATCH_SIZE = 1024;
+
  private:
   /** The insert plan node to be executed*/
   const InsertPlanNode *plan_;
@@ -48,6 +59,10 @@ class InsertExecutor : public AbstractExecutor {
   TableInfo *table_info_{};
   const Schema *schema_{};
   std::vector<IndexInfo *> index_info_;
+  std::vector<Row> batch_;  // rows of the current batch
+  size_t inserted_{0};      // number of rows of the batch which were inserted
+  size_t cursor_{0};        // number of rows of the batch which were yielded
+  bool done_{false};        // the child executor is exhausted or a key already exists
 };
 
 #endif  // MINISQL_INSERT_EXECUTOR_H
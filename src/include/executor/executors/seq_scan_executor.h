@@ -5,6 +5,12 @@
 #ifndef MINISQL_SEQ_SCAN_EXECUTOR_H
 #define MINISQL_SEQ_SCAN_EXECUTOR_H
 
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
 #include "executor/execute_context.h"
@@ -12,7 +18,16 @@
 #include "executor/plans/seq_scan_plan.h"
 
 /**
- * The SeqScanExecutor executor executes a sequential table scan.
+ * The SeqScanExecutor executor executes a sequential table scan. The predicate is evaluated on the rows in place, see
+ * TableViewIterator.
+ *
+ * With more than one worker the scan runs in parallel: the pages of the table are split into morsels, see
+ * TableMorselQueue, the calling thread scans the first one while the workers scan the others, each evaluating the
+ * predicate and building the output rows on its own, and the results are merged in the order of the morsels, so the
+ * rows come out in the same order as from a sequential scan. The morsels are cut on the page directory of the table,
+ * and a table of a single morsel, or without a page directory, is scanned without starting any worker. The workers
+ * read the pages without latching them, so a parallel scan must not run under an executor which changes the table,
+ * see ExecuteEngine::CreateExecutor.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
@@ -20,8 +35,12 @@ class SeqScanExecutor : public AbstractExecutor {
    * Construct a new SeqScanExecutor instance.
    * @param exec_ctx The executor context
    * @param plan The sequential scan plan to be executed
+   * @param num_workers The number of worker threads, the scan is not parallel if it is at most 1
    */
-  SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode *plan);
+  SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode *plan, size_t num_workers = 1);
+
+  /** Stop the workers of a parallel scan. */
+  ~SeqScanExecutor() override;
 
   /** Initialize the sequential scan */
   void Init() override;
@@ -31,6 +50,7 @@ class SeqScanExecutor : public AbstractExecutor {
    * @param[out] row The next row produced by the scan
    * @param[out] rid The next row RID produced by the scan
    * @return `true` if a row was produced, `false` if there are no more rows
+   * @throw std::runtime_error if a page of the table can not be fetched, rather than ending the scan early
    */
   bool Next(Row *row, RowId *rid) override;
 
@@ -39,15 +59,47 @@ class SeqScanExecutor : public AbstractExecutor {
 
   bool SchemaEqual(const Schema *table_schema, const Schema *output_schema);
 
-  void TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row, Row *output_row);
+  void TupleTransfer(const Schema *table_schema, const Schema *output_schema, const RowView *row, Row *output_row);
+
+ private:
+  /**
+   * Evaluate the predicate on a row in place.
+   * @param[out] output_row The output row, built only if the row satisfies the predicate
+   * @return whether the row satisfies the predicate
+   */
+  bool Produce(const RowView *row, Row *output_row);
+
+  /** Main loop of a worker of a parallel scan, which scans morsels until the queue is exhausted. */
+  void WorkerLoop();
+
+  /** Stop the workers and wait for them to exit, no-op if there are none. */
+  void StopWorkers();
 
  private:
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
   TableInfo *table_info_{};
-  TableIterator iterator_;
+  BufferAccessStrategy strategy_;  // keeps a large scan from flushing the buffer pool
+  TableViewIterator iterator_;     // reads the rows in place, only the rows produced are copied out
+  bool advance_{false};            // the row last produced is passed only on the next call, see Next
   const Schema *schema_{};
   bool is_schema_same_;
+
+  /** Parallel scan, iterator_ walks the first morsel */
+  size_t num_workers_;
+  size_t max_pending_morsels_;  // max number of morsels taken by the workers but not yet merged
+  std::unique_ptr<TableMorselQueue> morsels_;
+  std::vector<std::thread> workers_;
+  std::mutex latch_;                            // to protect the members below
+  std::condition_variable cv_;                  // signalled when a morsel is scanned or merged, or on stop
+  std::map<size_t, std::vector<Row>> results_;  // output rows of the morsels scanned but not yet merged
+  size_t num_taken_{0};                         // number of morsels taken by the workers, but the first
+  size_t num_merged_{0};                        // number of morsels merged by Next, but the first
+  size_t num_running_{0};                       // number of workers still running
+  bool stop_{false};
+  bool failed_{false};                          // a worker could not fetch a page of its morsel
+  std::vector<Row> merged_;  // output rows of the morsel being merged, outside of latch_
+  size_t merged_pos_{0};     // next row of merged_
 };
 
 #endif  // MINISQL_SEQ_SCAN_EXECUTOR_H
@@ -1,6 +1,7 @@
 #ifndef MINISQL_B_PLUS_TREE_H
 #define MINISQL_B_PLUS_TREE_H
 
+#include <fstream>
 #include <queue>
 #include <string>
 #include <vector>
@@ -26,8 +27,12 @@ class BPlusTree {
   using LeafPage = BPlusTreeLeafPage;
 
  public:
+  /**
+   * @param segment_id segment to store the pages of the tree in, see BufferPoolManager::CreateSegment
+   */
   explicit BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &comparator,
-                     int leaf_max_size = UNDEFINED_SIZE, int internal_max_size = UNDEFINED_SIZE);
+                     int leaf_max_size = UNDEFINED_SIZE, int internal_max_size = UNDEFINED_SIZE,
+                     segment_id_t segment_id = MAIN_SEGMENT_ID);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
@@ -38,6 +43,9 @@ class BPlusTree {
   // Remove a key and its value from this B+ tree.
   void Remove(const GenericKey *key, Txn *transaction = nullptr);
 
+  // Replace the value associated with a key in its leaf, return false if the key does not exist.
+  bool Update(const GenericKey *key, const RowId &value, Txn *transaction = nullptr);
+
   // return the value associated with a given key
   bool GetValue(const GenericKey *key, std::vector<RowId> &result, Txn *transaction = nullptr);
 
@@ -56,6 +64,14 @@ class BPlusTree {
   // destroy the b plus tree
   void Destroy(page_id_t current_page_id = INVALID_PAGE_ID);
 
+  /**
+   * Move the pages of the tree towards the front of its file, see BufferPoolManager::RelocatePage, fixing the pointers
+   * to each page moved: in its parent or the root record of IndexRootsPage, in its children, and in the leaf before it.
+   * The tree must not be used meanwhile.
+   * @return number of pages moved
+   */
+  size_t Compact();
+
   void PrintTree(std::ofstream &out, Schema *schema) {
     if (IsEmpty()) {
       return;
@@ -95,6 +111,20 @@ class BPlusTree {
 
   void UpdateRootPageId(int insert_record = 0);
 
+  /**
+   * Move the pages of a subtree in key order, parents before their children.
+   * @param parent pinned parent of the page, nullptr for the root
+   * @param index index of the page in its parent
+   * @param prev_leaf_id id of the last leaf visited, updated as leaves are visited
+   * @param moved number of pages moved, incremented for each page moved
+   */
+  void CompactSubtree(page_id_t page_id, InternalPage *parent, int index, page_id_t &prev_leaf_id, size_t &moved);
+
+  /**
+   * Create a page for the tree next to the last page it created, so that the pages of the tree are contiguous on disk.
+   */
+  Page *NewTreePage(page_id_t &page_id);
+
   /* Debug Routines for FREE!! */
   void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out, Schema *schema) const;
 
@@ -107,6 +137,8 @@ class BPlusTree {
   KeyManager processor_;
   int leaf_max_size_;
   int internal_max_size_;
+  page_id_t last_allocated_page_id_{INVALID_PAGE_ID};  // allocation hint for the next page of the tree
+  segment_id_t segment_id_;                            // segment holding the pages of the tree
 };
 
 #endif  // MINISQL_B_PLUS_TREE_H
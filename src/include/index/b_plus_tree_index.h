@@ -7,16 +7,25 @@
 
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager);
+  /**
+   * @param segment_id segment to store the pages of the index in, see BufferPoolManager::CreateSegment
+   */
+  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager,
+                 segment_id_t segment_id = MAIN_SEGMENT_ID);
 
   dberr_t InsertEntry(const Row &key, RowId row_id, Txn *txn) override;
 
   dberr_t RemoveEntry(const Row &key, RowId row_id, Txn *txn) override;
 
+  /** Update the value of the key in place, the tree is not restructured. */
+  dberr_t UpdateEntry(const Row &key, RowId row_id, Txn *txn) override;
+
   dberr_t ScanKey(const Row &key, std::vector<RowId> &result, Txn *txn, string compare_operator = "=") override;
 
   dberr_t Destroy() override;
 
+  size_t Compact() override { return container_.Compact(); }
+
   IndexIterator GetBeginIterator();
 
   IndexIterator GetBeginIterator(GenericKey *key);
@@ -2,6 +2,7 @@
 #define MINISQL_INDEX_H
 
 #include <memory>
+#include <vector>
 
 #include "common/dberr.h"
 #include "concurrency/txn.h"
@@ -17,10 +18,29 @@ class Index {
 
   virtual dberr_t RemoveEntry(const Row &key, RowId row_id, Txn *txn) = 0;
 
+  /**
+   * Point the entry of a key at another row id, for a row which has moved.
+   * @return DB_KEY_NOT_FOUND if the key is not in the index
+   */
+  virtual dberr_t UpdateEntry(const Row &key, RowId row_id, Txn *txn) {
+    std::vector<RowId> result;
+    if (ScanKey(key, result, txn) != DB_SUCCESS) {
+      return DB_KEY_NOT_FOUND;
+    }
+    RemoveEntry(key, result[0], txn);
+    return InsertEntry(key, row_id, txn);
+  }
+
   virtual dberr_t ScanKey(const Row &key, std::vector<RowId> &result, Txn *txn, std::string compare_operator = "=") = 0;
 
   virtual dberr_t Destroy() = 0;
 
+  /**
+   * Move the pages of the index towards the front of its file, see BufferPoolManager::RelocatePage.
+   * @return number of pages moved
+   */
+  virtual size_t Compact() { return 0; }
+
  protected:
   index_id_t index_id_;
   IndexSchema *key_schema_;
@@ -26,11 +26,18 @@ class IndexIterator {
   /** Return whether two iterators are not equal. */
   bool operator!=(const IndexIterator &itr) const;
 
+ private:
+  /**
+   * Called whenever the iterator moves to a leaf, prefetch the leaves after it once every half read-ahead window.
+   */
+  void ReadAhead();
+
  private:
   page_id_t current_page_id{INVALID_PAGE_ID};
   LeafPage *page{nullptr};
   int item_index{0};
   BufferPoolManager *buffer_pool_manager{nullptr};
+  int readahead_countdown{0};  // number of leaves to go before the next read-ahead
   // add your own private member variables here
 };
 
@@ -30,6 +30,25 @@ class BitmapPage {
    */
   bool IsPageFree(uint32_t page_offset) const;
 
+  /**
+   * @return true if the page was free and has been allocated
+   */
+  bool AllocatePageAt(uint32_t page_offset);
+
+  /**
+   * Scan the bitmap 64 bits at a time for the first free page at or after start.
+   *
+   * @return index of the free page, 8 * MAX_CHARS if there is none
+   */
+  uint32_t FindFreePage(uint32_t start) const;
+
+  /**
+   * Find num_pages free pages in a row, starting at a multiple of 64 at or after start.
+   *
+   * @return index of the first page of the run, 8 * MAX_CHARS if there is none
+   */
+  uint32_t FindFreeRun(uint32_t start, uint32_t num_pages) const;
+
  private:
   /**
    * check a bit(byte_index, bit_index) in bytes is free(value 0).
@@ -42,6 +61,7 @@ class BitmapPage {
 
   /** Note: need to update if modify page structure. */
   static constexpr size_t MAX_CHARS = PageSize - 2 * sizeof(uint32_t);
+  static_assert(MAX_CHARS % sizeof(uint64_t) == 0, "Bitmap is scanned by 64-bit words.");
 
  private:
   /** The space occupied by all members of the class should be equal to the PageSize */
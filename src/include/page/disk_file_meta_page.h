@@ -5,7 +5,13 @@
 
 #include "page/bitmap_page.h"
 
-static constexpr page_id_t MAX_VALID_PAGE_ID = (PAGE_SIZE - 8) / 4 * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+/** max number of extents of a file, the meta page keeps the number of used pages of each of them */
+static constexpr uint32_t MAX_EXTENTS = (PAGE_SIZE - 24) / 4;
+
+static constexpr page_id_t MAX_VALID_PAGE_ID = MAX_EXTENTS * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+
+/** format_ of a file whose pages are stored compressed */
+static constexpr uint32_t COMPRESSED_FILE_FORMAT = 0x50435A4C;
 
 class DiskFileMetaPage {
  public:
@@ -20,10 +26,20 @@ class DiskFileMetaPage {
     return extent_used_page_[extent_id];
   }
 
+  /** @return true if the pages are stored compressed, at the places given by the page location map */
+  bool IsCompressed() { return format_ == COMPRESSED_FILE_FORMAT; }
+
  public:
   uint32_t num_allocated_pages_{0};
   uint32_t num_extents_{0};  // each extent consists with a bit map and BIT_MAP_SIZE pages
-  uint32_t extent_used_page_[0];
+  uint32_t extent_used_page_[MAX_EXTENTS];
+  // zero in files of the plain format, where the place of a page follows from its id
+  uint32_t format_{0};
+  uint32_t map_directory_sector_{0};  // first sector of the directory of the page location map
+  uint32_t map_blocks_{0};            // number of blocks of the page location map
+  uint32_t reserved_{0};
 };
 
+static_assert(sizeof(DiskFileMetaPage) == PAGE_SIZE, "The meta page must fill a page.");
+
 #endif  // MINISQL_DISK_FILE_META_PAGE_H
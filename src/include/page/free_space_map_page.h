@@ -0,0 +1,58 @@
+#ifndef MINISQL_FREE_SPACE_MAP_PAGE_H
+#define MINISQL_FREE_SPACE_MAP_PAGE_H
+
+#include <cstdint>
+
+#include "common/config.h"
+
+/**
+ * A page of the free space map of a table heap, see FreeSpaceMap. It records the free space of up to MAX_ENTRIES
+ * pages of the table, as the bucket of the free space of each page, and the pages of the map are chained.
+ *
+ * Format (size in byte):
+ *  ------------------------------------------------------------------------------------------------
+ * | NextPageId (4) | EntryCount (4) | PageId_1 (4) | ... | PageId_n (4) | Bucket_1 (1) | ... | Bucket_n (1) |
+ *  ------------------------------------------------------------------------------------------------
+ */
+class FreeSpaceMapPage {
+ public:
+  static constexpr uint32_t MAX_ENTRIES = (PAGE_SIZE - 2 * sizeof(uint32_t)) / (sizeof(page_id_t) + sizeof(uint8_t));
+
+  void Init() {
+    next_page_id_ = INVALID_PAGE_ID;
+    num_entries_ = 0;
+  }
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  uint32_t GetEntryCount() const { return num_entries_; }
+
+  bool IsFull() const { return num_entries_ == MAX_ENTRIES; }
+
+  page_id_t GetPageId(uint32_t index) const { return page_ids_[index]; }
+
+  void SetPageId(uint32_t index, page_id_t page_id) { page_ids_[index] = page_id; }
+
+  uint8_t GetBucket(uint32_t index) const { return buckets_[index]; }
+
+  void SetBucket(uint32_t index, uint8_t bucket) { buckets_[index] = bucket; }
+
+  /** Record a page at the end of the page, which must not be full. */
+  void Append(page_id_t page_id, uint8_t bucket) {
+    page_ids_[num_entries_] = page_id;
+    buckets_[num_entries_] = bucket;
+    num_entries_++;
+  }
+
+ private:
+  page_id_t next_page_id_;
+  uint32_t num_entries_;
+  page_id_t page_ids_[MAX_ENTRIES];
+  uint8_t buckets_[MAX_ENTRIES];
+};
+
+static_assert(sizeof(FreeSpaceMapPage) <= PAGE_SIZE, "The free space map page must fit in a page.");
+
+#endif  // MINISQL_FREE_SPACE_MAP_PAGE_H
@@ -1,8 +1,10 @@
 #ifndef MINISQL_PAGE_H
 #define MINISQL_PAGE_H
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <shared_mutex>
 
 #include "common/config.h"
@@ -12,16 +14,24 @@
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The page data lives in the data arena of the buffer pool, so that the descriptors of all the frames are packed
+ * together, each starting on its own cache line with the book-keeping fields in front.
  */
-class Page {
+class alignas(64) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
+  friend class ParallelBufferPoolManager;
+  friend class ReadOnlyBufferPoolManager;
 
  public:
   DISALLOW_COPY(Page)
 
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor of a standalone page, which owns its zeroed data. */
+  Page() : data_(new char[PAGE_SIZE]{}) { owned_data_.reset(data_); }
+
+  /** Constructor of a buffer pool frame, whose data is a frame of the data arena of the buffer pool. */
+  explicit Page(char *data) : data_(data) {}
 
   /** Default destructor. */
   ~Page() = default;
@@ -68,14 +78,18 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** The actual data that is stored within a page, PAGE_SIZE bytes owned by the buffer pool. */
+  char *data_ = nullptr;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  /** The file this page belongs to, within the files sharing the buffer pool. */
+  file_id_t file_id_ = DEFAULT_FILE_ID;
+  /** The pin count of this page, changed without the buffer pool latch on cache hits. */
+  std::atomic<int> pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_ = false;
+  /** Data of a standalone page, empty for buffer pool frames. */
+  std::unique_ptr<char[]> owned_data_;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
 };
@@ -33,6 +33,8 @@ class TablePage : public Page {
 
   page_id_t GetTablePageId() { return *reinterpret_cast<page_id_t *>(GetData()); }
 
+  void SetTablePageId(page_id_t page_id) { memcpy(GetData(), &page_id, sizeof(page_id_t)); }
+
   page_id_t GetPrevPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PREV_PAGE_ID); }
 
   page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
@@ -58,10 +60,21 @@ class TablePage : public Page {
 
   bool GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_manager);
 
+  /**
+   * @return the serialized tuple of a slot in place, see RowView, nullptr if the slot is empty or deleted
+   */
+  const char *GetTupleData(const RowId &rid);
+
   bool GetFirstTupleRid(RowId *first_rid);
 
   bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
 
+  /** @return serialized size of the largest row which can be inserted into the page, see FreeSpaceMap */
+  uint32_t GetMaxInsertSize() {
+    uint32_t free_space = GetFreeSpaceRemaining();
+    return free_space > SIZE_TUPLE ? free_space - SIZE_TUPLE : 0;
+  }
+
  private:
   uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
 
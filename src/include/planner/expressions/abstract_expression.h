@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "record/row.h"
+#include "record/row_view.h"
 #include "record/schema.h"
 
 class AbstractExpression;
@@ -36,6 +37,9 @@ class AbstractExpression {
   /** @return The field obtained by evaluating the row */
   virtual Field Evaluate(const Row *row) const = 0;
 
+  /** @return The field obtained by evaluating a row read in place, see TableViewIterator */
+  virtual Field EvaluateView(const RowView *row) const = 0;
+
   /**
    * Returns the field obtained by evaluating a JOIN.
    * @param left_row The left row
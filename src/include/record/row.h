@@ -78,6 +78,24 @@ class Row {
     return *this;
   }
 
+  /**
+   * Row move function, takes over the fields of other
+   */
+  Row(Row &&other) noexcept : rid_(other.rid_), fields_(std::move(other.fields_)) { other.fields_.clear(); }
+
+  /**
+   * Move assign operator, takes over the fields of other
+   */
+  Row &operator=(Row &&other) noexcept {
+    if (this != &other) {
+      destroy();
+      rid_ = other.rid_;
+      fields_ = std::move(other.fields_);
+      other.fields_.clear();
+    }
+    return *this;
+  }
+
   /**
    * Note: Make sure that bytes write to buf is equal to GetSerializedSize()
    */
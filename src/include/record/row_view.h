@@ -0,0 +1,55 @@
+#ifndef MINISQL_ROW_VIEW_H
+#define MINISQL_ROW_VIEW_H
+
+#include <vector>
+
+#include "common/rowid.h"
+#include "record/field.h"
+#include "record/row.h"
+#include "record/schema.h"
+
+/**
+ * RowView reads the fields of a serialized row in place, see Row::SerializeTo, without copying the row. Fields are
+ * decoded when they are asked for, and the offsets of the fields found on the way are kept, so that reading the fields
+ * of a row in order walks it once. The bytes of the row must outlive the view, e.g. the page of the row must stay
+ * pinned, see TableViewIterator.
+ */
+class RowView {
+ public:
+  RowView() = default;
+
+  /** View the row serialized at data. */
+  void Reset(RowId rid, const char *data, Schema *schema) {
+    rid_ = rid;
+    data_ = data;
+    schema_ = schema;
+    offsets_.clear();
+  }
+
+  inline RowId GetRowId() const { return rid_; }
+
+  inline size_t GetFieldCount() const { return schema_->GetColumnCount(); }
+
+  inline bool IsNull(uint32_t idx) const { return (data_[sizeof(uint32_t) + idx / 8] >> (idx % 8)) & 1; }
+
+  /**
+   * @param manage_data whether a char field gets a copy of its data, instead of pointing into the row
+   * @return the field idx of the row
+   */
+  Field GetField(uint32_t idx, bool manage_data = false) const;
+
+  /** Copy the row out, to keep it once the view has moved. */
+  void ToRow(Row &row) const;
+
+ private:
+  /** @return the bytes of the field idx of the row */
+  const char *GetFieldData(uint32_t idx) const;
+
+ private:
+  RowId rid_{};
+  const char *data_{nullptr};
+  Schema *schema_{nullptr};
+  mutable std::vector<uint32_t> offsets_;  // offsets of the fields found so far, kept from row to row for its capacity
+};
+
+#endif  // MINISQL_ROW_VIEW_H
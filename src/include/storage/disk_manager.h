@@ -2,27 +2,80 @@
 #define DISK_MGR_H
 
 #include <atomic>
-#include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
 
+static_assert(MAX_VALID_PAGE_ID <= (1 << SEGMENT_PAGE_BITS), "The pages of a file must fit in a segment.");
+static_assert(MAX_SEGMENTS <= (1U << (31 - SEGMENT_PAGE_BITS)), "Page ids must stay positive.");
+
+/** A page to read into, or write from, a buffer of PAGE_SIZE bytes, one of a batch of page I/O requests */
+struct PageIORequest {
+  page_id_t page_id_;  // logical page id
+  char *data_;
+};
+
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
  *
+ * Pages are read and written with positioned I/O on the file descriptor, so reads and writes of different pages run
+ * concurrently; only page allocation is serialized. Batches of pages are submitted through an io_uring of the calling
+ * thread, keeping up to IO_URING_QUEUE_DEPTH requests in flight, or read and written one by one if the kernel does not
+ * support io_uring. Writes are not made durable one by one: Sync() flushes them to the disk, and is called when the
+ * file is closed.
+ *
+ * The meta page and the free page bitmaps of the extents are kept in memory once read, and changes to them are only
+ * written back by Sync(), so allocating or freeing a page does no I/O in the common case. The space of the runs of
+ * pages which become wholly free is given back to the file system by punching holes in the file, and TruncateFile cuts
+ * the free pages at the end of the file off, once compaction has moved the live pages towards its front.
+ *
+ * In direct I/O mode the file is opened with O_DIRECT, so pages are cached by the buffer pool only and not a second
+ * time by the kernel. Direct I/O needs page-aligned buffers: the buffer pool's frames are, other buffers are copied
+ * through an aligned buffer of the calling thread.
+ *
+ * In read-only mode the file must exist and is never written: it is mapped into memory as a whole, and its pages are
+ * read in place through GetMappedPage. Allocating, freeing or writing pages fails.
+ *
  * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
+ *
+ * A file can be created in the compressed format instead, which is recorded in its meta page. The meta page stays at
+ * the start of the file, but every other page (the bitmaps included) is compressed with PageCompressor when written
+ * and stored in as many sectors of COMPRESSION_SECTOR_SIZE bytes as it needs, wherever there is room. A page location
+ * map, indexed by the physical page id of the plain format, gives the place and size of each page. It is kept in memory
+ * and its changed blocks are written back by Sync(), along with the directory of the blocks which the meta page points
+ * to. Space freed by rewritten or deallocated pages is reused once the map which no longer refers to it is durable.
+ *
+ * A file can also hold a segment of a database, i.e. the pages of one of its tables or indexes, see
+ * SegmentedBufferPoolManager. The id of the segment is carried by the high bits of the page ids, above
+ * SEGMENT_PAGE_BITS, so that page ids stay unique across the files of a database; the main file is segment
+ * MAIN_SEGMENT_ID, whose page ids are the plain ones. Pages are allocated with the id of the segment of the file, and
+ * the other methods expect page ids of that segment.
  */
 class DiskManager {
  public:
-  explicit DiskManager(const std::string &db_file);
+  /**
+   * @param direct_io open the file with O_DIRECT, ignored with a warning if the file system does not support it
+   * @param read_only open an existing file for reading only and map it into memory, direct_io is ignored
+   * @param compress create the file in the compressed format if it is new, the format of an existing file is kept;
+   * direct_io is ignored for compressed files
+   * @param segment_id segment whose pages the file holds
+   * @throw std::exception if the file can not be opened, or mapped in read-only mode
+   */
+  explicit DiskManager(const std::string &db_file, bool direct_io = DEFAULT_DIRECT_IO, bool read_only = false,
+                       bool compress = DEFAULT_PAGE_COMPRESSION, segment_id_t segment_id = MAIN_SEGMENT_ID);
 
   ~DiskManager() {
     if (!closed) {
@@ -42,6 +95,19 @@ class DiskManager {
    */
   void WritePage(page_id_t logical_page_id, const char *page_data);
 
+  /**
+   * Read a batch of pages, returning once all of them are read. Pages which are contiguous on disk are read together.
+   * If a page appears several times, it is read once and copied into the buffer of each of its requests.
+   */
+  void ReadPages(const std::vector<PageIORequest> &requests);
+
+  /**
+   * Write a batch of pages, returning once all of them are written. The pages are sorted by their place on disk and
+   * the contiguous ones are written together with a single vectored write. If a page appears several times, its last
+   * request wins.
+   */
+  void WritePages(const std::vector<PageIORequest> &requests);
+
   /**
    * Get next free page from disk
    * @return logical page id of allocated page
@@ -49,7 +115,24 @@ class DiskManager {
   page_id_t AllocatePage();
 
   /**
-   * Free this page and reset bit map
+   * Allocate a page close to another one, so that the pages of a table or an index are physically contiguous. The
+   * page is taken from the run of ALLOCATION_RUN_PAGES pages holding near_page_id if it has a free page after it, or
+   * from the next run if it is wholly free; otherwise a wholly free run is started. The file is grown a run at a time.
+   * @param near_page_id last page allocated to the same table or index, INVALID_PAGE_ID to start a new run
+   * @return logical page id of allocated page, which may be anywhere if no run is free
+   */
+  page_id_t AllocatePageNear(page_id_t near_page_id);
+
+  /**
+   * Allocate the lowest free page of the file if it lies before another page, so that the content of that page can be
+   * moved there to compact the file. The page is not taken from a run, unlike AllocatePageNear.
+   * @return logical page id of allocated page, INVALID_PAGE_ID if no page before page_id is free
+   */
+  page_id_t AllocatePageBelow(page_id_t page_id);
+
+  /**
+   * Free this page and reset bit map. Once every page of its run of ALLOCATION_RUN_PAGES pages is free, the space of
+   * the run is given back to the file system by Sync(), punching a hole in the file.
    */
   void DeAllocatePage(page_id_t logical_page_id);
 
@@ -58,6 +141,18 @@ class DiskManager {
    */
   bool IsPageFree(page_id_t logical_page_id);
 
+  /**
+   * Write the changed meta page and bitmaps back, and make them and the pages written so far durable. Then punch holes
+   * in the runs which have become wholly free, if they still are.
+   */
+  void Sync();
+
+  /**
+   * Cut the free pages at the end of the file off, along with the trailing extents which have no page left. The
+   * smaller meta page is made durable before the file is shortened. No-op in read-only mode.
+   */
+  void TruncateFile();
+
   /**
    * Shut down the disk manager and close all the file resources.
    */
@@ -69,14 +164,48 @@ class DiskManager {
    */
   char *GetMetaData() { return meta_data_; }
 
-  static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+  /** @return true if the file is opened with O_DIRECT */
+  bool IsDirectIO() const { return direct_io_; }
+
+  /** @return true if the pages of the file are stored compressed */
+  bool IsCompressed() const { return compressed_; }
+
+  /** @return true if the file is opened in read-only mode */
+  bool IsReadOnly() const { return read_only_; }
+
+  /** @return length of the file in bytes */
+  size_t GetFileSize() const { return file_size_; }
 
- private:
   /**
-   * Helper function to get disk file size
+   * Get the data of a page in the mapping of a file opened in read-only mode. The data must not be written to, and
+   * stays valid until the disk manager is closed.
+   * @return nullptr if the file is not mapped, or the page lies beyond the end of the file; compressed files are never
+   * mapped
    */
-  int GetFileSize(const std::string &file_name);
+  char *GetMappedPage(page_id_t logical_page_id);
+
+  /** @return name of the file */
+  const std::string &GetFileName() const { return file_name_; }
+
+  /** @return segment whose pages the file holds */
+  segment_id_t GetSegmentId() const { return segment_id_; }
 
+  /**
+   * @return id of a page within the segment of the file, INVALID_PAGE_ID if it is not a valid page id of the segment
+   */
+  page_id_t GetLocalPageId(page_id_t page_id) const;
+
+  /** @return segment of a page, INVALID_PAGE_ID must not be passed */
+  static segment_id_t SegmentOf(page_id_t page_id) { return static_cast<uint32_t>(page_id) >> SEGMENT_PAGE_BITS; }
+
+  /** @return id of a page of a segment from its id within the segment */
+  static page_id_t MakePageId(segment_id_t segment_id, page_id_t local_page_id) {
+    return static_cast<page_id_t>(segment_id << SEGMENT_PAGE_BITS | static_cast<uint32_t>(local_page_id));
+  }
+
+  static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+
+ private:
   /**
    * Read physical page from disk
    */
@@ -88,18 +217,190 @@ class DiskManager {
   void WritePhysicalPage(page_id_t physical_page_id, const char *page_data);
 
   /**
-   * Map logical page id to physical page id
+   * Map logical page id to physical page id, the segment id in its high bits is ignored
    */
   page_id_t MapPageId(page_id_t logical_page_id);
 
+  /** Pages at consecutive places on disk, read or written by one vectored request */
+  struct PageRun;
+
+  /**
+   * Read or write a batch of pages in runs of contiguous pages.
+   */
+  void TransferPages(const std::vector<PageIORequest> &requests, bool write);
+
+  /**
+   * Sort a batch of pages by physical page id and merge the contiguous ones into runs. Reads beyond the end of the file
+   * are served right away with zeroes, and so are pages which direct I/O can not use in place, one by one.
+   */
+  std::vector<PageRun> BuildPageRuns(const std::vector<PageIORequest> &requests, bool write);
+
+  /**
+   * Submit runs of pages through the io_uring of the calling thread.
+   * @return false if io_uring is not available, in which case nothing has been done
+   */
+  bool SubmitPageRuns(const std::vector<PageRun> &runs, bool write);
+
+  /**
+   * Read or write a run of pages with preadv or pwritev, falling back to one page at a time if it is cut short.
+   */
+  void TransferPageRun(const PageRun &run, bool write);
+
+  /**
+   * Grow the cached file length after a write which ended at end_offset
+   */
+  void UpdateFileSize(size_t end_offset);
+
+  /**
+   * @return the bitmap of an existing extent, read from disk on first use. Caller must hold db_io_latch_.
+   */
+  BitmapPage<PAGE_SIZE> *GetBitmap(uint32_t extent_id);
+
+  /**
+   * Add an empty extent at the end of the file. Caller must hold db_io_latch_.
+   * @return id of the extent
+   */
+  uint32_t AddExtent();
+
+  /**
+   * Account for a page just allocated in the bitmap of an extent, and grow the file if needed. Caller must hold
+   * db_io_latch_.
+   * @return logical page id of the page
+   */
+  page_id_t OnPageAllocated(uint32_t extent_id, uint32_t page_offset);
+
+  /**
+   * Preallocate the file up to the end of the run holding a page if the page is beyond the end of the file.
+   */
+  void GrowFile(page_id_t logical_page_id);
+
+  /**
+   * Give the space of the runs in free_runs_ which are still wholly free back to the file system. Caller must hold
+   * db_io_latch_.
+   */
+  void PunchFreeRuns();
+
+  /** @return physical page id of the bitmap of an extent */
+  static page_id_t GetBitmapPageId(uint32_t extent_id) { return extent_id * (BITMAP_SIZE + 1) + 1; }
+
+  /**
+   * Read up to size bytes at offset, stopping early at the end of the file.
+   * @return number of bytes read
+   */
+  size_t ReadAt(size_t offset, char *data, size_t size);
+
+  /**
+   * Write size bytes at offset.
+   * @return false on I/O error
+   */
+  bool WriteAt(size_t offset, const char *data, size_t size);
+
+  /** Place of a page in a compressed file */
+  struct PageLocation {
+    uint32_t sector_;  // first sector of the compressed page
+    uint16_t size_;    // size of the compressed page in bytes, 0 if never written, PAGE_SIZE if stored as it is
+    uint16_t unused_;
+  };
+
+  static constexpr size_t LOCATIONS_PER_MAP_BLOCK = PAGE_SIZE / sizeof(PageLocation);
+  static constexpr uint32_t SECTORS_PER_PAGE = PAGE_SIZE / COMPRESSION_SECTOR_SIZE;
+
+  /** @return number of sectors holding size bytes */
+  static uint32_t SectorsOf(size_t size) { return (size + COMPRESSION_SECTOR_SIZE - 1) / COMPRESSION_SECTOR_SIZE; }
+
+  /**
+   * Read a page of a compressed file, zeroed if it has never been written or is corrupted.
+   */
+  void ReadCompressedPage(page_id_t physical_page_id, char *page_data);
+
+  /**
+   * Compress a page and write it in place if it still fits in its sectors, elsewhere otherwise.
+   */
+  void WriteCompressedPage(page_id_t physical_page_id, const char *page_data);
+
+  /**
+   * Forget the place of a page of a compressed file, releasing its sectors.
+   */
+  void ReleaseCompressedPage(page_id_t physical_page_id);
+
+  /**
+   * Read the page location map of a compressed file and find the free sectors. Caller must hold db_io_latch_.
+   */
+  void LoadPageLocations();
+
+  /**
+   * Write the changed blocks of the page location map back, and the directory of the blocks if any of them has moved.
+   * Caller must hold db_io_latch_.
+   * @return sectors released since the last call, which can be reused once the meta page is durable
+   */
+  std::vector<std::pair<uint32_t, uint32_t>> WritePageLocations();
+
+  /**
+   * Make room in locations_ for a physical page. Caller must hold location_latch_.
+   */
+  void ReservePageLocation(page_id_t physical_page_id);
+
+  /**
+   * Take count contiguous free sectors, the smallest free range which fits or the end of the file. Caller must hold
+   * location_latch_.
+   * @return first sector
+   */
+  uint32_t AllocateSectors(uint32_t count);
+
+  /**
+   * Make sectors free for reuse, merging them with their free neighbours. Caller must hold location_latch_.
+   */
+  void FreeSectors(uint32_t sector, uint32_t count);
+
  private:
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of the db file
+  int db_fd_{-1};
   std::string file_name_;
-  // with multiple buffer pool instances, need to protect file access
+  // segment whose pages the file holds, carried by the high bits of their ids
+  segment_id_t segment_id_{MAIN_SEGMENT_ID};
+  // length of the db file, reads beyond it return zeroed pages without touching the file
+  std::atomic<size_t> file_size_{0};
+  // to protect meta_data_ and the bitmaps, page reads and writes do not take it
   std::recursive_mutex db_io_latch_;
+  // bitmaps of the extents, indexed by extent id, nullptr until read from disk
+  std::vector<std::unique_ptr<BitmapPage<PAGE_SIZE>>> bitmaps_;
+  // the bitmap of an extent has changed since it was last written back
+  std::vector<bool> bitmap_dirty_;
+  // meta_data_ has changed since it was last written back
+  bool meta_dirty_{false};
+  // every extent before it is full
+  uint32_t next_free_extent_{0};
+  // first logical page of the runs which have become wholly free since the last Sync, their holes are punched once the
+  // bitmaps which free them are durable
+  std::vector<page_id_t> free_runs_;
   bool closed{false};
-  char meta_data_[PAGE_SIZE];
+  // the file is opened with O_DIRECT
+  bool direct_io_{false};
+  // the file is opened for reading only and mapped into memory
+  bool read_only_{false};
+  // read-only mapping of the whole file, nullptr if the file is not mapped or is empty
+  char *mapping_{nullptr};
+  // length of mapping_
+  size_t mapping_size_{0};
+  // the pages are stored compressed at the places given by locations_
+  bool compressed_{false};
+  // to protect the members below, taken after db_io_latch_ if both are needed
+  std::mutex location_latch_;
+  // place of every physical page of a compressed file, indexed by physical page id
+  std::vector<PageLocation> locations_;
+  // first sector of each block of locations_ on disk, 0 if it has never been written
+  std::vector<uint32_t> map_block_sectors_;
+  // a block of locations_ has changed since it was last written back
+  std::vector<bool> map_block_dirty_;
+  // free ranges of sectors before end_sector_, first sector -> number of sectors
+  std::map<uint32_t, uint32_t> free_sectors_;
+  // the same free ranges ordered by size, (number of sectors, first sector)
+  std::set<std::pair<uint32_t, uint32_t>> free_sectors_by_size_;
+  // sectors released since the last Sync, (first sector, number of sectors)
+  std::vector<std::pair<uint32_t, uint32_t>> released_sectors_;
+  // end of the used sectors of a compressed file
+  uint32_t end_sector_{0};
+  alignas(PAGE_SIZE) char meta_data_[PAGE_SIZE];
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,115 @@
+#ifndef MINISQL_FREE_SPACE_MAP_H
+#define MINISQL_FREE_SPACE_MAP_H
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "page/free_space_map_page.h"
+
+/**
+ * FreeSpaceMap keeps the free space of each page of a table heap, so that an insert finds a page with room for its row
+ * without walking the pages of the table, and space freed by deletes anywhere in the table is reused.
+ *
+ * The free space of a page is recorded as its bucket, free space / BUCKET_SIZE, in the chained FreeSpaceMapPages of
+ * the map, in the order in which the pages were added to the table. The map is read into memory on first use, where
+ * the pages are also indexed by bucket, so finding a page only looks at the non-empty buckets large enough for the
+ * row. Changes are written through to the pages of the map.
+ *
+ * A page is added to the map when it is linked at the end of the table, and compaction keeps its entry in place, so the
+ * entries are in chain order and the map doubles as the page directory of the table: the pages are counted, and the
+ * nth page is found, without walking the chain, see TableHeap::GetPageIds.
+ */
+class FreeSpaceMap {
+ public:
+  static constexpr uint32_t NUM_BUCKETS = 256;
+  static constexpr uint32_t BUCKET_SIZE = PAGE_SIZE / NUM_BUCKETS;
+
+  /**
+   * Create an empty map, its first page close to near_page_id, see BufferPoolManager::NewPageNear.
+   * @return nullptr if the page can not be created
+   */
+  static FreeSpaceMap *Create(BufferPoolManager *buffer_pool_manager, page_id_t near_page_id);
+
+  /** Open the map whose first page is first_page_id. */
+  FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id)
+      : buffer_pool_manager_(buffer_pool_manager), first_page_id_(first_page_id) {}
+
+  inline page_id_t GetFirstPageId() const { return first_page_id_; }
+
+  /**
+   * Record the free space of a page, which is added to the map if it is not in it yet.
+   * @param free_space size of the largest row which can be inserted into the page
+   * @return false if a page of the map can not be fetched or created (the buffer pool is full), the map is unchanged
+   */
+  bool Update(page_id_t page_id, uint32_t free_space);
+
+  /**
+   * @return a page with room for a row of size bytes, with as little room as possible, INVALID_PAGE_ID if there is none
+   * or the map can not be read
+   */
+  page_id_t FindPage(uint32_t size);
+
+  /** Give the entry of a page moved by compaction to its new id. */
+  void ReplacePage(page_id_t old_page_id, page_id_t new_page_id);
+
+  /**
+   * Move the pages of the map towards the front of the file, see BufferPoolManager::RelocatePage, relinking the chain.
+   * The first page may move, see GetFirstPageId.
+   * @return number of pages moved
+   */
+  size_t Compact();
+
+  /** @return the page last added to the map, INVALID_PAGE_ID if it is empty or can not be read */
+  page_id_t GetLastPageId();
+
+  /** @return the number of pages in the map */
+  size_t GetPageCount();
+
+  /** @return the pages of the entries begin to end - 1, those past the last entry are left out */
+  std::vector<page_id_t> GetPageIds(size_t begin, size_t end);
+
+  /** Free the pages of the map. */
+  void Destroy();
+
+ private:
+  FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, bool loaded)
+      : buffer_pool_manager_(buffer_pool_manager), first_page_id_(first_page_id), loaded_(loaded) {
+    map_page_ids_.push_back(first_page_id);
+  }
+
+  static uint8_t ToBucket(uint32_t free_space) {
+    return static_cast<uint8_t>(std::min<uint32_t>(free_space / BUCKET_SIZE, NUM_BUCKETS - 1));
+  }
+
+  /**
+   * Read the pages of the map into memory. Caller must hold latch_.
+   * @return false if a page can not be fetched, the map is read again on next use
+   */
+  bool Load();
+
+  /** Drop the map from memory. Caller must hold latch_. */
+  void Clear();
+
+  /**
+   * Write an entry to its page of the map, the entry after the last one is appended. Caller must hold latch_.
+   * @return false if a page of the map can not be fetched or created
+   */
+  bool WriteEntry(uint32_t index);
+
+ private:
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t first_page_id_;
+  std::mutex latch_;  // to protect the members below
+  bool loaded_{false};
+  std::vector<page_id_t> map_page_ids_;                       // pages of the map, in chain order
+  std::vector<page_id_t> page_ids_;                           // pages of the table, in the order of the entries
+  std::vector<uint8_t> buckets_;                              // bucket of each entry
+  std::unordered_map<page_id_t, uint32_t> entries_;           // page id -> index of its entry
+  std::unordered_set<uint32_t> bucket_entries_[NUM_BUCKETS];  // entries in each bucket
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_H
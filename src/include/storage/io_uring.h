@@ -0,0 +1,109 @@
+#ifndef MINISQL_IO_URING_H
+#define MINISQL_IO_URING_H
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/macros.h"
+
+/**
+ * IOUring is a Linux io_uring instance driven through the raw system calls. Requests are queued with PrepareRead or
+ * PrepareWrite, handed to the kernel by Submit, and their results are collected with PopCompletion, so that a thread
+ * can keep many page requests in flight at once.
+ *
+ * An IOUring must only be used by one thread at a time.
+ */
+class IOUring {
+ public:
+  /**
+   * @param entries max number of requests queued or in flight
+   * @throw std::system_error if the kernel does not support io_uring
+   */
+  explicit IOUring(unsigned entries);
+
+  ~IOUring();
+
+  DISALLOW_COPY(IOUring)
+
+  /** @return max number of requests queued or in flight */
+  unsigned GetCapacity() const { return capacity_; }
+
+  /** @return number of requests queued or in flight, whose completion has not been popped yet */
+  unsigned GetOutstanding() const { return outstanding_; }
+
+  /**
+   * Queue a read of len bytes at offset of fd into buf.
+   * @return false if the ring is full
+   */
+  bool PrepareRead(int fd, char *buf, size_t len, uint64_t offset, uint64_t user_data) {
+    return Prepare(IORING_OP_READ, fd, buf, len, offset, user_data);
+  }
+
+  /**
+   * Queue a write of len bytes of buf at offset of fd.
+   * @return false if the ring is full
+   */
+  bool PrepareWrite(int fd, const char *buf, size_t len, uint64_t offset, uint64_t user_data) {
+    return Prepare(IORING_OP_WRITE, fd, const_cast<char *>(buf), len, offset, user_data);
+  }
+
+  /**
+   * Queue a read at offset of fd into the iovcnt buffers of iov, which must stay valid until the request completes.
+   * @return false if the ring is full
+   */
+  bool PrepareReadv(int fd, const iovec *iov, unsigned iovcnt, uint64_t offset, uint64_t user_data) {
+    return Prepare(IORING_OP_READV, fd, reinterpret_cast<char *>(const_cast<iovec *>(iov)), iovcnt, offset, user_data);
+  }
+
+  /**
+   * Queue a write at offset of fd from the iovcnt buffers of iov, which must stay valid until the request completes.
+   * @return false if the ring is full
+   */
+  bool PrepareWritev(int fd, const iovec *iov, unsigned iovcnt, uint64_t offset, uint64_t user_data) {
+    return Prepare(IORING_OP_WRITEV, fd, reinterpret_cast<char *>(const_cast<iovec *>(iov)), iovcnt, offset, user_data);
+  }
+
+  /**
+   * Hand the queued requests to the kernel, and wait until at least wait_nr completions are ready.
+   * @return false if the kernel rejected the call
+   */
+  bool Submit(unsigned wait_nr);
+
+  /**
+   * Pop a completion without waiting.
+   * @param[out] user_data user_data of the completed request
+   * @param[out] result bytes transferred, or a negative errno
+   * @return false if no completion is ready
+   */
+  bool PopCompletion(uint64_t *user_data, int32_t *result);
+
+ private:
+  bool Prepare(uint8_t opcode, int fd, char *buf, size_t len, uint64_t offset, uint64_t user_data);
+
+ private:
+  int ring_fd_{-1};
+  unsigned capacity_{0};
+  unsigned outstanding_{0};  // requests prepared and not popped yet
+  unsigned to_submit_{0};    // requests prepared and not handed to the kernel yet
+  // submission queue
+  void *sq_mapping_{nullptr};
+  size_t sq_mapping_size_{0};
+  unsigned *sq_head_{nullptr};
+  unsigned *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+  // completion queue, shares the mapping of the submission queue if the kernel supports it
+  void *cq_mapping_{nullptr};
+  size_t cq_mapping_size_{0};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  io_uring_cqe *cqes_{nullptr};
+};
+
+#endif  // MINISQL_IO_URING_H
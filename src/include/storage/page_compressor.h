@@ -0,0 +1,37 @@
+#ifndef MINISQL_PAGE_COMPRESSOR_H
+#define MINISQL_PAGE_COMPRESSOR_H
+
+#include <cstddef>
+
+#include "common/config.h"
+
+/**
+ * PageCompressor is a fast LZ77 codec for page images, in the spirit of LZ4. A compressed page is a sequence of
+ * sequences, each made of a token byte holding the number of literals and the length of a match in its high and low
+ * nibble, the extra length bytes of the literals, the literals, then the two-byte offset of the match and its extra
+ * length bytes. The last sequence only has literals. Matches are found through a hash table of the last place where
+ * each four-byte string has been seen, so compression is a single pass over the page.
+ */
+class PageCompressor {
+ public:
+  /**
+   * Compress a page of PAGE_SIZE bytes.
+   * @param dst buffer of capacity bytes
+   * @return size of the compressed page, 0 if it does not fit in capacity
+   */
+  static size_t Compress(const char *src, char *dst, size_t capacity);
+
+  /**
+   * Decompress a page into a buffer of PAGE_SIZE bytes. The compressed data is checked while it is decoded, so that
+   * corrupted data never makes it read or write out of bounds.
+   * @return false if the data is corrupted, i.e. it does not decompress to exactly PAGE_SIZE bytes
+   */
+  static bool Decompress(const char *src, size_t size, char *dst);
+
+ private:
+  static constexpr size_t MIN_MATCH = 4;      // shortest match worth encoding
+  static constexpr size_t MAX_OFFSET = 65535;  // farthest match the two-byte offset can point to
+  static constexpr int HASH_BITS = 12;         // log2 of the number of entries of the match finder
+};
+
+#endif  // MINISQL_PAGE_COMPRESSOR_H
@@ -1,37 +1,66 @@
 #ifndef MINISQL_TABLE_HEAP_H
 #define MINISQL_TABLE_HEAP_H
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
 #include "page/header_page.h"
 #include "page/table_page.h"
 #include "recovery/log_manager.h"
+#include "storage/free_space_map.h"
 #include "storage/table_iterator.h"
 
 class TableHeap {
   friend class TableIterator;
+  friend class TableViewIterator;
+  friend class TableMorselQueue;
 
  public:
+  /**
+   * Create a table heap, and its first page.
+   * @param segment_id segment to store the pages of the table in, see BufferPoolManager::CreateSegment
+   */
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, Schema *schema, Txn *txn, LogManager *log_manager,
-                           LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager);
+                           LockManager *lock_manager, segment_id_t segment_id = MAIN_SEGMENT_ID) {
+    return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager, segment_id);
   }
 
+  /**
+   * Open a table heap.
+   * @param free_space_map_page_id first page of its free space map, INVALID_PAGE_ID for a table created without one,
+   * whose free space map is then built from its pages unless the database is read-only
+   */
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                           LogManager *log_manager, LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager);
+                           LogManager *log_manager, LockManager *lock_manager,
+                           page_id_t free_space_map_page_id = INVALID_PAGE_ID) {
+    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager,
+                         free_space_map_page_id);
   }
 
   ~TableHeap() {}
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Insert a tuple into a page which the free space map finds room in, or into a new page at the end of the table.
+   * If the tuple is too large (>= page_size), return false.
    * @param[in/out] row Tuple Row to insert, the rid of the inserted tuple is wrapped in object row
    * @param[in] txn The recovery performing the insert
    * @return true iff the insert is successful
    */
   bool InsertTuple(Row &row, Txn *txn);
 
+  /**
+   * Append rows to the table, filling its last page and then new pages one after another, each page pinned once while
+   * it is filled. The free space map is not searched for room, but the free space left in each filled page is recorded.
+   * @param[in/out] rows rows to insert, the rid of each inserted row is wrapped in it
+   * @param[in] txn The recovery performing the insert
+   * @return number of rows inserted, the rows after them are not inserted (a row is too large, or no page can be
+   * created)
+   */
+  size_t BulkInsert(std::vector<Row> &rows, Txn *txn);
+
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
    * @param[in] rid Resource id of the tuple of delete
@@ -71,11 +100,29 @@ class TableHeap {
    */
   bool GetTuple(Row *row, Txn *txn);
 
+  /**
+   * Free the pages of the table. A table stored in a segment of its own is freed by dropping the segment.
+   */
   void FreeTableHeap() {
+    if (GetSegmentId() != MAIN_SEGMENT_ID && buffer_pool_manager_->DropSegment(GetSegmentId())) {
+      first_page_id_ = INVALID_PAGE_ID;
+      free_space_map_.reset();
+      return;
+    }
+    if (free_space_map_ != nullptr) {  // 页目录中有所有的页，不必读出每一页找下一页
+      auto page_ids = free_space_map_->GetPageIds(0, SIZE_MAX);
+      free_space_map_->Destroy();
+      free_space_map_.reset();
+      for (auto page_id : page_ids) {
+        buffer_pool_manager_->DeletePage(page_id);
+      }
+      return;
+    }
+    BufferAccessStrategy strategy;
     auto next_page_id = first_page_id_;
     while (next_page_id != INVALID_PAGE_ID) {
       auto old_page_id = next_page_id;
-      auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(old_page_id));
+      auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(old_page_id, &strategy));
       assert(page != nullptr);
       next_page_id = page->GetNextPageId();
       buffer_pool_manager_->UnpinPage(old_page_id, false);
@@ -83,57 +130,127 @@ class TableHeap {
     }
   }
 
+  /**
+   * Move the pages of the table and then those of its free space map towards the front of its file, see
+   * BufferPoolManager::RelocatePage, relinking the pages around each page moved. The first page of the table and that
+   * of the map may move. The table must not be used meanwhile.
+   * @param on_page_moved called with the old and the new id of each page moved, whose rows have new row ids
+   * @return number of pages moved
+   */
+  size_t Compact(const std::function<void(page_id_t old_page_id, page_id_t new_page_id)> &on_page_moved);
+
   /**
    * Free table heap and release storage in disk file
    */
   void DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
 
   /**
+   * @param strategy buffer ring used by the iterator to fetch pages, nullptr to use the whole buffer pool
    * @return the begin iterator of this table
    */
-  TableIterator Begin(Txn *txn);
+  TableIterator Begin(Txn *txn, BufferAccessStrategy *strategy = nullptr);
 
   /**
    * @return the end iterator of this table
    */
   TableIterator End();
 
+  /**
+   * @param strategy buffer ring used by the iterator to fetch pages, nullptr to use the whole buffer pool
+   * @return an iterator over the rows of this table in place, see TableViewIterator
+   */
+  TableViewIterator BeginView(BufferAccessStrategy *strategy = nullptr) { return TableViewIterator(this, strategy); }
+
   /**
    * @return the id of the first page of this table
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * @return whether this table has a page directory, see FreeSpaceMap, without which its pages are found by walking
+   * the page chain
+   */
+  inline bool HasPageDirectory() const { return free_space_map_ != nullptr; }
+
+  /**
+   * @return the number of pages of this table
+   */
+  size_t GetPageCount();
+
+  /**
+   * @return the ids of the pages begin to end - 1 of this table, in chain order, those past the last page are left out
+   */
+  std::vector<page_id_t> GetPageIds(size_t begin, size_t end);
+
+  /**
+   * @return the id of the first page of the free space map of this table, INVALID_PAGE_ID if it has none
+   */
+  inline page_id_t GetFreeSpaceMapPageId() const {
+    return free_space_map_ == nullptr ? INVALID_PAGE_ID : free_space_map_->GetFirstPageId();
+  }
+
+  /**
+   * @return the segment holding the pages of this table, which all follow its first page
+   */
+  inline segment_id_t GetSegmentId() const {
+    return first_page_id_ == INVALID_PAGE_ID ? MAIN_SEGMENT_ID : DiskManager::SegmentOf(first_page_id_);
+  }
+
  private:
   /**
    * create table heap and initialize first page
    */
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, Schema *schema, Txn *txn, LogManager *log_manager,
-                     LockManager *lock_manager)
+                     LockManager *lock_manager, segment_id_t segment_id)
       : buffer_pool_manager_(buffer_pool_manager),
         schema_(schema),
         log_manager_(log_manager),
         lock_manager_(lock_manager) {
-    auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager->NewPage(first_page_id_));
+    auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager->NewPageInSegment(segment_id, first_page_id_));
     ASSERT(first_page != nullptr, "ERROR: cannot create firstPage in table heap, please check");
     // 初始化页面，作为堆的首页，它的前一个页面应该是最后一页的下一个位置
     first_page->Init(first_page_id_, PAGE_SIZE, log_manager, txn);
+    uint32_t free_space = first_page->GetMaxInsertSize();
     buffer_pool_manager->UnpinPage(first_page_id_, true);
     schema_ = schema;
+    free_space_map_.reset(FreeSpaceMap::Create(buffer_pool_manager, first_page_id_));
+    ASSERT(free_space_map_ != nullptr, "ERROR: cannot create free space map in table heap, please check");
+    [[maybe_unused]] bool recorded = free_space_map_->Update(first_page_id_, free_space);
+    ASSERT(recorded, "ERROR: cannot write free space map in table heap, please check");
   };
 
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                     LogManager *log_manager, LockManager *lock_manager)
+                     LogManager *log_manager, LockManager *lock_manager, page_id_t free_space_map_page_id)
       : buffer_pool_manager_(buffer_pool_manager),
         first_page_id_(first_page_id),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {}
+        lock_manager_(lock_manager) {
+    if (free_space_map_page_id != INVALID_PAGE_ID) {
+      free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager, free_space_map_page_id);
+    } else if (!buffer_pool_manager->IsReadOnly()) {
+      CreateFreeSpaceMap();
+    }
+  }
+
+  /**
+   * Build the free space map of a table created without one, from the free space of each of its pages.
+   */
+  void CreateFreeSpaceMap();
+
+  /**
+   * Record the free space of a page in the free space map, if the table has one.
+   * @return false if the map can not be written, see FreeSpaceMap::Update
+   */
+  bool UpdateFreeSpace(page_id_t page_id, TablePage *page) {
+    return free_space_map_ == nullptr || free_space_map_->Update(page_id, page->GetMaxInsertSize());
+  }
 
  private:
   BufferPoolManager *buffer_pool_manager_;
   page_id_t first_page_id_{INVALID_PAGE_ID};
-  page_id_t last_page_id_;
-  uint32_t page_num{0};
+  std::unique_ptr<FreeSpaceMap> free_space_map_;  // free space of each page, nullptr for a table saved without one
+                                                  // and opened read-only, or once the table is freed
   Schema *schema_;
   [[maybe_unused]] LogManager *log_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
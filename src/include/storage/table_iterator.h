@@ -1,21 +1,32 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <atomic>
+#include <vector>
+
 #include "common/config.h"
 #include "common/rowid.h"
 #include "concurrency/txn.h"
 #include "record/row.h"
+#include "record/row_view.h"
 
 class TableHeap;
+class TablePage;
+class BufferAccessStrategy;
+class BufferPoolManager;
 
 class TableIterator {
  public:
   // you may define your own constructor based on your member variables
   explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn) : table_heap_(table_heap), rid(rid), txn(txn) {}
-  explicit TableIterator(TableHeap *table_heap, RowId &rid, Txn *txn, Row *row);
+  explicit TableIterator(TableHeap *table_heap, RowId &rid, Txn *txn, Row *row,
+                         BufferAccessStrategy *strategy = nullptr);
 
   explicit TableIterator(const TableIterator &other);
 
+  /** Take over the row of other, instead of copying it. */
+  TableIterator(TableIterator &&other) noexcept;
+
   virtual ~TableIterator();
 
   bool operator==(const TableIterator &itr) const;
@@ -28,16 +39,126 @@ class TableIterator {
 
   TableIterator &operator=(const TableIterator &itr) noexcept;
 
+  TableIterator &operator=(TableIterator &&itr) noexcept;
+
   TableIterator &operator++();
 
   TableIterator operator++(int);
 
+ private:
+  /**
+   * Called whenever the iterator is on a page, prefetch the pages after it once every half read-ahead window.
+   */
+  void ReadAhead(TablePage *page);
+
  private:
   // add your own private member variables here
   Row *row_{nullptr};
   TableHeap *table_heap_{nullptr};
   RowId rid{INVALID_PAGE_ID, 0};
   Txn *txn;
+  BufferAccessStrategy *strategy_{nullptr};  // ring used to fetch pages, owned by the caller of TableHeap::Begin
+  page_id_t readahead_page_id_{INVALID_PAGE_ID};  // last page seen by ReadAhead
+  int readahead_countdown_{0};                    // number of pages to go before the next read-ahead
+};
+
+/**
+ * TableViewIterator walks the rows of a table without copying them, see TableHeap::BeginView. The page of the current
+ * row stays pinned until the iterator leaves it, and the row is read in place through a RowView, which is valid until
+ * the iterator moves, or until the page is changed: an update may move the rows of the page, so a caller changing
+ * the table should advance the iterator only afterwards, see SeqScanExecutor::Next. The iterator can be moved but not
+ * copied, and unpins its page once it reaches the end or is destroyed.
+ */
+class TableViewIterator {
+  friend class TableMorselQueue;
+
+ public:
+  /** An iterator at the end. */
+  TableViewIterator() = default;
+
+  /** An iterator at the first row of a table. */
+  TableViewIterator(TableHeap *table_heap, BufferAccessStrategy *strategy);
+
+  TableViewIterator(TableViewIterator &&other) noexcept;
+
+  TableViewIterator &operator=(TableViewIterator &&other) noexcept;
+
+  TableViewIterator(const TableViewIterator &) = delete;
+
+  TableViewIterator &operator=(const TableViewIterator &) = delete;
+
+  ~TableViewIterator();
+
+  inline bool IsEnd() const { return page_ == nullptr; }
+
+  /**
+   * @return true if the iterator stopped early because a page of the table could not be fetched (the buffer pool has no
+   * free frame), IsEnd is true then but rows have been skipped
+   */
+  inline bool IsFailed() const { return failed_; }
+
+  const RowView &operator*() const { return view_; }
+
+  const RowView *operator->() const { return &view_; }
+
+  TableViewIterator &operator++();
+
+ private:
+  /** An iterator at the first row of a morsel, which walks only the pages of the morsel, see TableMorselQueue. */
+  TableViewIterator(TableHeap *table_heap, BufferAccessStrategy *strategy, std::vector<page_id_t> morsel);
+
+  /**
+   * Move to the first row at or after slot_num, on the current page or on the pages after it.
+   */
+  void Seek(uint32_t slot_num);
+
+  /** Pin a page of the table as the current page, the iterator fails if it can not be fetched. */
+  void FetchPage(page_id_t page_id);
+
+  /** Unpin the current page, the iterator is at the end afterwards. */
+  void Release();
+
+ private:
+  TableHeap *table_heap_{nullptr};
+  BufferAccessStrategy *strategy_{nullptr};  // ring used to fetch pages, owned by the caller of TableHeap::BeginView
+  TablePage *page_{nullptr};                 // pinned page of the current row, nullptr at the end
+  RowView view_;
+  page_id_t readahead_page_id_{INVALID_PAGE_ID};  // last page seen by the read-ahead
+  int readahead_countdown_{0};                    // number of pages to go before the next read-ahead
+  bool is_morsel_{false};                         // walks the pages of morsel_ instead of the page chain
+  std::vector<page_id_t> morsel_;                 // pages of a morsel
+  size_t morsel_next_{0};                         // index in morsel_ of the page after the current one
+  bool failed_{false};                            // a page could not be fetched, see IsFailed
+};
+
+/**
+ * TableMorselQueue splits the pages of a table into morsels, ranges of up to morsel_size pages in chain order, which
+ * the workers of a parallel scan take one at a time, see SeqScanExecutor. The ranges are cut up front on the page
+ * directory of the table, see TableHeap::GetPageIds, so taking a morsel does not read any page, and each worker reads
+ * the pages of its morsels on its own. The queue can be shared by the workers. A table without a page directory is
+ * walked from its first page for each morsel, so it should be scanned sequentially instead.
+ */
+class TableMorselQueue {
+ public:
+  explicit TableMorselQueue(TableHeap *table_heap, uint32_t morsel_size = MORSEL_PAGES);
+
+  /**
+   * Take the next morsel.
+   * @param[out] iterator iterator over the rows of the morsel, at its first row
+   * @param[out] morsel_id number of the morsel, the morsels are numbered from 0 in chain order
+   * @param strategy ring used by the iterator to fetch pages, owned by the caller, may be nullptr
+   * @return false once all pages of the table have been taken
+   */
+  bool Next(TableViewIterator &iterator, size_t &morsel_id, BufferAccessStrategy *strategy = nullptr);
+
+  /** @return the number of morsels of the table */
+  inline size_t GetMorselCount() const { return (num_pages_ + morsel_size_ - 1) / morsel_size_; }
+
+ private:
+  TableHeap *table_heap_;
+  uint32_t morsel_size_;
+  size_t num_pages_;                    // number of pages of the table when the queue was made
+  std::atomic<size_t> next_morsel_{0};  // next morsel to be taken
 };
 
 #endif  // MINISQL_TABLE_ITERATOR_H
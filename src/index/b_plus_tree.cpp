@@ -14,12 +14,13 @@
  * TODO: Student Implement
  */
 BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &KM,
-                     int leaf_max_size, int internal_max_size)
+                     int leaf_max_size, int internal_max_size, segment_id_t segment_id)
     : index_id_(index_id),
       buffer_pool_manager_(buffer_pool_manager),
       processor_(KM),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {
+      internal_max_size_(internal_max_size),
+      segment_id_(segment_id) {
   // 获取索引的根页面
   auto index_root_page =
       reinterpret_cast<IndexRootsPage *>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID)->GetData());
@@ -34,6 +35,17 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
 }
 
 void BPlusTree::Destroy(page_id_t current_page_id) {
+  if (current_page_id == INVALID_PAGE_ID && segment_id_ != MAIN_SEGMENT_ID) {
+    // 树独占一个段时删除整个段，不必逐页释放；之后再建的页放到主文件中
+    if (!IsEmpty()) {
+      root_page_id_ = INVALID_PAGE_ID;
+      UpdateRootPageId(2);
+    }
+    buffer_pool_manager_->DropSegment(segment_id_);
+    segment_id_ = MAIN_SEGMENT_ID;
+    last_allocated_page_id_ = INVALID_PAGE_ID;
+    return;
+  }
   if (IsEmpty()) return;
   if (current_page_id == INVALID_PAGE_ID) {  // 树已经被销毁
     current_page_id = root_page_id_;
@@ -51,6 +63,62 @@ void BPlusTree::Destroy(page_id_t current_page_id) {
   buffer_pool_manager_->DeletePage(page->GetPageId());        // 删除该页面
 }
 
+size_t BPlusTree::Compact() {
+  size_t moved = 0;
+  if (!IsEmpty()) {
+    page_id_t prev_leaf_id = INVALID_PAGE_ID;
+    CompactSubtree(root_page_id_, nullptr, 0, prev_leaf_id, moved);
+  }
+  return moved;
+}
+
+void BPlusTree::CompactSubtree(page_id_t page_id, InternalPage *parent, int index, page_id_t &prev_leaf_id,
+                               size_t &moved) {
+  page_id_t new_page_id;
+  Page *page = buffer_pool_manager_->RelocatePage(page_id, new_page_id);
+  bool dirty = (page != nullptr);
+  if (page != nullptr) {
+    page_id = new_page_id;
+    moved++;
+  } else if ((page = buffer_pool_manager_->FetchPage(page_id)) == nullptr) {
+    return;
+  }
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  if (dirty) {
+    // 页搬到了前面的空闲页，修正页头中的页号以及所有指向它的指针
+    node->SetPageId(page_id);
+    if (parent == nullptr) {
+      root_page_id_ = page_id;
+      UpdateRootPageId(0);
+    } else {
+      parent->SetValueAt(index, page_id);
+    }
+    if (node->IsLeafPage() && prev_leaf_id != INVALID_PAGE_ID) {
+      auto *prev_leaf = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(prev_leaf_id)->GetData());
+      prev_leaf->SetNextPageId(page_id);
+      buffer_pool_manager_->UnpinPage(prev_leaf_id, true);
+    } else if (!node->IsLeafPage()) {
+      auto *inner = reinterpret_cast<InternalPage *>(node);
+      for (int i = 0; i < inner->GetSize(); i++) {
+        auto *child = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(inner->ValueAt(i))->GetData());
+        child->SetParentPageId(page_id);
+        buffer_pool_manager_->UnpinPage(inner->ValueAt(i), true);
+      }
+    }
+  }
+  if (node->IsLeafPage()) {
+    prev_leaf_id = page_id;
+  } else {
+    auto *inner = reinterpret_cast<InternalPage *>(node);
+    for (int i = 0; i < inner->GetSize(); i++) {
+      page_id_t child_page_id = inner->ValueAt(i);
+      CompactSubtree(child_page_id, inner, i, prev_leaf_id, moved);
+      dirty = dirty || inner->ValueAt(i) != child_page_id;
+    }
+  }
+  buffer_pool_manager_->UnpinPage(page_id, dirty);
+}
+
 /*
  * Helper function to decide whether current b+tree is empty
  */
@@ -106,6 +174,9 @@ bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn
  * keys return false, otherwise return true.
  */
 bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) {
+  if (buffer_pool_manager_->IsReadOnly()) {  // 只读的数据库不能修改
+    return false;
+  }
   if (IsEmpty()) {
     StartNewTree(key, value);
     return true;
@@ -119,7 +190,7 @@ bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) {
  * tree's root page id and insert entry directly into leaf page.
  */
 void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
-  auto *page = buffer_pool_manager_->NewPage(root_page_id_);  // 分配一个新页作为根页面
+  auto *page = NewTreePage(root_page_id_);  // 分配一个新页作为根页面
   if (page == nullptr) {
   }
   auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
@@ -162,6 +233,17 @@ bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transac
   return true;
 }
 
+Page *BPlusTree::NewTreePage(page_id_t &page_id) {
+  // 树的第一个页(或重新打开后的第一个页)放到树的段中，之后的页紧随上一个页
+  Page *page = (last_allocated_page_id_ == INVALID_PAGE_ID
+                    ? buffer_pool_manager_->NewPageInSegment(segment_id_, page_id)
+                    : buffer_pool_manager_->NewPageNear(page_id, last_allocated_page_id_));
+  if (page != nullptr) {
+    last_allocated_page_id_ = page_id;
+  }
+  return page;
+}
+
 /*
  * Split input page and return newly created page.
  * Using template N to represent either internal page or leaf page.
@@ -171,11 +253,11 @@ bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transac
  */
 BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) {
   page_id_t new_page_id;  // 新建页面用于存储被分裂的元素
-  auto *page = buffer_pool_manager_->NewPage(new_page_id);
+  auto *page = NewTreePage(new_page_id);
   if (page == nullptr) {
     return nullptr;  // 无法获取新页面
   }
-  BPlusTreeInternalPage *new_page = reinterpret_cast<InternalPage *>(page);
+  BPlusTreeInternalPage *new_page = reinterpret_cast<InternalPage *>(page->GetData());
   new_page->Init(new_page_id, node->GetParentPageId(), node->GetKeySize(), node->GetMaxSize());
   node->MoveHalfTo(new_page, buffer_pool_manager_);  // 移动一半
   return new_page;
@@ -183,11 +265,11 @@ BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) {
 
 BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
   page_id_t new_page_id;  // 类似内部节点的分裂
-  auto *page = buffer_pool_manager_->NewPage(new_page_id);
+  auto *page = NewTreePage(new_page_id);
   if (page == nullptr) {
     return nullptr;
   }
-  BPlusTreeLeafPage *new_node = reinterpret_cast<LeafPage *>(page);
+  BPlusTreeLeafPage *new_node = reinterpret_cast<LeafPage *>(page->GetData());
   new_node->Init(new_page_id, node->GetParentPageId(), node->GetKeySize(), node->GetMaxSize());
   node->MoveHalfTo(new_node);
   return new_node;
@@ -204,7 +286,7 @@ BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
  */
 void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, Txn *transaction) {
   if (old_node->IsRootPage()) {  // 旧节点是根节点则新创一个父节点作为根节点
-    auto *page = buffer_pool_manager_->NewPage(root_page_id_);  // 创建一个新页面来作为新的根节点
+    auto *page = NewTreePage(root_page_id_);  // 创建一个新页面来作为新的根节点
     if (page == nullptr) {
     }
     auto *root_page = reinterpret_cast<InternalPage *>(page->GetData());
@@ -239,7 +321,7 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
  * necessary.
  */
 void BPlusTree::Remove(const GenericKey *key, Txn *transaction) {
-  if (IsEmpty()) {
+  if (IsEmpty() || buffer_pool_manager_->IsReadOnly()) {
     return;
   }
   auto *leaf =
@@ -254,6 +336,20 @@ void BPlusTree::Remove(const GenericKey *key, Txn *transaction) {
   buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);  // 叶子页大小发生变化
 }
 
+bool BPlusTree::Update(const GenericKey *key, const RowId &value, Txn *transaction) {
+  if (IsEmpty() || buffer_pool_manager_->IsReadOnly()) {
+    return false;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(FindLeafPage(key, INVALID_PAGE_ID, false)->GetData());
+  int index = leaf->KeyIndex(key, processor_);
+  bool found = (index < leaf->GetSize() && processor_.CompareKeys(key, leaf->KeyAt(index)) == 0);
+  if (found) {
+    leaf->SetValueAt(index, value);  // 键不变，树的结构也不变
+  }
+  buffer_pool_manager_->UnpinPage(leaf->GetPageId(), found);
+  return found;
+}
+
 /* todo
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size > page's max size, then redistribute. Otherwise, merge.
@@ -441,7 +537,8 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
   if (page_id == INVALID_PAGE_ID) {  // 如果没有指定初始页面id则从根页面开始
     page_id = root_page_id_;
   }
-  auto *page = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(page_id)->GetData());
+  Page *raw_page = buffer_pool_manager_->FetchPage(page_id);
+  auto *page = reinterpret_cast<BPlusTreePage *>(raw_page->GetData());
   while (!page->IsLeafPage()) {  // 不是叶子页面则继续向下查找
     auto inner = reinterpret_cast<InternalPage *>(page);
     page_id_t child_id;
@@ -450,11 +547,12 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
     } else {
       child_id = inner->Lookup(key, processor_);
     }
-    auto child = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(child_id)->GetData());
+    raw_page = buffer_pool_manager_->FetchPage(child_id);
+    auto child = reinterpret_cast<BPlusTreePage *>(raw_page->GetData());
     buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
     page = child;  // 更新当前页面为子页面
   }
-  return reinterpret_cast<Page *>(page);
+  return raw_page;
 }
 
 /*
@@ -3,10 +3,10 @@
 #include "index/generic_key.h"
 #include "utils/tree_file_mgr.h"
 BPlusTreeIndex::BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
-                               BufferPoolManager *buffer_pool_manager)
+                               BufferPoolManager *buffer_pool_manager, segment_id_t segment_id)
     : Index(index_id, key_schema),
       processor_(key_schema_, key_size),
-      container_(index_id, buffer_pool_manager, processor_) {}
+      container_(index_id, buffer_pool_manager, processor_, UNDEFINED_SIZE, UNDEFINED_SIZE, segment_id) {}
 
 dberr_t BPlusTreeIndex::InsertEntry(const Row &key, RowId row_id, Txn *txn) {
   // ASSERT(row_id.Get() != INVALID_ROWID.Get(), "Invalid row id for index insert.");
@@ -35,6 +35,15 @@ dberr_t BPlusTreeIndex::RemoveEntry(const Row &key, RowId row_id, Txn *txn) {
   return DB_SUCCESS;
 }
 
+dberr_t BPlusTreeIndex::UpdateEntry(const Row &key, RowId row_id, Txn *txn) {
+  GenericKey *index_key = processor_.InitKey();
+  processor_.SerializeFromKey(index_key, key, key_schema_);
+
+  bool status = container_.Update(index_key, row_id, txn);
+  delete index_key;
+  return status ? DB_SUCCESS : DB_KEY_NOT_FOUND;
+}
+
 dberr_t BPlusTreeIndex::ScanKey(const Row &key, vector<RowId> &result, Txn *txn, string compare_operator) {
   GenericKey *index_key = processor_.InitKey();
   processor_.SerializeFromKey(index_key, key, key_schema_);
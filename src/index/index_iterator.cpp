@@ -8,6 +8,7 @@ IndexIterator::IndexIterator() = default;
 IndexIterator::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
     : current_page_id(page_id), item_index(index), buffer_pool_manager(bpm) {
   page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
+  ReadAhead();
 }
 
 IndexIterator::~IndexIterator() {
@@ -28,6 +29,7 @@ IndexIterator &IndexIterator::operator++() {
     buffer_pool_manager->UnpinPage(page->GetPageId(), false);
     page = next_page;  // 更新当前页为下一页
     item_index = 0;
+    ReadAhead();
   }
   if (item_index == (page->GetSize())) {  // 重置迭代器为初始状态
     buffer_pool_manager->UnpinPage(current_page_id, false);
@@ -43,4 +45,14 @@ bool IndexIterator::operator==(const IndexIterator &itr) const {
   return current_page_id == itr.current_page_id && item_index == itr.item_index;
 }
 
-bool IndexIterator::operator!=(const IndexIterator &itr) const { return !(*this == itr); }
\ No newline at end of file
+bool IndexIterator::operator!=(const IndexIterator &itr) const { return !(*this == itr); }
+void IndexIterator::ReadAhead() {
+  if (readahead_countdown-- > 0) {
+    return;
+  }
+  // 每走过半个预读窗口，就沿叶子链表再预读一个窗口
+  readahead_countdown = DEFAULT_PREFETCH_DISTANCE / 2;
+  buffer_pool_manager->PrefetchChain(page->GetNextPageId(), DEFAULT_PREFETCH_DISTANCE, [](Page *page) {
+    return reinterpret_cast<LeafPage *>(page->GetData())->GetNextPageId();
+  });
+}
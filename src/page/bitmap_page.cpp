@@ -1,5 +1,9 @@
 #include "page/bitmap_page.h"
 
+#include <endian.h>
+
+#include <cstring>
+
 #include "glog/logging.h"
 
 template <size_t PageSize>
@@ -14,14 +18,7 @@ bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
   // 2 ，那么 1234 放在 M 的下标 154 字节处，把该字节的 2 号位（0~7）置为 1
   page_allocated_++;
   page_offset = next_free_page_;
-  next_free_page_ = 8 * MAX_CHARS;
-  for (uint32_t i = (page_offset + 1); i < 8 * MAX_CHARS; i++) {
-    if ((bytes[i >> 3] & (0x80 >> (i & 0x07))) == 0) {
-      next_free_page_ = i;
-      // 当前是空闲页
-      break;
-    }
-  }
+  next_free_page_ = FindFreePage(page_offset + 1);
   return true;
 }
 
@@ -45,6 +42,52 @@ bool BitmapPage<PageSize>::IsPageFree(uint32_t page_offset) const {
   return IsPageFreeLow(byte_index, bit_index);
 }
 
+template <size_t PageSize>
+bool BitmapPage<PageSize>::AllocatePageAt(uint32_t page_offset) {
+  if (page_offset >= 8 * MAX_CHARS || !IsPageFree(page_offset)) {
+    return false;
+  }
+  bytes[page_offset >> 3] |= (0x80 >> (page_offset & 0x07));
+  page_allocated_++;
+  if (page_offset == next_free_page_) {
+    next_free_page_ = FindFreePage(page_offset + 1);
+  }
+  return true;
+}
+
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::FindFreeRun(uint32_t start, uint32_t num_pages) const {
+  const uint32_t num_words = MAX_CHARS / sizeof(uint64_t);
+  const uint32_t run_words = (num_pages + 63) / 64;
+  uint32_t free_words = 0;  // 以word_index结尾的连续全空的字数
+  for (uint32_t word_index = (start + 63) / 64; word_index < num_words; word_index++) {
+    uint64_t word;
+    memcpy(&word, bytes + word_index * sizeof(uint64_t), sizeof(uint64_t));
+    free_words = (word == 0 ? free_words + 1 : 0);
+    if (free_words == run_words) {
+      return (word_index + 1 - run_words) * 64;
+    }
+  }
+  return 8 * MAX_CHARS;
+}
+
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::FindFreePage(uint32_t start) const {
+  // 每8个字节按大端序拼成一个64位字，最高位对应最小的页号，取反后前导零的个数即为字内第一个空闲页
+  for (uint32_t word_index = start / 64; word_index < MAX_CHARS / sizeof(uint64_t); word_index++) {
+    uint64_t word;
+    memcpy(&word, bytes + word_index * sizeof(uint64_t), sizeof(uint64_t));
+    uint64_t free_bits = ~be64toh(word);
+    if (word_index == start / 64) {
+      free_bits &= ~static_cast<uint64_t>(0) >> (start % 64);  // 跳过start之前的页
+    }
+    if (free_bits != 0) {
+      return word_index * 64 + __builtin_clzll(free_bits);
+    }
+  }
+  return 8 * MAX_CHARS;
+}
+
 template <size_t PageSize>
 bool BitmapPage<PageSize>::IsPageFreeLow(uint32_t byte_index, uint8_t bit_index) const {
   if (bytes[byte_index] & (1 << (7 - bit_index))) return false;
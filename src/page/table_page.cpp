@@ -164,6 +164,14 @@ bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_m
   return true;
 }
 
+const char *TablePage::GetTupleData(const RowId &rid) {
+  uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount() || IsDeleted(GetTupleSize(slot_num))) {
+    return nullptr;
+  }
+  return GetData() + GetTupleOffsetAtSlot(slot_num);
+}
+
 bool TablePage::GetFirstTupleRid(RowId *first_rid) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); i++) {
@@ -0,0 +1,45 @@
+#include "record/row_view.h"
+
+Field RowView::GetField(uint32_t idx, bool manage_data) const {
+  ASSERT(idx < GetFieldCount(), "Failed to access field");
+  TypeId type_id = schema_->GetColumn(idx)->GetType();
+  if (IsNull(idx)) {
+    return Field(type_id);
+  }
+  const char *data = GetFieldData(idx);
+  switch (type_id) {
+    case kTypeInt:
+      return Field(kTypeInt, MACH_READ_FROM(int32_t, data));
+    case kTypeFloat:
+      return Field(kTypeFloat, MACH_READ_FROM(float_t, data));
+    case kTypeChar:
+      // 默认不拷贝字符串，字段直接指向行中的数据
+      return Field(kTypeChar, const_cast<char *>(data + sizeof(uint32_t)), MACH_READ_UINT32(data), manage_data);
+    default:
+      ASSERT(false, "Unsupported field type.");
+      return Field(type_id);
+  }
+}
+
+void RowView::ToRow(Row &row) const {
+  row.destroy();
+  row.SetRowId(rid_);
+  row.DeserializeFrom(const_cast<char *>(data_), schema_);
+}
+
+const char *RowView::GetFieldData(uint32_t idx) const {
+  if (offsets_.empty()) {
+    offsets_.push_back(sizeof(uint32_t) + MACH_READ_UINT32(data_));  // 跳过位图
+  }
+  // 从已知的最后一个字段往后走到第idx个字段
+  while (offsets_.size() <= idx) {
+    uint32_t field = offsets_.size() - 1;
+    uint32_t offset = offsets_.back();
+    if (!IsNull(field)) {
+      TypeId type_id = schema_->GetColumn(field)->GetType();
+      offset += type_id == kTypeChar ? sizeof(uint32_t) + MACH_READ_UINT32(data_ + offset) : Type::GetTypeSize(type_id);
+    }
+    offsets_.push_back(offset);
+  }
+  return data_ + offsets_[idx];
+}
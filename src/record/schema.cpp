@@ -42,6 +42,7 @@ uint32_t Schema::DeserializeFrom(char *buf, Schema *&schema) {
     size += Column::DeserializeFrom(buf + size, columns[i]);
   }
   is_manage = MACH_READ_FROM(bool, buf + size);
+  size += sizeof is_manage;
   schema = new Schema(columns, is_manage);  // 返回反序列化成果
   if (schema == nullptr) {
     return 0;
@@ -1,110 +1,581 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
 #include <page/page.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
 #include <cmath>
 #include <filesystem>
+#include <iterator>
+#include <memory>
 #include <stdexcept>
+#include <system_error>
+#include <utility>
 
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
+#include "storage/io_uring.h"
+#include "storage/page_compressor.h"
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+// 内核不支持io_uring(或已被禁用)后，所有线程都改用同步读写
+static std::atomic<bool> io_uring_unavailable{!ENABLE_IO_URING};
+
+/**
+ * @return the io_uring of the calling thread, created on first use, nullptr if io_uring is not available
+ */
+static std::unique_ptr<IOUring> &GetThreadIOUring() {
+  thread_local std::unique_ptr<IOUring> ring;
+  if (ring == nullptr && !io_uring_unavailable) {
+    try {
+      ring = std::make_unique<IOUring>(IO_URING_QUEUE_DEPTH);
+    } catch (std::system_error &e) {
+      LOG(WARNING) << "io_uring is not available, falling back to synchronous I/O: " << e.what();
+      io_uring_unavailable = true;
+    }
+  }
+  return ring;
+}
+
+/** @return true if a buffer can be used for direct I/O as it is */
+static bool IsAligned(const char *data) { return reinterpret_cast<uintptr_t>(data) % PAGE_SIZE == 0; }
+
+/** @return an aligned buffer of the calling thread, for direct I/O of unaligned buffers */
+static char *GetBounceBuffer() {
+  alignas(PAGE_SIZE) static thread_local char buffer[PAGE_SIZE];
+  return buffer;
+}
+
+/** @return a buffer of the calling thread, to hold a compressed page */
+static char *GetCompressionBuffer() {
+  static thread_local char buffer[PAGE_SIZE];
+  return buffer;
+}
+
+DiskManager::DiskManager(const std::string &db_file, bool direct_io, bool read_only, bool compress,
+                         segment_id_t segment_id)
+    : file_name_(db_file),
+      segment_id_(segment_id),
+      bitmaps_(MAX_VALID_PAGE_ID / BITMAP_SIZE),
+      bitmap_dirty_(MAX_VALID_PAGE_ID / BITMAP_SIZE, false),
+      direct_io_(direct_io && !read_only),
+      read_only_(read_only) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
+  if (read_only_) {
+    // 只读模式下文件必须已经存在
+    db_fd_ = open(db_file.c_str(), O_RDONLY | O_CLOEXEC);
+  } else {
+    // directory does not exist
     std::filesystem::path p = db_file;
     if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
+    // create a new file if it does not exist
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | (direct_io_ ? O_DIRECT : 0), 0644);
+  }
+  if (db_fd_ < 0 && direct_io_ && errno == EINVAL) {
+    // 文件系统(如tmpfs)不支持O_DIRECT，改用普通的读写
+    LOG(WARNING) << "O_DIRECT is not supported for " << db_file << ", falling back to buffered I/O";
+    direct_io_ = false;
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw std::exception();
+  }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) == 0) {
+    file_size_ = stat_buf.st_size;
+  }
+  ReadPhysicalPage(META_PAGE_ID, meta_data_);
+  // 新文件按要求的格式创建，已有文件的格式记录在meta page中
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  if (compress && !read_only_ && file_size_ == 0) {
+    meta_page->format_ = COMPRESSED_FILE_FORMAT;
+    meta_dirty_ = true;
+  }
+  if (meta_page->IsCompressed()) {
+    compressed_ = true;
+    if (direct_io_) {
+      // 压缩后的页大小不一，无法直接读写对齐的缓冲区
+      LOG(WARNING) << "O_DIRECT is not supported for compressed file " << db_file << ", falling back to buffered I/O";
+      fcntl(db_fd_, F_SETFL, fcntl(db_fd_, F_GETFL) & ~O_DIRECT);
+      direct_io_ = false;
+    }
+    LoadPageLocations();
+  }
+  if (read_only_ && !compressed_ && file_size_ > 0) {
+    // 整个文件只映射一次，页直接在映射中读取，由内核的页缓存负责换入换出
+    void *mapping = mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, db_fd_, 0);
+    if (mapping == MAP_FAILED) {
+      LOG(ERROR) << "Failed to map " << db_file << ": " << strerror(errno);
+      close(db_fd_);
       throw std::exception();
     }
+    mapping_ = static_cast<char *>(mapping);
+    mapping_size_ = file_size_;
   }
-  ReadPhysicalPage(META_PAGE_ID, meta_data_);
+}
+
+void DiskManager::Sync() {
+  if (read_only_) {
+    return;
+  }
+  std::vector<std::pair<uint32_t, uint32_t>> released;
+  {
+    // 分配和释放页时只修改内存中的位图和meta page，在这里统一写回
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    for (size_t i = 0; i < bitmaps_.size(); i++) {
+      if (bitmap_dirty_[i]) {
+        WritePhysicalPage(GetBitmapPageId(i), reinterpret_cast<const char *>(bitmaps_[i].get()));
+        bitmap_dirty_[i] = false;
+      }
+    }
+    if (compressed_) {
+      released = WritePageLocations();
+    }
+    if (meta_dirty_) {
+      WritePhysicalPage(META_PAGE_ID, meta_data_);
+      meta_dirty_ = false;
+    }
+  }
+  if (fdatasync(db_fd_) != 0) {
+    LOG(ERROR) << "I/O error while syncing " << file_name_;
+    return;  // 新的页位置表未必已落盘，释放的扇区留到下次打开文件时再回收
+  }
+  {
+    // 释放这些run的位图已落盘，即使崩溃也不会再引用其中的页
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    PunchFreeRuns();
+  }
+  // 落盘的页位置表不再引用这些扇区，可以重用了
+  std::scoped_lock<std::mutex> lock(location_latch_);
+  for (const auto &range : released) {
+    FreeSectors(range.first, range.second);
+  }
+}
+
+void DiskManager::PunchFreeRuns() {
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  for (auto run : free_runs_) {
+    // 入队之后run可能又被分配出去了，分配也要持有db_io_latch_，所以这里的检查在打洞时仍然成立
+    uint32_t extent_id = run / BITMAP_SIZE;
+    uint32_t page_offset = run % BITMAP_SIZE;
+    if (extent_id >= meta_page->GetExtentNums() ||
+        GetBitmap(extent_id)->FindFreeRun(page_offset, ALLOCATION_RUN_PAGES) != page_offset) {
+      continue;
+    }
+    size_t start = static_cast<size_t>(MapPageId(run)) * PAGE_SIZE;
+    size_t end = std::min(start + ALLOCATION_RUN_PAGES * PAGE_SIZE, file_size_.load());
+    if (start < end && fallocate(db_fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, start, end - start) != 0) {
+      if (errno == EOPNOTSUPP) {
+        break;  // 文件系统不支持打洞，空间留给之后分配的页
+      }
+      LOG(WARNING) << "Failed to punch a hole in " << file_name_ << ": " << strerror(errno);
+    }
+  }
+  free_runs_.clear();
+}
+
+void DiskManager::TruncateFile() {
+  if (read_only_) {
+    return;
+  }
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  // 末尾没有页的分区连同其位图一起去掉
+  while (meta_page->num_extents_ > 0 && meta_page->extent_used_page_[meta_page->num_extents_ - 1] == 0) {
+    uint32_t extent_id = --meta_page->num_extents_;
+    if (compressed_) {
+      ReleaseCompressedPage(GetBitmapPageId(extent_id));
+    }
+    bitmaps_[extent_id].reset();
+    bitmap_dirty_[extent_id] = false;
+    meta_dirty_ = true;
+  }
+  next_free_extent_ = std::min(next_free_extent_, meta_page->num_extents_);
+  // 先让缩小后的meta page落盘，崩溃后它不会引用被截掉的页
+  Sync();
+  size_t end;
+  std::unique_lock<std::mutex> location_lock(location_latch_, std::defer_lock);
+  if (compressed_) {
+    location_lock.lock();  // 写入压缩页时从end_sector_追加，截断期间不能分配扇区
+    end = static_cast<size_t>(end_sector_) * COMPRESSION_SECTOR_SIZE;
+  } else if (meta_page->num_extents_ == 0) {
+    end = PAGE_SIZE;  // 只剩meta page
+  } else {
+    uint32_t extent_id = meta_page->num_extents_ - 1;
+    BitmapPage<PAGE_SIZE> *bitmap = GetBitmap(extent_id);
+    uint32_t page_offset = BITMAP_SIZE;
+    while (bitmap->IsPageFree(page_offset - 1)) {
+      page_offset--;
+    }
+    end = static_cast<size_t>(MapPageId(extent_id * BITMAP_SIZE + page_offset - 1) + 1) * PAGE_SIZE;
+  }
+  if (end >= file_size_) {
+    return;
+  }
+  if (ftruncate(db_fd_, end) != 0) {
+    LOG(WARNING) << "Failed to truncate " << file_name_ << ": " << strerror(errno);
+    return;
+  }
+  file_size_ = end;
 }
 
 void DiskManager::Close() {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  WritePhysicalPage(META_PAGE_ID, meta_data_);
   if (!closed) {
-    db_io_.close();
+    Sync();
+    if (mapping_ != nullptr) {
+      munmap(mapping_, mapping_size_);
+      mapping_ = nullptr;
+    }
+    close(db_fd_);
     closed = true;
   }
 }
 
 void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
-  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  ASSERT(GetLocalPageId(logical_page_id) >= 0, "Invalid page id.");
   ReadPhysicalPage(MapPageId(logical_page_id), page_data);
 }
 
 void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
-  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  ASSERT(GetLocalPageId(logical_page_id) >= 0, "Invalid page id.");
+  if (read_only_) {
+    LOG(ERROR) << "Write to " << file_name_ << " which is opened in read-only mode";
+    return;
+  }
   WritePhysicalPage(MapPageId(logical_page_id), page_data);
 }
 
+char *DiskManager::GetMappedPage(page_id_t logical_page_id) {
+  ASSERT(GetLocalPageId(logical_page_id) >= 0, "Invalid page id.");
+  size_t offset = static_cast<size_t>(MapPageId(logical_page_id)) * PAGE_SIZE;
+  if (offset + PAGE_SIZE > mapping_size_) {
+    return nullptr;
+  }
+  return mapping_ + offset;
+}
+
+struct DiskManager::PageRun {
+  page_id_t physical_page_id_;                      // first page of the run
+  std::vector<iovec> iovecs_;                       // data of each page of the run
+  std::vector<std::pair<size_t, char *>> copies_;  // reads of a page already in the run: (index in iovecs_, data)
+};
+
+void DiskManager::ReadPages(const std::vector<PageIORequest> &requests) { TransferPages(requests, false); }
+
+void DiskManager::WritePages(const std::vector<PageIORequest> &requests) {
+  if (read_only_) {
+    LOG(ERROR) << "Write to " << file_name_ << " which is opened in read-only mode";
+    return;
+  }
+  TransferPages(requests, true);
+}
+
+void DiskManager::TransferPages(const std::vector<PageIORequest> &requests, bool write) {
+  if (compressed_) {
+    // 压缩后的页大小不一，逐页读写
+    for (const auto &request : requests) {
+      ASSERT(GetLocalPageId(request.page_id_) >= 0, "Invalid page id.");
+      if (write) {
+        WriteCompressedPage(MapPageId(request.page_id_), request.data_);
+      } else {
+        ReadCompressedPage(MapPageId(request.page_id_), request.data_);
+      }
+    }
+    return;
+  }
+  std::vector<PageRun> runs = BuildPageRuns(requests, write);
+  if (!SubmitPageRuns(runs, write)) {
+    for (const auto &run : runs) {
+      TransferPageRun(run, write);
+    }
+  }
+  // 同一页被多次读取时只读一次，再复制给其余的请求
+  for (const auto &run : runs) {
+    for (const auto &[index, data] : run.copies_) {
+      memcpy(data, run.iovecs_[index].iov_base, PAGE_SIZE);
+    }
+  }
+}
+
+std::vector<DiskManager::PageRun> DiskManager::BuildPageRuns(const std::vector<PageIORequest> &requests, bool write) {
+  std::vector<std::pair<page_id_t, char *>> pages;  // (物理页号, 数据)
+  for (const auto &request : requests) {
+    ASSERT(GetLocalPageId(request.page_id_) >= 0, "Invalid page id.");
+    page_id_t physical_page_id = MapPageId(request.page_id_);
+    size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
+    if (!write && offset >= file_size_) {  // check if read beyond file length
+      memset(request.data_, 0, PAGE_SIZE);
+    } else if (direct_io_ && !IsAligned(request.data_) && write) {  // 未对齐的缓冲区经由对齐的缓冲区同步读写
+      WritePhysicalPage(physical_page_id, request.data_);
+    } else if (direct_io_ && !IsAligned(request.data_)) {
+      ReadPhysicalPage(physical_page_id, request.data_);
+    } else {
+      pages.emplace_back(physical_page_id, request.data_);
+    }
+  }
+  // 按物理页号排序，同一页的多个请求保持原有顺序
+  std::stable_sort(pages.begin(), pages.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  std::vector<PageRun> runs;
+  for (const auto &page : pages) {
+    iovec iov{page.second, PAGE_SIZE};
+    if (!runs.empty()) {
+      PageRun &run = runs.back();
+      page_id_t next_page_id = run.physical_page_id_ + static_cast<page_id_t>(run.iovecs_.size());
+      if (page.first == next_page_id - 1) {
+        // 同一页被多次请求：写以最后一个请求为准，读则每个请求都要拿到该页
+        if (write) {
+          run.iovecs_.back() = iov;
+        } else {
+          run.copies_.emplace_back(run.iovecs_.size() - 1, page.second);
+        }
+        continue;
+      }
+      if (page.first == next_page_id && run.iovecs_.size() < IOV_MAX) {
+        run.iovecs_.push_back(iov);
+        continue;
+      }
+    }
+    runs.push_back({page.first, {iov}, {}});
+  }
+  return runs;
+}
+
+bool DiskManager::SubmitPageRuns(const std::vector<PageRun> &runs, bool write) {
+  std::unique_ptr<IOUring> &ring = GetThreadIOUring();
+  if (ring == nullptr) {
+    return false;
+  }
+  std::vector<bool> done(runs.size(), false);
+  size_t next = 0;
+  while (true) {
+    // 不断补充请求，使队列中始终有尽可能多的请求
+    for (; next < runs.size(); next++) {
+      const PageRun &run = runs[next];
+      uint64_t offset = static_cast<uint64_t>(run.physical_page_id_) * PAGE_SIZE;
+      bool queued;
+      if (run.iovecs_.size() == 1) {
+        char *data = static_cast<char *>(run.iovecs_[0].iov_base);
+        queued = (write ? ring->PrepareWrite(db_fd_, data, PAGE_SIZE, offset, next)
+                        : ring->PrepareRead(db_fd_, data, PAGE_SIZE, offset, next));
+      } else {
+        queued = (write ? ring->PrepareWritev(db_fd_, run.iovecs_.data(), run.iovecs_.size(), offset, next)
+                        : ring->PrepareReadv(db_fd_, run.iovecs_.data(), run.iovecs_.size(), offset, next));
+      }
+      if (!queued) {
+        break;
+      }
+    }
+    if (ring->GetOutstanding() == 0) {
+      return true;
+    }
+    if (!ring->Submit(1)) {
+      // 关闭io_uring，未提交的请求不会再被执行；未完成的run改为同步读写
+      LOG(ERROR) << "io_uring_enter failed, falling back to synchronous I/O: " << strerror(errno);
+      ring.reset();
+      io_uring_unavailable = true;
+      for (size_t i = 0; i < runs.size(); i++) {
+        if (!done[i]) {
+          TransferPageRun(runs[i], write);
+        }
+      }
+      return true;
+    }
+    uint64_t index;
+    int32_t result;
+    while (ring->PopCompletion(&index, &result)) {
+      const PageRun &run = runs[index];
+      done[index] = true;
+      size_t run_size = run.iovecs_.size() * PAGE_SIZE;
+      if (result < 0 || static_cast<size_t>(result) != run_size) {
+        TransferPageRun(run, write);  // 出错、被中断或只传输了部分数据时，同步地重新读写
+      } else if (write) {
+        UpdateFileSize(static_cast<size_t>(run.physical_page_id_) * PAGE_SIZE + run_size);
+      }
+    }
+  }
+}
+
+void DiskManager::TransferPageRun(const PageRun &run, bool write) {
+  size_t offset = static_cast<size_t>(run.physical_page_id_) * PAGE_SIZE;
+  size_t run_size = run.iovecs_.size() * PAGE_SIZE;
+  ssize_t ret;
+  do {
+    ret = (write ? pwritev(db_fd_, run.iovecs_.data(), run.iovecs_.size(), offset)
+                 : preadv(db_fd_, run.iovecs_.data(), run.iovecs_.size(), offset));
+  } while (ret < 0 && errno == EINTR);
+  if (ret >= 0 && static_cast<size_t>(ret) == run_size) {
+    if (write) {
+      UpdateFileSize(offset + run_size);
+    }
+    return;
+  }
+  // 出错或只传输了部分数据时逐页重新读写，读到文件末尾之后的部分补零
+  for (size_t i = 0; i < run.iovecs_.size(); i++) {
+    char *data = static_cast<char *>(run.iovecs_[i].iov_base);
+    if (write) {
+      WritePhysicalPage(run.physical_page_id_ + i, data);
+    } else {
+      ReadPhysicalPage(run.physical_page_id_ + i, data);
+    }
+  }
+}
+
 /**
  * TODO: Student Implement
  */
 page_id_t DiskManager::AllocatePage() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
   uint32_t id;
   DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(this->GetMetaData());
-  if (meta_page->GetAllocatedPages() == MAX_VALID_PAGE_ID)
-    return INVALID_PAGE_ID;                                   // 如果当前的页数已满，则返回INVALID_PAGE_ID
-  for (page_id_t i = 0; i < meta_page->GetExtentNums(); i++)  // 遍历所有分区
-  {
-    if (meta_page->GetExtentUsedPage(i) != BITMAP_SIZE) {  // 如果该分区的bitmap未满，则分配一个页
-      char buf[PAGE_SIZE];
-      ReadPhysicalPage(i * (BITMAP_SIZE + 1) + 1, buf);  // 把对应分区的bitmap读取出来
-      BitmapPage<PAGE_SIZE> *bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(buf);
-      if (bitmap->AllocatePage(id)) {
-        meta_page->extent_used_page_[i]++;
-        meta_page->num_allocated_pages_++;
-        WritePhysicalPage(META_PAGE_ID, this->GetMetaData());  // 重新写回meta_page对应的物理页
-        WritePhysicalPage(i * (BITMAP_SIZE + 1) + 1, buf);     // 修改后重新写回bitmap对应物理页中
-        return page_id_t(i * BITMAP_SIZE + id);
-      }
+  if (read_only_ || meta_page->GetAllocatedPages() == MAX_VALID_PAGE_ID)
+    return INVALID_PAGE_ID;  // 如果当前的页数已满或文件只读，则返回INVALID_PAGE_ID
+  // next_free_extent_之前的分区都已满，从它开始查找
+  for (uint32_t i = next_free_extent_; i < meta_page->GetExtentNums(); i++) {
+    if (meta_page->GetExtentUsedPage(i) != BITMAP_SIZE && GetBitmap(i)->AllocatePage(id)) {
+      next_free_extent_ = i;
+      return OnPageAllocated(i, id);
     }
   }
   // 前面所有分区都已经满了，则开一个新的分区
-  char buf[PAGE_SIZE];
-  memset(buf, 0, PAGE_SIZE);
-  BitmapPage<PAGE_SIZE> *bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(buf);
-  if (bitmap->AllocatePage(id)) {  // 分配一个页
-    meta_page->num_extents_++;
-    uint32_t i = meta_page->num_extents_ - 1;  // 现在的分区编号
-    meta_page->extent_used_page_[i]++;
-    meta_page->num_allocated_pages_++;
-    WritePhysicalPage(META_PAGE_ID, this->GetMetaData());  // 重新写回meta_page对应的物理页
-    WritePhysicalPage(i * (BITMAP_SIZE + 1) + 1, buf);     // 修改后重新写回bitmap对应物理页中
-    return page_id_t(i * BITMAP_SIZE + id);
+  uint32_t i = AddExtent();
+  if (GetBitmap(i)->AllocatePage(id)) {  // 分配一个页
+    next_free_extent_ = i;
+    return OnPageAllocated(i, id);
+  }
+  return INVALID_PAGE_ID;
+}
+
+page_id_t DiskManager::AllocatePageNear(page_id_t near_page_id) {
+  static_assert(BITMAP_SIZE % ALLOCATION_RUN_PAGES == 0, "Runs must not cross extents.");
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(this->GetMetaData());
+  if (read_only_ || meta_page->GetAllocatedPages() == MAX_VALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  near_page_id = GetLocalPageId(near_page_id);  // 其他段的页不能作为提示
+  if (near_page_id >= 0 && static_cast<uint32_t>(near_page_id) / BITMAP_SIZE < meta_page->GetExtentNums()) {
+    // 先在near_page_id所在的run中向后找，run已满时再看紧随其后的run是否全空
+    uint32_t extent_id = near_page_id / BITMAP_SIZE;
+    uint32_t page_offset = near_page_id % BITMAP_SIZE;
+    uint32_t run_end = (page_offset / ALLOCATION_RUN_PAGES + 1) * ALLOCATION_RUN_PAGES;
+    BitmapPage<PAGE_SIZE> *bitmap = GetBitmap(extent_id);
+    uint32_t free_page = bitmap->FindFreePage(page_offset + 1);
+    // 后一个run只要有页被用过，就可能属于别的对象，不能占用它的页
+    bool in_run = free_page < run_end ||
+                  (free_page == run_end && bitmap->FindFreeRun(run_end, ALLOCATION_RUN_PAGES) == run_end);
+    if (in_run && free_page < BITMAP_SIZE && bitmap->AllocatePageAt(free_page)) {
+      return OnPageAllocated(extent_id, free_page);
+    }
+  }
+  // 开始一个新的run：找一段全空的run，没有则开一个新的分区
+  for (uint32_t i = 0; i < meta_page->GetExtentNums(); i++) {
+    if (meta_page->GetExtentUsedPage(i) > BITMAP_SIZE - ALLOCATION_RUN_PAGES) {
+      continue;
+    }
+    uint32_t run = GetBitmap(i)->FindFreeRun(0, ALLOCATION_RUN_PAGES);
+    if (run < BITMAP_SIZE && GetBitmap(i)->AllocatePageAt(run)) {
+      return OnPageAllocated(i, run);
+    }
+  }
+  if (meta_page->GetExtentNums() < bitmaps_.size()) {
+    uint32_t i = AddExtent();
+    if (GetBitmap(i)->AllocatePageAt(0)) {
+      return OnPageAllocated(i, 0);
+    }
+  }
+  return AllocatePage();  // 没有空闲的run，退化为普通分配
+}
+
+page_id_t DiskManager::AllocatePageBelow(page_id_t page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  page_id = GetLocalPageId(page_id);
+  if (read_only_ || page_id == INVALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(this->GetMetaData());
+  for (uint32_t i = next_free_extent_; i < meta_page->GetExtentNums() && i <= page_id / BITMAP_SIZE; i++) {
+    if (meta_page->GetExtentUsedPage(i) == BITMAP_SIZE) {
+      continue;
+    }
+    uint32_t free_page = GetBitmap(i)->FindFreePage(0);
+    if (static_cast<size_t>(i) * BITMAP_SIZE + free_page >= static_cast<size_t>(page_id)) {
+      break;
+    }
+    if (GetBitmap(i)->AllocatePageAt(free_page)) {
+      return OnPageAllocated(i, free_page);
+    }
   }
   return INVALID_PAGE_ID;
 }
 
+uint32_t DiskManager::AddExtent() {
+  DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(this->GetMetaData());
+  uint32_t i = meta_page->num_extents_++;  // 新分区的编号
+  bitmaps_[i] = std::make_unique<BitmapPage<PAGE_SIZE>>();
+  memset(static_cast<void *>(bitmaps_[i].get()), 0, PAGE_SIZE);
+  bitmap_dirty_[i] = meta_dirty_ = true;
+  return i;
+}
+
+page_id_t DiskManager::OnPageAllocated(uint32_t extent_id, uint32_t page_offset) {
+  DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(this->GetMetaData());
+  meta_page->extent_used_page_[extent_id]++;
+  meta_page->num_allocated_pages_++;
+  bitmap_dirty_[extent_id] = meta_dirty_ = true;
+  page_id_t logical_page_id = extent_id * BITMAP_SIZE + page_offset;
+  GrowFile(logical_page_id);
+  return MakePageId(segment_id_, logical_page_id);
+}
+
+void DiskManager::GrowFile(page_id_t logical_page_id) {
+  size_t start = file_size_;
+  if (compressed_ || static_cast<size_t>(MapPageId(logical_page_id)) * PAGE_SIZE < start) {
+    return;
+  }
+  // 一次预留到该页所在run的末尾，让文件系统为这些页分配连续的空间
+  page_id_t run_end = (logical_page_id / ALLOCATION_RUN_PAGES + 1) * ALLOCATION_RUN_PAGES;
+  size_t end = static_cast<size_t>(MapPageId(run_end - 1) + 1) * PAGE_SIZE;
+  if (fallocate(db_fd_, 0, start, end - start) == 0) {
+    UpdateFileSize(end);
+  } else if (errno != EOPNOTSUPP) {
+    LOG(WARNING) << "Failed to preallocate " << file_name_ << ": " << strerror(errno);
+  }
+}
+
 /**
  * TODO: Student Implement
  */
 void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
-  if (logical_page_id >= MAX_VALID_PAGE_ID)  // 逻辑页号不合法
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  logical_page_id = GetLocalPageId(logical_page_id);
+  if (read_only_ || logical_page_id == INVALID_PAGE_ID)  // 文件只读或逻辑页号不合法
     return;
   DiskFileMetaPage *meta_page = reinterpret_cast<DiskFileMetaPage *>(this->GetMetaData());
   uint32_t extend_index = logical_page_id / BITMAP_SIZE;  // 获取对应分区
   uint32_t page_offset = logical_page_id % BITMAP_SIZE;   // 获取该逻辑页在当前分区的页偏移
-  char buf[PAGE_SIZE];
-  ReadPhysicalPage(extend_index * (BITMAP_SIZE + 1) + 1, buf);  // 读取对应分区的bitmap
-  BitmapPage<PAGE_SIZE> *bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(buf);
-  if (bitmap->DeAllocatePage(page_offset)) {
+  if (extend_index >= meta_page->GetExtentNums()) {
+    return;
+  }
+  if (GetBitmap(extend_index)->DeAllocatePage(page_offset)) {
     meta_page->num_allocated_pages_--;
     meta_page->extent_used_page_[extend_index]--;
-    WritePhysicalPage(META_PAGE_ID, this->GetMetaData());          // 更新disk头
-    WritePhysicalPage(extend_index * (BITMAP_SIZE + 1) + 1, buf);  // 写回物理页面
+    bitmap_dirty_[extend_index] = meta_dirty_ = true;
+    next_free_extent_ = std::min(next_free_extent_, extend_index);
+    if (compressed_) {
+      ReleaseCompressedPage(MapPageId(logical_page_id));
+      return;  // 压缩文件中空出的扇区由之后写入的页重用
+    }
+    // run全空时记下来，等位图落盘后再打洞
+    uint32_t run_offset = page_offset / ALLOCATION_RUN_PAGES * ALLOCATION_RUN_PAGES;
+    if (GetBitmap(extend_index)->FindFreeRun(run_offset, ALLOCATION_RUN_PAGES) == run_offset) {
+      free_runs_.push_back(extend_index * BITMAP_SIZE + run_offset);
+    }
   }
 }
 
@@ -112,14 +583,24 @@ void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
  * TODO: Student Implement
  */
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
-  if (logical_page_id >= MAX_VALID_PAGE_ID)  // 逻辑页号不合法
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  logical_page_id = GetLocalPageId(logical_page_id);
+  if (logical_page_id == INVALID_PAGE_ID)  // 逻辑页号不合法
     return false;
   uint32_t extend_index = logical_page_id / BITMAP_SIZE;  // 获取对应分区
   uint32_t page_offset = logical_page_id % BITMAP_SIZE;   // 获取该逻辑页在当前分区的页偏移
-  char buf[PAGE_SIZE];
-  ReadPhysicalPage(extend_index * (BITMAP_SIZE + 1) + 1, buf);  // 把对应分区的bitmap读取出来
-  BitmapPage<PAGE_SIZE> *bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(buf);
-  return bitmap->IsPageFree(page_offset);
+  if (extend_index >= reinterpret_cast<DiskFileMetaPage *>(GetMetaData())->GetExtentNums()) {
+    return true;
+  }
+  return GetBitmap(extend_index)->IsPageFree(page_offset);
+}
+
+BitmapPage<PAGE_SIZE> *DiskManager::GetBitmap(uint32_t extent_id) {
+  if (bitmaps_[extent_id] == nullptr) {
+    bitmaps_[extent_id] = std::make_unique<BitmapPage<PAGE_SIZE>>();
+    ReadPhysicalPage(GetBitmapPageId(extent_id), reinterpret_cast<char *>(bitmaps_[extent_id].get()));
+  }
+  return bitmaps_[extent_id].get();
 }
 
 /**
@@ -128,49 +609,303 @@ bool DiskManager::IsPageFree(page_id_t logical_page_id) {
 page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
   // logical_page_id : 0~N-1, N~2N-1...
   // physical_page_id : 0 [1 2~N+1] [N+2 N+3~...]...
-  // 跳过磁盘元数据0和第一个位图页
+  // 跳过磁盘元数据0和第一个位图页；高位的段号不参与映射
+  logical_page_id &= (1 << SEGMENT_PAGE_BITS) - 1;
   return logical_page_id / BITMAP_SIZE + 2 + logical_page_id;
 }
 
-int DiskManager::GetFileSize(const std::string &file_name) {
-  struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? stat_buf.st_size : -1;
+page_id_t DiskManager::GetLocalPageId(page_id_t page_id) const {
+  page_id_t local_page_id = page_id & ((1 << SEGMENT_PAGE_BITS) - 1);
+  if (page_id < 0 || SegmentOf(page_id) != segment_id_ || local_page_id >= MAX_VALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  return local_page_id;
 }
 
 void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
-  int offset = physical_page_id * PAGE_SIZE;
+  if (compressed_ && physical_page_id != META_PAGE_ID) {
+    ReadCompressedPage(physical_page_id, page_data);
+    return;
+  }
+  if (direct_io_ && !IsAligned(page_data)) {
+    char *buffer = GetBounceBuffer();
+    ReadPhysicalPage(physical_page_id, buffer);
+    memcpy(page_data, buffer, PAGE_SIZE);
+    return;
+  }
+  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
+  size_t read_count = 0;
   // check if read beyond file length
-  if (offset >= GetFileSize(file_name_)) {
+  if (offset < file_size_) {
+    read_count = ReadAt(offset, page_data, PAGE_SIZE);
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
 #ifdef ENABLE_BPM_DEBUG
     LOG(INFO) << "Read less than a page" << std::endl;
 #endif
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+}
+
+void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
+  if (compressed_ && physical_page_id != META_PAGE_ID) {
+    WriteCompressedPage(physical_page_id, page_data);
+    return;
+  }
+  if (direct_io_ && !IsAligned(page_data)) {
+    char *buffer = GetBounceBuffer();
+    memcpy(buffer, page_data, PAGE_SIZE);
+    WritePhysicalPage(physical_page_id, buffer);
+    return;
+  }
+  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
+  if (WriteAt(offset, page_data, PAGE_SIZE)) {
+    UpdateFileSize(offset + PAGE_SIZE);
+  }
+}
+
+size_t DiskManager::ReadAt(size_t offset, char *data, size_t size) {
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t ret = pread(db_fd_, data + read_count, size - read_count, offset + read_count);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      if (ret < 0) {
+        LOG(ERROR) << "I/O error while reading";
+      }
+      break;
+    }
+    read_count += ret;
+  }
+  return read_count;
+}
+
+bool DiskManager::WriteAt(size_t offset, const char *data, size_t size) {
+  size_t write_count = 0;
+  while (write_count < size) {
+    ssize_t ret = pwrite(db_fd_, data + write_count, size - write_count, offset + write_count);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (ret <= 0) {
+      LOG(ERROR) << "I/O error while writing";
+      return false;
+    }
+    write_count += ret;
+  }
+  return true;
+}
+
+void DiskManager::ReadCompressedPage(page_id_t physical_page_id, char *page_data) {
+  PageLocation location{0, 0, 0};
+  {
+    std::scoped_lock<std::mutex> lock(location_latch_);
+    if (static_cast<size_t>(physical_page_id) < locations_.size()) {
+      location = locations_[physical_page_id];
+    }
+  }
+  size_t offset = static_cast<size_t>(location.sector_) * COMPRESSION_SECTOR_SIZE;
+  if (location.size_ == 0) {  // 从未写过的页全为0
     memset(page_data, 0, PAGE_SIZE);
+  } else if (location.size_ == PAGE_SIZE) {  // 无法压缩的页按原样存放
+    size_t read_count = ReadAt(offset, page_data, PAGE_SIZE);
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
   } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-#ifdef ENABLE_BPM_DEBUG
-      LOG(INFO) << "Read less than a page" << std::endl;
-#endif
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    char *buffer = GetCompressionBuffer();
+    // 不能把损坏的页当作全0的页交给上层，那样会悄悄丢失数据
+    if (ReadAt(offset, buffer, location.size_) != location.size_ ||
+        !PageCompressor::Decompress(buffer, location.size_, page_data)) {
+      LOG(FATAL) << "Corrupted compressed page " << physical_page_id << " in " << file_name_;
     }
   }
 }
 
-void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG(ERROR) << "I/O error while writing";
+void DiskManager::WriteCompressedPage(page_id_t physical_page_id, const char *page_data) {
+  // 压缩后至少要省下一个扇区才值得，否则按原样存放
+  char *buffer = GetCompressionBuffer();
+  size_t size = PageCompressor::Compress(page_data, buffer, PAGE_SIZE - COMPRESSION_SECTOR_SIZE);
+  const char *data = buffer;
+  if (size == 0) {
+    size = PAGE_SIZE;
+    data = page_data;
+  }
+  uint32_t sector;
+  {
+    std::scoped_lock<std::mutex> lock(location_latch_);
+    ReservePageLocation(physical_page_id);
+    PageLocation &location = locations_[physical_page_id];
+    if (location.size_ != size) {
+      // 大小变了就写到新的扇区：落盘的页位置表在下次Sync之前仍记录着旧的位置和大小，崩溃后要能读出旧的页。
+      // 原来的扇区在页位置表落盘后才能重用
+      if (location.size_ != 0) {
+        released_sectors_.emplace_back(location.sector_, SectorsOf(location.size_));
+      }
+      location.sector_ = AllocateSectors(SectorsOf(size));
+      location.size_ = static_cast<uint16_t>(size);
+      map_block_dirty_[physical_page_id / LOCATIONS_PER_MAP_BLOCK] = true;
+    }
+    sector = location.sector_;
+  }
+  size_t offset = static_cast<size_t>(sector) * COMPRESSION_SECTOR_SIZE;
+  if (WriteAt(offset, data, size)) {
+    UpdateFileSize(offset + size);
+  }
+}
+
+void DiskManager::ReleaseCompressedPage(page_id_t physical_page_id) {
+  std::scoped_lock<std::mutex> lock(location_latch_);
+  if (static_cast<size_t>(physical_page_id) >= locations_.size() || locations_[physical_page_id].size_ == 0) {
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  PageLocation &location = locations_[physical_page_id];
+  released_sectors_.emplace_back(location.sector_, SectorsOf(location.size_));
+  location = {0, 0, 0};
+  map_block_dirty_[physical_page_id / LOCATIONS_PER_MAP_BLOCK] = true;
+}
+
+void DiskManager::LoadPageLocations() {
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  std::scoped_lock<std::mutex> lock(location_latch_);
+  uint32_t map_blocks = meta_page->map_blocks_;
+  map_block_sectors_.assign(map_blocks, 0);
+  map_block_dirty_.assign(map_blocks, false);
+  locations_.assign(map_blocks * LOCATIONS_PER_MAP_BLOCK, {0, 0, 0});
+  // 已用的扇区：meta page、页位置表的目录和各块，以及各页
+  std::vector<std::pair<uint32_t, uint32_t>> used{{0, SECTORS_PER_PAGE}};
+  if (map_blocks > 0) {
+    size_t directory_size = map_blocks * sizeof(uint32_t);
+    size_t offset = static_cast<size_t>(meta_page->map_directory_sector_) * COMPRESSION_SECTOR_SIZE;
+    if (ReadAt(offset, reinterpret_cast<char *>(map_block_sectors_.data()), directory_size) != directory_size) {
+      LOG(ERROR) << "Corrupted page location map in " << file_name_;
+    }
+    used.emplace_back(meta_page->map_directory_sector_, SectorsOf(directory_size));
+  }
+  for (uint32_t i = 0; i < map_blocks; i++) {
+    if (map_block_sectors_[i] != 0) {
+      size_t offset = static_cast<size_t>(map_block_sectors_[i]) * COMPRESSION_SECTOR_SIZE;
+      ReadAt(offset, reinterpret_cast<char *>(&locations_[i * LOCATIONS_PER_MAP_BLOCK]), PAGE_SIZE);
+      used.emplace_back(map_block_sectors_[i], SECTORS_PER_PAGE);
+    }
+  }
+  for (const auto &location : locations_) {
+    if (location.size_ != 0) {
+      used.emplace_back(location.sector_, SectorsOf(location.size_));
+    }
+  }
+  // 已用的扇区之间的空隙都是空闲的，包括上次异常退出前未落盘的页位置表释放的扇区
+  std::sort(used.begin(), used.end());
+  uint32_t end = 0;
+  for (const auto &range : used) {
+    if (range.first > end) {
+      FreeSectors(end, range.first - end);
+    }
+    end = std::max(end, range.first + range.second);
+  }
+  end_sector_ = end;
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> DiskManager::WritePageLocations() {
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  std::scoped_lock<std::mutex> lock(location_latch_);
+  // 页位置表的块写到新的位置，原来的块在新的meta page落盘前仍然有效
+  bool moved = false;
+  for (size_t i = 0; i < map_block_sectors_.size(); i++) {
+    if (!map_block_dirty_[i]) {
+      continue;
+    }
+    uint32_t sector = AllocateSectors(SECTORS_PER_PAGE);
+    size_t offset = static_cast<size_t>(sector) * COMPRESSION_SECTOR_SIZE;
+    if (!WriteAt(offset, reinterpret_cast<const char *>(&locations_[i * LOCATIONS_PER_MAP_BLOCK]), PAGE_SIZE)) {
+      FreeSectors(sector, SECTORS_PER_PAGE);
+      continue;
+    }
+    UpdateFileSize(offset + PAGE_SIZE);
+    if (map_block_sectors_[i] != 0) {
+      released_sectors_.emplace_back(map_block_sectors_[i], SECTORS_PER_PAGE);
+    }
+    map_block_sectors_[i] = sector;
+    map_block_dirty_[i] = false;
+    moved = true;
+  }
+  if (moved) {
+    size_t directory_size = map_block_sectors_.size() * sizeof(uint32_t);
+    uint32_t sector = AllocateSectors(SectorsOf(directory_size));
+    size_t offset = static_cast<size_t>(sector) * COMPRESSION_SECTOR_SIZE;
+    if (WriteAt(offset, reinterpret_cast<const char *>(map_block_sectors_.data()), directory_size)) {
+      UpdateFileSize(offset + directory_size);
+      if (meta_page->map_blocks_ > 0) {
+        released_sectors_.emplace_back(meta_page->map_directory_sector_,
+                                       SectorsOf(meta_page->map_blocks_ * sizeof(uint32_t)));
+      }
+      meta_page->map_directory_sector_ = sector;
+      meta_page->map_blocks_ = map_block_sectors_.size();
+      meta_dirty_ = true;
+    } else {
+      FreeSectors(sector, SectorsOf(directory_size));
+    }
+  }
+  return std::exchange(released_sectors_, {});
+}
+
+void DiskManager::ReservePageLocation(page_id_t physical_page_id) {
+  if (static_cast<size_t>(physical_page_id) < locations_.size()) {
+    return;
+  }
+  size_t map_blocks = physical_page_id / LOCATIONS_PER_MAP_BLOCK + 1;
+  locations_.resize(map_blocks * LOCATIONS_PER_MAP_BLOCK, {0, 0, 0});
+  map_block_sectors_.resize(map_blocks, 0);
+  map_block_dirty_.resize(map_blocks, false);
+}
+
+uint32_t DiskManager::AllocateSectors(uint32_t count) {
+  auto iter = free_sectors_by_size_.lower_bound({count, 0});
+  if (iter == free_sectors_by_size_.end()) {  // 没有足够大的空闲区间，追加到文件末尾
+    uint32_t sector = end_sector_;
+    end_sector_ += count;
+    return sector;
+  }
+  auto [size, sector] = *iter;
+  free_sectors_by_size_.erase(iter);
+  free_sectors_.erase(sector);
+  if (size > count) {
+    free_sectors_[sector + count] = size - count;
+    free_sectors_by_size_.emplace(size - count, sector + count);
+  }
+  return sector;
+}
+
+void DiskManager::FreeSectors(uint32_t sector, uint32_t count) {
+  // 与前后相邻的空闲区间合并
+  auto next = free_sectors_.lower_bound(sector);
+  if (next != free_sectors_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == sector) {
+      sector = prev->first;
+      count += prev->second;
+      free_sectors_by_size_.erase({prev->second, prev->first});
+      free_sectors_.erase(prev);
+    }
+  }
+  if (next != free_sectors_.end() && sector + count == next->first) {
+    count += next->second;
+    free_sectors_by_size_.erase({next->second, next->first});
+    free_sectors_.erase(next);
+  }
+  if (sector + count == end_sector_) {  // 文件末尾的空闲扇区直接还给追加的位置
+    end_sector_ = sector;
+    return;
+  }
+  free_sectors_[sector] = count;
+  free_sectors_by_size_.emplace(count, sector);
+}
+
+void DiskManager::UpdateFileSize(size_t end_offset) {
+  // 并发写入不同页时只增不减
+  size_t file_size = file_size_;
+  while (file_size < end_offset && !file_size_.compare_exchange_weak(file_size, end_offset)) {
+  }
 }
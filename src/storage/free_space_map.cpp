@@ -0,0 +1,233 @@
+#include "storage/free_space_map.h"
+
+#include "common/macros.h"
+
+FreeSpaceMap *FreeSpaceMap::Create(BufferPoolManager *buffer_pool_manager, page_id_t near_page_id) {
+  page_id_t page_id;
+  auto raw_page = buffer_pool_manager->NewPageNear(page_id, near_page_id);
+  if (raw_page == nullptr) {
+    return nullptr;
+  }
+  reinterpret_cast<FreeSpaceMapPage *>(raw_page->GetData())->Init();
+  buffer_pool_manager->UnpinPage(page_id, true);
+  return new FreeSpaceMap(buffer_pool_manager, page_id, true);
+}
+
+bool FreeSpaceMap::Update(page_id_t page_id, uint32_t free_space) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    return false;
+  }
+  uint8_t bucket = ToBucket(free_space);
+  auto iter = entries_.find(page_id);
+  if (iter == entries_.end()) {
+    // 新的页追加在最后
+    uint32_t index = page_ids_.size();
+    page_ids_.push_back(page_id);
+    buckets_.push_back(bucket);
+    entries_[page_id] = index;
+    bucket_entries_[bucket].insert(index);
+    if (!WriteEntry(index)) {  // 没有写进表页的条目也不能留在内存中
+      page_ids_.pop_back();
+      buckets_.pop_back();
+      entries_.erase(page_id);
+      bucket_entries_[bucket].erase(index);
+      return false;
+    }
+    return true;
+  }
+  uint32_t index = iter->second;
+  uint8_t old_bucket = buckets_[index];
+  if (old_bucket == bucket) {  // 桶没有变化则不必写回
+    return true;
+  }
+  bucket_entries_[old_bucket].erase(index);
+  buckets_[index] = bucket;
+  bucket_entries_[bucket].insert(index);
+  if (!WriteEntry(index)) {
+    bucket_entries_[bucket].erase(index);
+    buckets_[index] = old_bucket;
+    bucket_entries_[old_bucket].insert(index);
+    return false;
+  }
+  return true;
+}
+
+page_id_t FreeSpaceMap::FindPage(uint32_t size) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    return INVALID_PAGE_ID;
+  }
+  // 桶里的页至少有 bucket * BUCKET_SIZE 的空间，从刚好放得下的桶开始找
+  for (uint32_t bucket = (size + BUCKET_SIZE - 1) / BUCKET_SIZE; bucket < NUM_BUCKETS; bucket++) {
+    if (!bucket_entries_[bucket].empty()) {
+      return page_ids_[*bucket_entries_[bucket].begin()];
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+void FreeSpaceMap::ReplacePage(page_id_t old_page_id, page_id_t new_page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    ASSERT(false, "ERROR: cannot read free space map, the buffer pool is full");
+    return;
+  }
+  auto iter = entries_.find(old_page_id);
+  if (iter == entries_.end()) {
+    return;
+  }
+  uint32_t index = iter->second;
+  entries_.erase(iter);
+  entries_[new_page_id] = index;
+  page_ids_[index] = new_page_id;
+  [[maybe_unused]] bool written = WriteEntry(index);
+  ASSERT(written, "ERROR: cannot write free space map, the buffer pool is full");
+}
+
+size_t FreeSpaceMap::Compact() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    ASSERT(false, "ERROR: cannot read free space map, the buffer pool is full");
+    return 0;
+  }
+  size_t moved = 0;
+  for (size_t i = 0; i < map_page_ids_.size(); i++) {
+    page_id_t new_page_id;
+    if (buffer_pool_manager_->RelocatePage(map_page_ids_[i], new_page_id) == nullptr) {
+      continue;
+    }
+    // 页中指向下一页的链接不变，只需修正前一页的链接
+    buffer_pool_manager_->UnpinPage(new_page_id, true);
+    map_page_ids_[i] = new_page_id;
+    if (i == 0) {
+      first_page_id_ = new_page_id;
+    } else {
+      auto prev_raw_page = buffer_pool_manager_->FetchPage(map_page_ids_[i - 1]);
+      ASSERT(prev_raw_page != nullptr, "ERROR: cannot relink free space map, the buffer pool is full");
+      reinterpret_cast<FreeSpaceMapPage *>(prev_raw_page->GetData())->SetNextPageId(new_page_id);
+      buffer_pool_manager_->UnpinPage(map_page_ids_[i - 1], true);
+    }
+    moved++;
+  }
+  return moved;
+}
+
+page_id_t FreeSpaceMap::GetLastPageId() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    return INVALID_PAGE_ID;
+  }
+  return page_ids_.empty() ? INVALID_PAGE_ID : page_ids_.back();
+}
+
+size_t FreeSpaceMap::GetPageCount() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    ASSERT(false, "ERROR: cannot read free space map, the buffer pool is full");
+    return 0;
+  }
+  return page_ids_.size();
+}
+
+std::vector<page_id_t> FreeSpaceMap::GetPageIds(size_t begin, size_t end) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    ASSERT(false, "ERROR: cannot read free space map, the buffer pool is full");
+    return {};
+  }
+  end = std::min(end, page_ids_.size());
+  if (begin >= end) {
+    return {};
+  }
+  return std::vector<page_id_t>(page_ids_.begin() + begin, page_ids_.begin() + end);
+}
+
+void FreeSpaceMap::Destroy() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!Load()) {
+    ASSERT(false, "ERROR: cannot read free space map, the buffer pool is full");
+    return;
+  }
+  for (auto page_id : map_page_ids_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  Clear();
+  first_page_id_ = INVALID_PAGE_ID;
+}
+
+void FreeSpaceMap::Clear() {
+  map_page_ids_.clear();
+  page_ids_.clear();
+  buckets_.clear();
+  entries_.clear();
+  for (auto &entries : bucket_entries_) {
+    entries.clear();
+  }
+}
+
+bool FreeSpaceMap::Load() {
+  if (loaded_) {
+    return true;
+  }
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto raw_page = buffer_pool_manager_->FetchPage(page_id);
+    if (raw_page == nullptr) {  // 缓冲池满了，丢弃读了一半的内容，下次重新读取
+      Clear();
+      return false;
+    }
+    auto page = reinterpret_cast<FreeSpaceMapPage *>(raw_page->GetData());
+    map_page_ids_.push_back(page_id);
+    for (uint32_t i = 0; i < page->GetEntryCount(); i++) {
+      uint32_t index = page_ids_.size();
+      page_ids_.push_back(page->GetPageId(i));
+      buckets_.push_back(page->GetBucket(i));
+      entries_[page->GetPageId(i)] = index;
+      bucket_entries_[page->GetBucket(i)].insert(index);
+    }
+    page_id_t next_page_id = page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  loaded_ = true;
+  return true;
+}
+
+bool FreeSpaceMap::WriteEntry(uint32_t index) {
+  uint32_t map_index = index / FreeSpaceMapPage::MAX_ENTRIES;
+  uint32_t slot = index % FreeSpaceMapPage::MAX_ENTRIES;
+  if (map_index == map_page_ids_.size()) {
+    // 最后一页满了，在后面接上新的一页
+    page_id_t prev_page_id = map_page_ids_.back();
+    page_id_t page_id;
+    auto raw_page = buffer_pool_manager_->NewPageNear(page_id, prev_page_id);
+    if (raw_page == nullptr) {
+      return false;
+    }
+    reinterpret_cast<FreeSpaceMapPage *>(raw_page->GetData())->Init();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    auto prev_raw_page = buffer_pool_manager_->FetchPage(prev_page_id);
+    if (prev_raw_page == nullptr) {  // 新页还没有接到链表上，直接释放
+      buffer_pool_manager_->DeletePage(page_id);
+      return false;
+    }
+    reinterpret_cast<FreeSpaceMapPage *>(prev_raw_page->GetData())->SetNextPageId(page_id);
+    buffer_pool_manager_->UnpinPage(prev_page_id, true);
+    map_page_ids_.push_back(page_id);
+  }
+  page_id_t page_id = map_page_ids_[map_index];
+  auto raw_page = buffer_pool_manager_->FetchPage(page_id);
+  if (raw_page == nullptr) {
+    return false;
+  }
+  auto page = reinterpret_cast<FreeSpaceMapPage *>(raw_page->GetData());
+  if (slot == page->GetEntryCount()) {
+    page->Append(page_ids_[index], buckets_[index]);
+  } else {
+    page->SetPageId(slot, page_ids_[index]);
+    page->SetBucket(slot, buckets_[index]);
+  }
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  return true;
+}
@@ -0,0 +1,142 @@
+#include "storage/io_uring.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+static int IOUringSetup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int IOUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+IOUring::IOUring(unsigned entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = IOUringSetup(entries, &params);
+  if (ring_fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+  }
+  capacity_ = std::min(params.sq_entries, params.cq_entries);
+  sq_mapping_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_mapping_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mapping) {
+    sq_mapping_size_ = std::max(sq_mapping_size_, cq_mapping_size_);
+  }
+  sq_mapping_ = mmap(nullptr, sq_mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                     IORING_OFF_SQ_RING);
+  if (single_mapping) {
+    cq_mapping_ = sq_mapping_;
+  } else if (sq_mapping_ != MAP_FAILED) {
+    cq_mapping_ = mmap(nullptr, cq_mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                       IORING_OFF_CQ_RING);
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  if (sq_mapping_ != MAP_FAILED && cq_mapping_ != MAP_FAILED) {
+    sqes_ = static_cast<io_uring_sqe *>(
+        mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES));
+  }
+  if (sq_mapping_ == MAP_FAILED || cq_mapping_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+    int error = errno;
+    if (sq_mapping_ != MAP_FAILED) {
+      munmap(sq_mapping_, sq_mapping_size_);
+    }
+    if (!single_mapping && cq_mapping_ != nullptr && cq_mapping_ != MAP_FAILED) {
+      munmap(cq_mapping_, cq_mapping_size_);
+    }
+    close(ring_fd_);
+    throw std::system_error(error, std::generic_category(), "io_uring mmap");
+  }
+  char *sq = static_cast<char *>(sq_mapping_);
+  sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  char *cq = static_cast<char *>(cq_mapping_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+IOUring::~IOUring() {
+  // 缓冲区可能在请求完成前就被释放，先等待所有已提交的请求完成
+  while (outstanding_ > 0) {
+    uint64_t user_data;
+    int32_t result;
+    if (!PopCompletion(&user_data, &result) && !Submit(1)) {
+      break;
+    }
+  }
+  munmap(sqes_, sqes_size_);
+  if (cq_mapping_ != sq_mapping_) {
+    munmap(cq_mapping_, cq_mapping_size_);
+  }
+  munmap(sq_mapping_, sq_mapping_size_);
+  close(ring_fd_);
+}
+
+bool IOUring::Prepare(uint8_t opcode, int fd, char *buf, size_t len, uint64_t offset, uint64_t user_data) {
+  if (outstanding_ >= capacity_) {
+    return false;
+  }
+  // 只有本线程写入tail，kernel在消费后更新head
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & sq_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->off = offset;
+  sqe->addr = reinterpret_cast<uint64_t>(buf);
+  sqe->len = static_cast<uint32_t>(len);
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  outstanding_++;
+  to_submit_++;
+  return true;
+}
+
+bool IOUring::Submit(unsigned wait_nr) {
+  while (true) {
+    unsigned flags = (wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0);
+    int ret = IOUringEnter(ring_fd_, to_submit_, wait_nr, flags);
+    if (ret >= 0) {
+      to_submit_ -= std::min<unsigned>(ret, to_submit_);
+      return true;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    // 内核暂时无法接收更多请求，等待已提交的请求完成后重试
+    if ((errno == EAGAIN || errno == EBUSY) && outstanding_ > to_submit_) {
+      if (IOUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+        return false;
+      }
+      continue;
+    }
+    return false;
+  }
+}
+
+bool IOUring::PopCompletion(uint64_t *user_data, int32_t *result) {
+  unsigned head = *cq_head_;
+  if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  io_uring_cqe *cqe = &cqes_[head & cq_mask_];
+  *user_data = cqe->user_data;
+  *result = cqe->res;
+  __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+  outstanding_--;
+  return true;
+}
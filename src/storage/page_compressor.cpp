@@ -0,0 +1,136 @@
+#include "storage/page_compressor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+static uint32_t Load32(const uint8_t *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+/** Write the extra bytes of a length which does not fit in its nibble */
+static uint8_t *PutLength(uint8_t *op, size_t length) {
+  for (; length >= 255; length -= 255) {
+    *op++ = 255;
+  }
+  *op++ = static_cast<uint8_t>(length);
+  return op;
+}
+
+/**
+ * Read the extra bytes of a length whose nibble is 15.
+ * @return false if the input ends before the length
+ */
+static bool GetLength(const uint8_t *&ip, const uint8_t *iend, size_t &length) {
+  uint8_t byte;
+  do {
+    if (ip >= iend) {
+      return false;
+    }
+    byte = *ip++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+size_t PageCompressor::Compress(const char *src, char *dst, size_t capacity) {
+  const auto *base = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *end = base + PAGE_SIZE;
+  const uint8_t *match_limit = end - MIN_MATCH;  // 匹配至少需要MIN_MATCH个字节
+  const uint8_t *ip = base;
+  const uint8_t *anchor = base;  // 尚未输出的字面量的起点
+  auto *op = reinterpret_cast<uint8_t *>(dst);
+  uint8_t *oend = op + capacity;
+  uint16_t table[1 << HASH_BITS] = {};  // 每个4字节串上次出现的位置
+  // 输出一个序列：anchor到ip的字面量，以及长度为match_length的匹配(为0时是最后一个序列)
+  auto emit = [&](size_t match_length, size_t offset) {
+    size_t literals = ip - anchor;
+    if (literals + literals / 255 + match_length / 255 + 5 > static_cast<size_t>(oend - op)) {
+      return false;
+    }
+    size_t match_code = (match_length == 0 ? 0 : match_length - MIN_MATCH);
+    *op++ = static_cast<uint8_t>((std::min<size_t>(literals, 15) << 4) | std::min<size_t>(match_code, 15));
+    if (literals >= 15) {
+      op = PutLength(op, literals - 15);
+    }
+    memcpy(op, anchor, literals);
+    op += literals;
+    if (match_length != 0) {
+      *op++ = static_cast<uint8_t>(offset);
+      *op++ = static_cast<uint8_t>(offset >> 8);
+      if (match_code >= 15) {
+        op = PutLength(op, match_code - 15);
+      }
+    }
+    return true;
+  };
+  while (ip <= match_limit) {
+    uint32_t sequence = Load32(ip);
+    uint32_t hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+    const uint8_t *ref = base + table[hash];
+    table[hash] = static_cast<uint16_t>(ip - base);
+    if (ref >= ip || static_cast<size_t>(ip - ref) > MAX_OFFSET || Load32(ref) != sequence) {
+      // 越久没有找到匹配，跳得越远，不可压缩的数据很快就能扫过
+      ip += 1 + ((ip - anchor) >> 6);
+      continue;
+    }
+    const uint8_t *match_end = ip + MIN_MATCH;
+    for (const uint8_t *rp = ref + MIN_MATCH; match_end < end && *match_end == *rp; match_end++, rp++) {
+    }
+    if (!emit(match_end - ip, ip - ref)) {
+      return 0;
+    }
+    ip = anchor = match_end;
+  }
+  ip = end;
+  if (!emit(0, 0)) {
+    return 0;
+  }
+  return op - reinterpret_cast<uint8_t *>(dst);
+}
+
+bool PageCompressor::Decompress(const char *src, size_t size, char *dst) {
+  const auto *ip = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *iend = ip + size;
+  auto *base = reinterpret_cast<uint8_t *>(dst);
+  uint8_t *op = base;
+  uint8_t *oend = base + PAGE_SIZE;
+  while (ip < iend) {
+    uint8_t token = *ip++;
+    size_t literals = token >> 4;
+    if (literals == 15 && !GetLength(ip, iend, literals)) {
+      return false;
+    }
+    if (literals > static_cast<size_t>(iend - ip) || literals > static_cast<size_t>(oend - op)) {
+      return false;
+    }
+    memcpy(op, ip, literals);
+    ip += literals;
+    op += literals;
+    if (ip == iend) {
+      break;  // 最后一个序列没有匹配
+    }
+    if (iend - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+    ip += 2;
+    size_t match_length = token & 15;
+    if (match_length == 15 && !GetLength(ip, iend, match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > static_cast<size_t>(op - base) || match_length > static_cast<size_t>(oend - op)) {
+      return false;
+    }
+    // 匹配可以与正在输出的数据重叠，逐字节复制
+    const uint8_t *match = op - offset;
+    for (size_t i = 0; i < match_length; i++) {
+      op[i] = match[i];
+    }
+    op += match_length;
+  }
+  return op == oend;
+}
@@ -1,4 +1,5 @@
 #include "storage/table_heap.h"
+#include <algorithm>
 #include <cstddef>
 #include <tuple>
 #include "common/config.h"
@@ -11,81 +12,111 @@
  * TODO: Student Implement
  */
 bool TableHeap::InsertTuple(Row &row, Txn *txn) {
-  if (page_num > 8) {  // 如果页数比8多，从最后一页开始插入
-    auto last_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id_));  // 查看最后一页
-    if (last_page == nullptr) {  // 如果最后一页不存在，将引用数-1并返回false
-      buffer_pool_manager_->UnpinPage(last_page_id_, false);
+  if (buffer_pool_manager_->IsReadOnly()) {  // 只读的数据库不能修改
+    return false;
+  }
+  uint32_t size = row.GetSerializedSize(schema_);
+  if (size > TablePage::SIZE_MAX_ROW) {
+    return false;
+  }
+  // 由空闲空间表找一个放得下的页
+  page_id_t page_id;
+  while ((page_id = free_space_map_->FindPage(size)) != INVALID_PAGE_ID) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
       return false;
     }
-    if (last_page->InsertTuple(row, schema_, txn, lock_manager_,
-                               log_manager_)) {  // 否则尝试insert，如果成功则引用数-1，并设置为dirty
-      buffer_pool_manager_->UnpinPage(last_page_id_, true);
-    } else {  // 如果插入失败，则新建page
-      page_id_t next_page_id;
-      auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(next_page_id));
-      if (new_page != nullptr && next_page_id != INVALID_PAGE_ID) {  // 新建成功
-        new_page->Init(next_page_id, last_page_id_, log_manager_, txn);  // 初始化newpage,将当前lastpage作为前一个page
-        last_page->SetNextPageId(next_page_id);                          // 现在next_page为last_page
-        new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);  // 在new_page中insert
-        buffer_pool_manager_->UnpinPage(last_page_id_, false);  // 将之前的lastpage引用数减一，并不设置脏页
-        buffer_pool_manager_->UnpinPage(next_page_id, true);  // 现在的lastpage引用数减一，并设置为脏页
-        last_page_id_ = next_page_id;                         // 更新lastpageid
-        page_num++;                                           // 增加页面数量
-      } else {                                                // 新建失败
-        buffer_pool_manager_->UnpinPage(next_page_id, false);
-        buffer_pool_manager_->UnpinPage(last_page_id_, false);
-        return false;
-      }
-    }
-    return true;
-  } else {  // 页数不够8，那就从首页开始往后找
-    auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(GetFirstPageId()));
-    bool is_not_valid = buffer_pool_manager_->IsPageFree(GetFirstPageId());
-    if (is_not_valid) {  // 如果首页为空，则新建page
-      first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_));
+    page->WLatch();
+    bool inserted = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    uint32_t free_space = page->GetMaxInsertSize();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, inserted);
+    if (inserted) {
+      free_space_map_->Update(page_id, free_space);
+      return true;
     }
-    if (first_page != nullptr) {
-      page_num = 1;
-      page_id_t page_id = GetFirstPageId();  // 获取首页id
-      last_page_id_ = page_id;               // 更新lastpageid(首页是新建的所以首页就是尾页id)
-      while (1) {                            // 循环直到找到可以插入的数据页
-        if (first_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {  // 尝试将row插入当前页
-          return buffer_pool_manager_->UnpinPage(page_id, true);
-        } else {  // 失败则获取下一页
-          auto next_page_id = first_page->GetNextPageId();
-          if (next_page_id == INVALID_PAGE_ID) {  // 若下一页无效则新建下一页
-            auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(next_page_id));
-            if (new_page == nullptr || next_page_id == INVALID_PAGE_ID)  // 若新建失败，则返回false
-            {
-              buffer_pool_manager_->UnpinPage(page_id, false);
-              return false;
-            } else {  // 若创建成功
-              page_num++;
-              last_page_id_ = next_page_id;                              // 更新尾页
-              new_page->Init(next_page_id, page_id, log_manager_, txn);  // 并初始化新页
-              first_page->SetNextPageId(next_page_id);                   // 将其设置为上一页的下一页
-              buffer_pool_manager_->UnpinPage(page_id, false);           // 取消pin上一页
-              first_page = new_page;                                     // 更新page
-              page_id = next_page_id;                                    // 更新page_id
-            }
-          } else {
-            // 若下一页有效，获得下一页并作为当前页，取消当前页pin，继续循环
-            buffer_pool_manager_->UnpinPage(page_id, false);
-            page_id = next_page_id;
-            first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
-          }
-        }
-      }
-      std::cerr << "table_heap_insert" << std::endl;
-      return false;
-    } else {  // 首页无效的情况
-      buffer_pool_manager_->UnpinPage(first_page_id_, false);
+    // 空闲空间表记录的空间不准确(例如删除的行还没有回收)，按实际空间更新，保证下次不再选中这一页
+    if (!free_space_map_->Update(page_id, std::min(free_space, size - 1))) {
       return false;
     }
   }
+  // 没有页放得下，在尾页后面新建一页
+  page_id_t last_page_id = free_space_map_->GetLastPageId();
+  auto last_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id));
+  if (last_page == nullptr) {
+    return false;
+  }
+  auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPageNear(page_id, last_page_id));
+  if (new_page == nullptr) {
+    buffer_pool_manager_->UnpinPage(last_page_id, false);
+    return false;
+  }
+  new_page->Init(page_id, last_page_id, log_manager_, txn);  // 将当前尾页作为前一页
+  bool inserted = new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+  // 新页先记入空闲空间表(也是页目录)再接到链表上，记不下时放弃这一页
+  if (!free_space_map_->Update(page_id, new_page->GetMaxInsertSize())) {
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    buffer_pool_manager_->DeletePage(page_id);
+    buffer_pool_manager_->UnpinPage(last_page_id, false);
+    return false;
+  }
+  last_page->SetNextPageId(page_id);
+  buffer_pool_manager_->UnpinPage(last_page_id, true);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  return inserted;
+}
+
+size_t TableHeap::BulkInsert(std::vector<Row> &rows, Txn *txn) {
+  if (buffer_pool_manager_->IsReadOnly() || rows.empty()) {
+    return 0;
+  }
+  page_id_t page_id = free_space_map_->GetLastPageId();
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if (page == nullptr) {
+    return 0;
+  }
+  page->WLatch();
+  size_t inserted = 0;
+  for (; inserted < rows.size(); inserted++) {
+    Row &row = rows[inserted];
+    if (row.GetSerializedSize(schema_) > TablePage::SIZE_MAX_ROW) {
+      break;
+    }
+    if (page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
+      continue;
+    }
+    // 当前页满了，接上新的一页继续写，新页在同一个run中连续分配
+    page_id_t next_page_id;
+    auto next_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPageNear(next_page_id, page_id));
+    if (next_page == nullptr) {
+      break;
+    }
+    next_page->Init(next_page_id, page_id, log_manager_, txn);
+    // 新页先记入空闲空间表(也是页目录)再接到链表上，记不下时停在当前页
+    if (!free_space_map_->Update(next_page_id, next_page->GetMaxInsertSize())) {
+      buffer_pool_manager_->UnpinPage(next_page_id, false);
+      buffer_pool_manager_->DeletePage(next_page_id);
+      break;
+    }
+    page->SetNextPageId(next_page_id);
+    free_space_map_->Update(page_id, page->GetMaxInsertSize());
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    page = next_page;
+    page_id = next_page_id;
+    page->WLatch();
+    page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+  }
+  free_space_map_->Update(page_id, page->GetMaxInsertSize());
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  return inserted;
 }
 
 bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
+  if (buffer_pool_manager_->IsReadOnly()) {  // 只读的数据库不能修改
+    return false;
+  }
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   // If the page could not be found, then abort the recovery.
@@ -104,6 +135,9 @@ bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
  * TODO: Student Implement
  */
 bool TableHeap::UpdateTuple(Row &row, const RowId &rid, Txn *txn) {
+  if (buffer_pool_manager_->IsReadOnly()) {  // 只读的数据库不能修改
+    return false;
+  }
   auto page_id = rid.GetPageId();
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
   if (page == nullptr) {  // 如果页面不存在
@@ -115,6 +149,7 @@ bool TableHeap::UpdateTuple(Row &row, const RowId &rid, Txn *txn) {
   int res = page->UpdateTuple(row, &old_row, schema_, txn, lock_manager_, log_manager_);
   if (res == 1)  // 返回1说明一切正常
   {
+    UpdateFreeSpace(page_id, page);
     buffer_pool_manager_->UnpinPage(page_id, true);
     return true;
   } else if (res == -3)  // 返回-3，则表明剩余的空闲空间加上旧元组的大小小于新元组的序列化大小
@@ -141,6 +176,7 @@ void TableHeap::ApplyDelete(const RowId &rid, Txn *txn) {
     return;
   } else {  // 删除该行，并标记为脏页
     page->ApplyDelete(rid, txn, log_manager_);
+    UpdateFreeSpace(page_id, page);  // 删除腾出的空间可以被之后的插入重用
     buffer_pool_manager_->UnpinPage(page_id, true);
     return;
   }
@@ -160,6 +196,85 @@ void TableHeap::RollbackDelete(const RowId &rid, Txn *txn) {
 /**
  * TODO: Student Implement
  */
+size_t TableHeap::Compact(const std::function<void(page_id_t old_page_id, page_id_t new_page_id)> &on_page_moved) {
+  size_t moved = 0;
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    page_id_t new_page_id;
+    page_id_t next_page_id;
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->RelocatePage(page_id, new_page_id));
+    if (page != nullptr) {
+      // 页搬到了前面的空闲页，修正页头中的页号以及前后页的链接
+      page->SetTablePageId(new_page_id);
+      next_page_id = page->GetNextPageId();
+      if (prev_page_id == INVALID_PAGE_ID) {
+        first_page_id_ = new_page_id;
+      } else {
+        auto prev_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_page_id));
+        prev_page->SetNextPageId(new_page_id);
+        buffer_pool_manager_->UnpinPage(prev_page_id, true);
+      }
+      if (next_page_id != INVALID_PAGE_ID) {
+        auto next_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+        next_page->SetPrevPageId(new_page_id);
+        buffer_pool_manager_->UnpinPage(next_page_id, true);
+      }
+      buffer_pool_manager_->UnpinPage(new_page_id, true);
+      if (free_space_map_ != nullptr) {
+        free_space_map_->ReplacePage(page_id, new_page_id);
+      }
+      on_page_moved(page_id, new_page_id);
+      page_id = new_page_id;
+      moved++;
+    } else {
+      page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+      if (page == nullptr) {
+        break;
+      }
+      next_page_id = page->GetNextPageId();
+      buffer_pool_manager_->UnpinPage(page_id, false);
+    }
+    prev_page_id = page_id;
+    page_id = next_page_id;
+  }
+  if (free_space_map_ != nullptr) {
+    // 空闲空间表的页建在表最初的页旁边，也要搬走，否则文件无法截短
+    moved += free_space_map_->Compact();
+  }
+  return moved;
+}
+
+size_t TableHeap::GetPageCount() {
+  if (free_space_map_ != nullptr) {
+    return free_space_map_->GetPageCount();
+  }
+  return GetPageIds(0, SIZE_MAX).size();
+}
+
+std::vector<page_id_t> TableHeap::GetPageIds(size_t begin, size_t end) {
+  if (free_space_map_ != nullptr) {
+    return free_space_map_->GetPageIds(begin, end);
+  }
+  // 没有页目录时沿链表走到第begin页
+  std::vector<page_id_t> page_ids;
+  BufferAccessStrategy strategy;
+  page_id_t page_id = first_page_id_;
+  for (size_t i = 0; i < end && page_id != INVALID_PAGE_ID; i++) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, &strategy));
+    if (page == nullptr) {
+      break;
+    }
+    if (i >= begin) {
+      page_ids.push_back(page_id);
+    }
+    page_id_t next_page_id = page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return page_ids;
+}
+
 bool TableHeap::GetTuple(Row *row, Txn *txn) {
   RowId rowid = row->GetRowId();
   auto page_id = rowid.GetPageId();  // 找到该row所在页
@@ -184,18 +299,38 @@ void TableHeap::DeleteTable(page_id_t page_id) {
     buffer_pool_manager_->UnpinPage(page_id, false);
     buffer_pool_manager_->DeletePage(page_id);
   } else {
+    if (free_space_map_ != nullptr) {
+      free_space_map_->Destroy();
+      free_space_map_.reset();
+    }
     DeleteTable(first_page_id_);
   }
 }
 
+void TableHeap::CreateFreeSpaceMap() {
+  free_space_map_.reset(FreeSpaceMap::Create(buffer_pool_manager_, first_page_id_));
+  ASSERT(free_space_map_ != nullptr, "ERROR: cannot create free space map in table heap, please check");
+  BufferAccessStrategy strategy;
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {  // 按链表顺序记录每一页，最后一页即尾页
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, &strategy));
+    ASSERT(page != nullptr, "ERROR: cannot read table heap to build its free space map, please check");
+    [[maybe_unused]] bool recorded = UpdateFreeSpace(page_id, page);
+    ASSERT(recorded, "ERROR: cannot write free space map in table heap, please check");
+    page_id_t next_page_id = page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
 /**
  * TODO: Student Implement
  */
-TableIterator TableHeap::Begin(Txn *txn) {
+TableIterator TableHeap::Begin(Txn *txn, BufferAccessStrategy *strategy) {
   page_id_t page_id = first_page_id_;  // 取出首页id
   RowId result_rid;
   while (1) {
-    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, strategy));
     if (page_id == INVALID_PAGE_ID) {  // 如果页id无效，则返回end
       return End();
     }
@@ -210,7 +345,7 @@ TableIterator TableHeap::Begin(Txn *txn) {
   if (page_id != INVALID_PAGE_ID) {         // 获取成功
     Row *result_row = new Row(result_rid);  // 用获取的id构造row
     GetTuple(result_row, txn);
-    return TableIterator(this, result_rid, txn, result_row);
+    return TableIterator(this, result_rid, txn, result_row, strategy);
   }
   return End();
 }
@@ -1,4 +1,5 @@
 #include "storage/table_iterator.h"
+#include <algorithm>
 #include <cstddef>
 
 #include "common/config.h"
@@ -9,10 +10,11 @@
 /**
  * TODO: Student Implement
  */
-TableIterator::TableIterator(TableHeap *table_heap, RowId &rid, Txn *txn, Row *row) {
+TableIterator::TableIterator(TableHeap *table_heap, RowId &rid, Txn *txn, Row *row, BufferAccessStrategy *strategy) {
   this->table_heap_ = table_heap;
   this->txn = txn;
   this->rid = rid;
+  this->strategy_ = strategy;
   if (row) {
     this->row_ = new Row(*row);  // 深拷贝创建一个新对象
   } else {
@@ -24,9 +26,23 @@ TableIterator::TableIterator(const TableIterator &other) {
   table_heap_ = other.table_heap_;
   rid = other.rid;
   txn = other.txn;
+  strategy_ = other.strategy_;
+  readahead_page_id_ = other.readahead_page_id_;
+  readahead_countdown_ = other.readahead_countdown_;
   row_ = (other.row_ ? new Row(*other.row_) : nullptr);
 }
 
+TableIterator::TableIterator(TableIterator &&other) noexcept {
+  table_heap_ = other.table_heap_;
+  rid = other.rid;
+  txn = other.txn;
+  strategy_ = other.strategy_;
+  readahead_page_id_ = other.readahead_page_id_;
+  readahead_countdown_ = other.readahead_countdown_;
+  row_ = other.row_;
+  other.row_ = nullptr;
+}
+
 TableIterator::~TableIterator() {
   if (row_ != nullptr) {
     delete row_;
@@ -42,10 +58,33 @@ const Row &TableIterator::operator*() { return *row_; }
 Row *TableIterator::operator->() { return row_; }
 
 TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
+  if (this == &itr) {
+    return *this;
+  }
+  delete row_;  // 释放原来的行
   row_ = (itr.row_ ? new Row(*itr.row_) : nullptr);
   table_heap_ = itr.table_heap_;
   rid = itr.rid;
   txn = itr.txn;
+  strategy_ = itr.strategy_;
+  readahead_page_id_ = itr.readahead_page_id_;
+  readahead_countdown_ = itr.readahead_countdown_;
+  return *this;
+}
+
+TableIterator &TableIterator::operator=(TableIterator &&itr) noexcept {
+  if (this == &itr) {
+    return *this;
+  }
+  delete row_;
+  row_ = itr.row_;
+  itr.row_ = nullptr;
+  table_heap_ = itr.table_heap_;
+  rid = itr.rid;
+  txn = itr.txn;
+  strategy_ = itr.strategy_;
+  readahead_page_id_ = itr.readahead_page_id_;
+  readahead_countdown_ = itr.readahead_countdown_;
   return *this;
 }
 
@@ -54,32 +93,33 @@ TableIterator &TableIterator::operator++() {
   ASSERT(row_ != nullptr, "ERROR: ++ operation on a null iterator");  // 获取当前元组所在的磁盘页
   page_id_t page_id = rid.GetPageId();
   ASSERT(page_id != INVALID_PAGE_ID, "ERROR: ++ operation on a end iterator");  // 已经到结尾，不能自增
-  auto *page = reinterpret_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPage(page_id));
+  auto *page = reinterpret_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPage(page_id, strategy_));
   ASSERT(page_id == page->GetPageId(), "ERROR: \"page_id == page->GetPageId()\" should be true");  // 简单判断一下
+  ReadAhead(page);
   RowId next_rid;  // 存储下一个rowid
   if (page->GetNextTupleRid(rid, &next_rid)) {
-    row_->GetFields().clear();                             // 清空row的field，准备存储下一个row
+    row_->destroy();                                       // 清空row的field，准备存储下一个row
     rid.Set(next_rid.GetPageId(), next_rid.GetSlotNum());  // 设置rid为下一个row的id
     row_->SetRowId(rid);
-    table_heap_->GetTuple(row_, nullptr);  // 获取下一个row
-    row_->SetRowId(rid);
+    page->GetTuple(row_, table_heap_->schema_, txn, table_heap_->lock_manager_);  // 从已固定的页中读取下一个row
     table_heap_->buffer_pool_manager_->UnpinPage(page_id, false);
     return *this;
   } else {  // 可能是最后一个row，需要读取下一页
     page_id_t next_page_id = INVALID_PAGE_ID;
     while ((next_page_id = page->GetNextPageId()) != INVALID_PAGE_ID) {  // 获取下一页直到找到或没有更多页
-      auto *next_page = reinterpret_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPage(next_page_id));
+      auto *next_page =
+          reinterpret_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPage(next_page_id, strategy_));
+      table_heap_->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);  // 离开当前页前取消固定
       page = next_page;
+      ReadAhead(page);
       if (page->GetFirstTupleRid(&next_rid)) {  // 获取首个元组，失败则继续循环
-        row_->GetFields().clear();              // 预备装载新的元组信息
+        row_->destroy();                        // 预备装载新的元组信息
         rid = next_rid;
         row_->SetRowId(rid);
-        table_heap_->GetTuple(row_, nullptr);  // 获取实际元组数据
-        row_->SetRowId(rid);
+        page->GetTuple(row_, table_heap_->schema_, txn, table_heap_->lock_manager_);  // 获取实际元组数据
         table_heap_->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
         return *this;
       }  // 继续迭代到下一页
-      table_heap_->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
     }
     rid.Set(INVALID_PAGE_ID, 0);  // rid设置无效页
     table_heap_->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
@@ -89,10 +129,162 @@ TableIterator &TableIterator::operator++() {
 
 // iter++
 TableIterator TableIterator::operator++(int) {
-  Row *row_next = new Row(*(this->row_));  // 深拷贝创建一个新的row对象
-  TableHeap *heap_next = this->table_heap_;
-  RowId rid_next = this->rid;
+  TableIterator old(table_heap_, rid, txn, nullptr, strategy_);
+  old.row_ = row_;  // 当前的row直接交给返回的迭代器，不再深拷贝
+  row_ = new Row(rid);
   ++(*this);
-  return TableIterator(heap_next, rid_next, nullptr, row_next);
-  // 返回一个新的tableiterator对象
+  return old;
+}
+
+/** Read-ahead of both iterators, see TableIterator::ReadAhead. */
+static void ReadAheadChain(BufferPoolManager *buffer_pool_manager, TablePage *page, page_id_t &readahead_page_id,
+                           int &readahead_countdown) {
+  if (page->GetPageId() == readahead_page_id) {
+    return;
+  }
+  readahead_page_id = page->GetPageId();
+  if (readahead_countdown-- > 0) {
+    return;
+  }
+  // 每走过半个预读窗口，就从下一页开始沿链表再预读一个窗口，前半部分通常已在内存中
+  readahead_countdown = DEFAULT_PREFETCH_DISTANCE / 2;
+  buffer_pool_manager->PrefetchChain(page->GetNextPageId(), DEFAULT_PREFETCH_DISTANCE, [](Page *page) {
+    return reinterpret_cast<TablePage *>(page)->GetNextPageId();
+  });
+}
+
+void TableIterator::ReadAhead(TablePage *page) {
+  ReadAheadChain(table_heap_->buffer_pool_manager_, page, readahead_page_id_, readahead_countdown_);
+}
+
+TableViewIterator::TableViewIterator(TableHeap *table_heap, BufferAccessStrategy *strategy)
+    : table_heap_(table_heap), strategy_(strategy) {
+  if (table_heap->first_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+  FetchPage(table_heap->first_page_id_);
+  if (page_ != nullptr) {
+    ReadAheadChain(table_heap_->buffer_pool_manager_, page_, readahead_page_id_, readahead_countdown_);
+    Seek(0);
+  }
+}
+
+TableViewIterator::TableViewIterator(TableHeap *table_heap, BufferAccessStrategy *strategy,
+                                     std::vector<page_id_t> morsel)
+    : table_heap_(table_heap), strategy_(strategy), is_morsel_(true), morsel_(std::move(morsel)) {
+  if (morsel_.empty()) {
+    return;
+  }
+  // 后面的页交给I/O线程预读，与扫描第一页重叠
+  if (morsel_.size() > 1) {
+    table_heap_->buffer_pool_manager_->PrefetchPages(std::vector<page_id_t>(morsel_.begin() + 1, morsel_.end()));
+  }
+  FetchPage(morsel_[0]);
+  morsel_next_ = 1;
+  if (page_ != nullptr) {
+    Seek(0);
+  }
+}
+
+TableViewIterator::TableViewIterator(TableViewIterator &&other) noexcept
+    : table_heap_(other.table_heap_),
+      strategy_(other.strategy_),
+      page_(other.page_),
+      view_(other.view_),
+      readahead_page_id_(other.readahead_page_id_),
+      readahead_countdown_(other.readahead_countdown_),
+      is_morsel_(other.is_morsel_),
+      morsel_(std::move(other.morsel_)),
+      morsel_next_(other.morsel_next_),
+      failed_(other.failed_) {
+  other.page_ = nullptr;  // 页的固定交给新的迭代器
+  other.morsel_.clear();
+  other.morsel_next_ = 0;
+}
+
+TableViewIterator &TableViewIterator::operator=(TableViewIterator &&other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  Release();
+  table_heap_ = other.table_heap_;
+  strategy_ = other.strategy_;
+  page_ = other.page_;
+  view_ = other.view_;
+  readahead_page_id_ = other.readahead_page_id_;
+  readahead_countdown_ = other.readahead_countdown_;
+  is_morsel_ = other.is_morsel_;
+  morsel_ = std::move(other.morsel_);
+  morsel_next_ = other.morsel_next_;
+  failed_ = other.failed_;
+  other.page_ = nullptr;
+  other.morsel_.clear();
+  other.morsel_next_ = 0;
+  return *this;
+}
+
+TableViewIterator::~TableViewIterator() { Release(); }
+
+TableViewIterator &TableViewIterator::operator++() {
+  ASSERT(page_ != nullptr, "ERROR: ++ operation on a end iterator");
+  Seek(view_.GetRowId().GetSlotNum() + 1);
+  return *this;
+}
+
+void TableViewIterator::Seek(uint32_t slot_num) {
+  while (page_ != nullptr) {
+    RowId rid;
+    bool found = (slot_num == 0 ? page_->GetFirstTupleRid(&rid)
+                                : page_->GetNextTupleRid(RowId(page_->GetTablePageId(), slot_num - 1), &rid));
+    if (found) {  // 行就在固定着的页中，原地读取
+      view_.Reset(rid, page_->GetTupleData(rid), table_heap_->schema_);
+      return;
+    }
+    slot_num = 0;
+    if (is_morsel_) {  // 只走morsel中的页
+      Release();
+      if (morsel_next_ < morsel_.size()) {
+        FetchPage(morsel_[morsel_next_++]);
+      }
+      continue;
+    }
+    page_id_t next_page_id = page_->GetNextPageId();
+    Release();
+    if (next_page_id == INVALID_PAGE_ID) {
+      return;
+    }
+    FetchPage(next_page_id);
+    if (page_ != nullptr) {
+      ReadAheadChain(table_heap_->buffer_pool_manager_, page_, readahead_page_id_, readahead_countdown_);
+    }
+  }
+}
+
+void TableViewIterator::FetchPage(page_id_t page_id) {
+  page_ = reinterpret_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPage(page_id, strategy_));
+  // 页存在但缓冲池中没有空闲的页帧，不能当作扫描结束，否则会少返回行
+  failed_ = failed_ || page_ == nullptr;
+}
+
+void TableViewIterator::Release() {
+  if (page_ != nullptr) {
+    table_heap_->buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+    page_ = nullptr;
+  }
+}
+
+TableMorselQueue::TableMorselQueue(TableHeap *table_heap, uint32_t morsel_size)
+    : table_heap_(table_heap),
+      morsel_size_(std::max<uint32_t>(morsel_size, 1)),
+      num_pages_(table_heap->GetPageCount()) {}
+
+bool TableMorselQueue::Next(TableViewIterator &iterator, size_t &morsel_id, BufferAccessStrategy *strategy) {
+  morsel_id = next_morsel_++;
+  size_t begin = morsel_id * morsel_size_;
+  if (begin >= num_pages_) {
+    return false;
+  }
+  iterator = TableViewIterator(table_heap_, strategy,
+                               table_heap_->GetPageIds(begin, std::min<size_t>(begin + morsel_size_, num_pages_)));
+  return true;
 }
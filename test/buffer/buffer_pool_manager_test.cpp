@@ -1,9 +1,13 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <atomic>
 #include <cstdio>
+#include <functional>
 #include <iostream>
 #include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -77,4 +81,563 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
   // LOG(INFO) << "close" << std::endl;
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+
+TEST(BufferPoolManagerTest, AccessStrategyTest) {
+  const std::string db_name = "bpm_strategy_test.db";
+  const size_t buffer_pool_size = 16;
+  const int cold_pages = 64;
+  const int hot_pages = 8;
+  const char garbage[PAGE_SIZE] = "garbage";
+
+  // Run the same scan with and without a buffer ring, and check whether the hot pages stay resident. A page is known
+  // to be resident if it still has its cached content after being overwritten on disk behind the buffer pool's back.
+  for (bool use_strategy : {true, false}) {
+    remove(db_name.c_str());
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, ReplacerType::LRU_K);
+    page_id_t page_id_temp;
+    for (int i = 0; i < cold_pages + hot_pages; i++) {
+      auto *page = bpm->NewPage(page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+      bpm->UnpinPage(page_id_temp, true);
+      bpm->FlushPage(page_id_temp);
+    }
+    for (int i = cold_pages; i < cold_pages + hot_pages; i++) {
+      disk_manager->WritePage(i, garbage);
+    }
+
+    // Scenario: scan all the cold pages once.
+    BufferAccessStrategy strategy(4);
+    for (int i = 0; i < cold_pages; i++) {
+      auto *page = use_strategy ? bpm->FetchPage(i, &strategy) : bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+      bpm->UnpinPage(i, false);
+    }
+
+    int resident = 0;
+    for (int i = cold_pages; i < cold_pages + hot_pages; i++) {
+      auto *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      resident += ("page " + std::to_string(i) == std::string(page->GetData()));
+      bpm->UnpinPage(i, false);
+    }
+    if (use_strategy) {
+      // Scenario: the scan only recycled the frames of its ring, the hot pages are still cached.
+      EXPECT_EQ(hot_pages, resident);
+    } else {
+      // Scenario: without a ring the scan flushed the hot pages out of the buffer pool.
+      EXPECT_GT(hot_pages, resident);
+    }
+    EXPECT_TRUE(bpm->CheckAllUnpinned());
+    delete bpm;
+    delete disk_manager;
+    remove(db_name.c_str());
+  }
+}
+
+TEST(BufferPoolManagerTest, BackgroundWriterTest) {
+  const std::string db_name = "bpm_writer_test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t low_watermark = 4;
+  const size_t high_watermark = 8;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: fill the pool with dirty pages, which leaves no free frame.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_TRUE(bpm->FetchPage(page_id_temp) != nullptr);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: a later read-only user must not clear the dirty flag.
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+
+  // Scenario: once started, the writer evicts pages until high_watermark frames are free, writing them back on its own.
+  auto written_back = [&]() {
+    size_t count = 0;
+    char buf[PAGE_SIZE];
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      disk_manager->ReadPage(i, buf);
+      if (std::string(buf) == "page " + std::to_string(i)) {
+        count++;
+      }
+    }
+    return count;
+  };
+  bpm->StartBackgroundWriter(low_watermark, high_watermark);
+  for (int retry = 0; retry < 100 && written_back() < high_watermark; retry++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(high_watermark, written_back());
+
+  // Scenario: the evicted frames are reused by new pages without exceeding the pool.
+  for (size_t i = 0; i < high_watermark; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+    EXPECT_TRUE(bpm->FetchPage(page_id_temp) != nullptr);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  bpm->StopBackgroundWriter();
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+/** Buffer pool which counts the pages its I/O workers have handled */
+class CountingBufferPoolManager : public BufferPoolManager {
+ public:
+  using BufferPoolManager::BufferPoolManager;
+
+  std::atomic<size_t> prefetched_{0};
+
+  bool IsCached(page_id_t page_id) { return page_table_.Find(DEFAULT_FILE_ID, page_id) != INVALID_FRAME_ID; }
+
+  /** Run action as if it happened while a prefetch read of the page was in flight, return if the read is valid */
+  bool ReadForPrefetch(page_id_t page_id, const std::function<void()> &action) {
+    std::scoped_lock<std::recursive_mutex> lock(latch_);
+    BeginPrefetchRead(DEFAULT_FILE_ID, page_id);
+    action();
+    return EndPrefetchRead(DEFAULT_FILE_ID, page_id);
+  }
+
+ protected:
+  page_id_t PrefetchPage(page_id_t page_id, NextPageIdFunc next_page_id) override {
+    page_id_t next = BufferPoolManager::PrefetchPage(page_id, next_page_id);
+    prefetched_++;
+    return next;
+  }
+
+  void PrefetchBatch(const std::vector<page_id_t> &page_ids) override {
+    BufferPoolManager::PrefetchBatch(page_ids);
+    prefetched_ += page_ids.size();
+  }
+};
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const std::string db_name = "bpm_prefetch_test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new CountingBufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: write a linked list of pages, each page starts with the id of the next one. The first pages are evicted.
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    page_id_t next = (i + 1 < num_pages ? i + 1 : INVALID_PAGE_ID);
+    memcpy(page->GetData(), &next, sizeof(page_id_t));
+    snprintf(page->GetData() + sizeof(page_id_t), PAGE_SIZE - sizeof(page_id_t), "page %d", i);
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: prefetch the first pages of the list, which have been evicted, by following the links.
+  const size_t chain_length = 4;
+  bpm->PrefetchChain(0, chain_length, [](Page *page) { return *reinterpret_cast<page_id_t *>(page->GetData()); });
+  for (int retry = 0; retry < 100 && bpm->prefetched_ < chain_length; retry++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(chain_length, bpm->prefetched_.load());
+
+  // Scenario: the prefetched pages are served from memory, even though the disk is overwritten behind the pool.
+  char garbage[PAGE_SIZE] = {0};
+  for (size_t i = 0; i < chain_length; i++) {
+    disk_manager->WritePage(i, garbage);
+  }
+  for (size_t i = 0; i < chain_length; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData() + sizeof(page_id_t)));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: prefetching cached or unallocated pages is a no-op.
+  bpm->PrefetchPages({0, 1, num_pages + 100});
+  for (int retry = 0; retry < 100 && bpm->prefetched_ < chain_length + 3; retry++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(chain_length + 3, bpm->prefetched_.load());
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, PrefetchValidationTest) {
+  const std::string db_name = "bpm_prefetch_validation_test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new CountingBufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  std::vector<page_id_t> evicted;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    if (!bpm->IsCached(i)) {
+      evicted.push_back(i);
+    }
+  }
+  ASSERT_LE(2, evicted.size());
+  page_id_t cached = page_id_temp;
+  ASSERT_TRUE(bpm->IsCached(cached));
+
+  // Scenario: writing back or flushing other pages while a page is read does not make the read stale.
+  EXPECT_TRUE(bpm->ReadForPrefetch(evicted[0], [&]() {
+    EXPECT_TRUE(bpm->FlushPage(cached));
+    bpm->FlushAllPages();
+  }));
+  // Scenario: the page was loaded, and could have been modified and written back, while it was read.
+  EXPECT_FALSE(bpm->ReadForPrefetch(evicted[0], [&]() {
+    ASSERT_NE(nullptr, bpm->FetchPage(evicted[0]));
+    EXPECT_TRUE(bpm->UnpinPage(evicted[0], true));
+  }));
+  // Scenario: the page was deleted while it was read.
+  EXPECT_FALSE(bpm->ReadForPrefetch(evicted[1], [&]() { EXPECT_TRUE(bpm->DeletePage(evicted[1])); }));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ConcurrentHitTest) {
+  const std::string db_name = "bpm_hit_test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_hot_pages = 8;
+  const int num_cold_pages = 64;
+  const int num_threads = 4;
+  const int rounds = 200;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, ReplacerType::LRU_K);
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_hot_pages + num_cold_pages; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id_temp, sizeof(page_id_t));
+    bpm->UnpinPage(page_id_temp, true);
+  }
+
+  // Scenario: readers hit the hot pages while another thread keeps evicting frames by reading cold pages.
+  std::vector<std::thread> threads;
+  std::vector<int> errors(num_threads + 1, 0);
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < num_hot_pages; i++) {
+          auto *page = bpm->FetchPage(i);
+          if (page == nullptr || *reinterpret_cast<page_id_t *>(page->GetData()) != i) {
+            errors[t]++;
+          }
+          if (page != nullptr) {
+            bpm->UnpinPage(i, round % 16 == t);
+          }
+        }
+      }
+    });
+  }
+  threads.emplace_back([&]() {
+    for (int round = 0; round < rounds / 10; round++) {
+      for (int i = num_hot_pages; i < num_hot_pages + num_cold_pages; i++) {
+        auto *page = bpm->FetchPage(i);
+        if (page != nullptr && *reinterpret_cast<page_id_t *>(page->GetData()) != i) {
+          errors[num_threads]++;
+        }
+        if (page != nullptr) {
+          bpm->UnpinPage(i, false);
+        }
+      }
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t <= num_threads; t++) {
+    EXPECT_EQ(0, errors[t]);
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: every page is still intact after being evicted and reloaded.
+  for (int i = 0; i < num_hot_pages + num_cold_pages; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, *reinterpret_cast<page_id_t *>(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, FrameLayoutTest) {
+  const std::string db_name = "bpm_layout_test.db";
+  const size_t buffer_pool_size = 8;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: page descriptors start on their own cache line, and page data is page-aligned and zeroed.
+  std::vector<Page *> pages;
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page) % 64);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+    EXPECT_EQ(0, page->GetData()[0]);
+    EXPECT_EQ(0, page->GetData()[PAGE_SIZE - 1]);
+    for (auto *other : pages) {
+      EXPECT_GE(std::abs(page->GetData() - other->GetData()), PAGE_SIZE);
+    }
+    pages.push_back(page);
+  }
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, WarmUpTest) {
+  const std::string db_name = "bpm_warm_up_test.db";
+  const std::string resident_pages_file = db_name + ".resident";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, ReplacerType::LRU_K);
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  // pages 8-15 are cached, page 12 is the coldest since it is the only one accessed less than twice
+  for (int i = num_pages - 1; i >= static_cast<int>(buffer_pool_size); i--) {
+    if (i != 12) {
+      ASSERT_NE(nullptr, bpm->FetchPage(i));
+      EXPECT_TRUE(bpm->UnpinPage(i, false));
+    }
+  }
+
+  // Scenario: the cached pages are dumped coldest first.
+  std::vector<page_id_t> resident_pages = bpm->GetResidentPageIds();
+  ASSERT_EQ(buffer_pool_size, resident_pages.size());
+  EXPECT_EQ(12, resident_pages.front());
+  EXPECT_TRUE(bpm->DumpResidentPages(resident_pages_file));
+  delete bpm;
+  EXPECT_EQ(resident_pages, BufferPoolManager::LoadResidentPages(resident_pages_file));
+  EXPECT_TRUE(BufferPoolManager::LoadResidentPages(db_name + ".missing").empty());
+
+  // Scenario: a new buffer pool loads the pages back in the background, in the same order.
+  auto *warm_bpm = new CountingBufferPoolManager(buffer_pool_size, disk_manager, ReplacerType::LRU_K);
+  warm_bpm->StartWarmUp(BufferPoolManager::LoadResidentPages(resident_pages_file));
+  for (int retry = 0; retry < 100 && warm_bpm->GetResidentPageIds() != resident_pages; retry++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(resident_pages, warm_bpm->GetResidentPageIds());
+  EXPECT_EQ(buffer_pool_size, warm_bpm->prefetched_.load());
+  char garbage[PAGE_SIZE] = {0};
+  for (auto page_id : resident_pages) {
+    disk_manager->WritePage(page_id, garbage);
+  }
+  for (auto page_id : resident_pages) {
+    auto *page = warm_bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(warm_bpm->UnpinPage(page_id, false));
+  }
+
+  delete warm_bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+  remove(resident_pages_file.c_str());
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "bpm_resize_test.db";
+  const size_t buffer_pool_size = 8;
+  const size_t grown_pool_size = BUFFER_POOL_CHUNK_PAGES + 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+
+  // Scenario: growing the pool across a chunk boundary adds free frames, and the cached pages stay in place.
+  EXPECT_FALSE(bpm->Resize(0));
+  EXPECT_TRUE(bpm->Resize(grown_pool_size));
+  EXPECT_EQ(grown_pool_size, bpm->GetPoolSize());
+  for (size_t i = buffer_pool_size; i < grown_pool_size; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, page->GetData()[0]);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+
+  // Scenario: the pool can not shrink while the pages to evict are in use, nor lose any of them.
+  EXPECT_FALSE(bpm->Resize(buffer_pool_size));
+  EXPECT_EQ(grown_pool_size, bpm->GetPoolSize());
+  for (size_t i = 0; i < grown_pool_size; i++) {
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  }
+
+  // Scenario: shrinking writes the evicted pages back, and the pool still evicts in order afterwards.
+  EXPECT_TRUE(bpm->Resize(buffer_pool_size));
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+  for (size_t i = 0; i < grown_pool_size; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: frames given back by a shrink can be used again when the pool grows.
+  EXPECT_TRUE(bpm->Resize(buffer_pool_size * 2));
+  for (size_t i = 0; i < buffer_pool_size * 2; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, page->GetData()[0]);
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  const std::string db_name = "bpm_flush_all_test.db";
+  const size_t buffer_pool_size = 32;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    // dirty every other page, the others are never written back
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, i % 2 == 0));
+  }
+  auto *pinned = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, pinned);
+
+  // Scenario: the dirty pages reach the disk, pinned or not, and stay cached.
+  bpm->FlushAllPages();
+  char data[PAGE_SIZE];
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    disk_manager->ReadPage(i, data);
+    EXPECT_EQ(i % 2 == 0 ? "page " + std::to_string(i) : "", std::string(data));
+  }
+  EXPECT_EQ(pinned, bpm->FetchPage(0));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: a page dirtied again after the checkpoint is written back by the next one.
+  auto *page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "page 1 again");
+  EXPECT_TRUE(bpm->UnpinPage(1, true));
+  bpm->FlushAllPages();
+  disk_manager->ReadPage(1, data);
+  EXPECT_EQ("page 1 again", std::string(data));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, RelocatePageTest) {
+  const std::string db_name = "bpm_relocate_test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 10;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_TRUE(bpm->DeletePage(2));
+  EXPECT_TRUE(bpm->DeletePage(4));
+
+  // Scenario: a page moves to the lowest free page before it, with its content, and its old page is freed.
+  auto *page = bpm->RelocatePage(num_pages - 1, page_id_temp);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(2, page_id_temp);
+  EXPECT_EQ("page " + std::to_string(num_pages - 1), std::string(page->GetData()));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  EXPECT_TRUE(bpm->IsPageFree(num_pages - 1));
+
+  // Scenario: a page stays if no page before it is free, or if it is in use.
+  EXPECT_EQ(nullptr, bpm->RelocatePage(1, page_id_temp));
+  EXPECT_EQ(INVALID_PAGE_ID, page_id_temp);
+  ASSERT_NE(nullptr, bpm->FetchPage(num_pages - 2));
+  EXPECT_EQ(nullptr, bpm->RelocatePage(num_pages - 2, page_id_temp));
+  EXPECT_TRUE(bpm->IsPageFree(4));
+  EXPECT_TRUE(bpm->UnpinPage(num_pages - 2, false));
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: the moved page is written back, and the free pages at the end of the file are cut off.
+  for (int i = 5; i < num_pages - 1; i++) {
+    EXPECT_TRUE(bpm->DeletePage(i));
+  }
+  bpm->TruncateFiles();
+  EXPECT_EQ(6 * PAGE_SIZE, disk_manager->GetFileSize());  // meta page, bitmap and pages 0 to 3
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(2, data);
+  EXPECT_EQ("page " + std::to_string(num_pages - 1), std::string(data));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
@@ -0,0 +1,74 @@
+#include "buffer/lru_k_replacer.h"
+
+#include "gtest/gtest.h"
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: unpin six elements, i.e. add them to the replacer. Each of them has been accessed once.
+  lru_k_replacer.Unpin(1);
+  lru_k_replacer.Unpin(2);
+  lru_k_replacer.Unpin(3);
+  lru_k_replacer.Unpin(4);
+  lru_k_replacer.Unpin(5);
+  lru_k_replacer.Unpin(6);
+  lru_k_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: access frame 1 again. Now it is the only frame with a finite backward 2-distance.
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames with less than two accesses are evicted first, in LRU order.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+
+  // Scenario: pinned frames are not evictable.
+  lru_k_replacer.Pin(5);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+
+  // Scenario: frame 5 now has two accesses as well, but its second-to-last access is more recent than frame 1's.
+  lru_k_replacer.Unpin(5);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  LRUKReplacer lru_k_replacer(8, 2);
+
+  // Scenario: frames 0 and 1 hold hot pages which are accessed repeatedly.
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 2; i++) {
+      lru_k_replacer.Pin(i);
+      lru_k_replacer.Unpin(i);
+    }
+  }
+  // Scenario: a scan touches frames 2..7 once each, after the hot pages.
+  for (int i = 2; i < 8; i++) {
+    lru_k_replacer.Pin(i);
+    lru_k_replacer.Unpin(i);
+  }
+  // The scanned frames are evicted before the hot ones, although they were used more recently.
+  int value;
+  for (int i = 2; i < 8; i++) {
+    ASSERT_TRUE(lru_k_replacer.Victim(&value));
+    EXPECT_EQ(i, value);
+  }
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+}
@@ -0,0 +1,107 @@
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "parallel_bpm_test.db";
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+
+  // Scenario: pages are allocated in order, and each of them lands in its own shard.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+  }
+
+  // Scenario: every shard is full of pinned pages, so no page can be created.
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_EQ(INVALID_PAGE_ID, page_id_temp);
+
+  // Scenario: after unpinning the pages, new pages evict the old ones, which are written back.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  }
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id_temp));
+    EXPECT_EQ(buffer_pool_size + i, page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: deleted pages are released to the disk manager.
+  EXPECT_TRUE(bpm->DeletePage(0));
+  EXPECT_TRUE(bpm->IsPageFree(0));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(ParallelBufferPoolManagerTest, ConcurrentFetchTest) {
+  const std::string db_name = "parallel_bpm_concurrent_test.db";
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 32;
+  const int num_threads = 4;
+  const int num_pages = 128;
+  const int rounds = 20;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id_temp, sizeof(page_id_t));
+    bpm->UnpinPage(page_id_temp, true);
+  }
+
+  // Scenario: several threads read pages concurrently, forcing evictions in every shard.
+  std::vector<std::thread> threads;
+  std::vector<int> errors(num_threads, 0);
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int round = 0; round < rounds; round++) {
+        for (int i = t; i < num_pages; i += num_threads) {
+          auto *page = bpm->FetchPage(i);
+          if (page == nullptr || *reinterpret_cast<page_id_t *>(page->GetData()) != i) {
+            errors[t]++;
+          }
+          if (page != nullptr) {
+            bpm->UnpinPage(i, false);
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < num_threads; t++) {
+    EXPECT_EQ(0, errors[t]);
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+}
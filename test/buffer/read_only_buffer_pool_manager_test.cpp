@@ -0,0 +1,124 @@
+#include "buffer/read_only_buffer_pool_manager.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "common/instance.h"
+#include "gtest/gtest.h"
+
+TEST(ReadOnlyBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "read_only_bpm_test.db";
+  const int num_pages = 100;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(16, disk_manager);
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+  delete bpm;
+  delete disk_manager;
+
+  // Scenario: a missing file can not be opened in read-only mode.
+  remove("read_only_bpm_missing.db");
+  EXPECT_ANY_THROW(DiskManager("read_only_bpm_missing.db", false, true));
+
+  disk_manager = new DiskManager(db_name, false, true);
+  ASSERT_TRUE(disk_manager->IsReadOnly());
+  size_t file_size = disk_manager->GetFileSize();
+  bpm = new ReadOnlyBufferPoolManager(disk_manager);
+  EXPECT_TRUE(bpm->IsReadOnly());
+
+  // Scenario: pages are served in place from the mapping of the file, with the same descriptor on every fetch.
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(disk_manager->GetMappedPage(i), page->GetData());
+    EXPECT_EQ(i, page->GetPageId());
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(page, bpm->FetchPage(i));
+    EXPECT_EQ(2, page->GetPinCount());
+    EXPECT_FALSE(bpm->CheckAllUnpinned());
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+    EXPECT_FALSE(bpm->UnpinPage(i, false));
+    EXPECT_FALSE(bpm->IsPageFree(i));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  // Scenario: pages beyond the end of the file can not be fetched.
+  EXPECT_EQ(nullptr, bpm->FetchPage(static_cast<page_id_t>(file_size / PAGE_SIZE)));
+
+  // Scenario: nothing can be created, deleted or written back, and the file is left unchanged.
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id_temp));
+  EXPECT_EQ(INVALID_PAGE_ID, page_id_temp);
+  EXPECT_EQ(nullptr, bpm->NewPageNear(page_id_temp, 0));
+  EXPECT_FALSE(bpm->DeletePage(0));
+  EXPECT_FALSE(bpm->IsPageFree(0));
+  EXPECT_FALSE(bpm->FlushPage(0));
+  bpm->FlushAllPages();
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->AllocatePage());
+  delete bpm;
+  delete disk_manager;
+
+  disk_manager = new DiskManager(db_name);
+  EXPECT_EQ(file_size, disk_manager->GetFileSize());
+  EXPECT_FALSE(disk_manager->IsPageFree(0));
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(num_pages - 1, data);
+  EXPECT_EQ("page " + std::to_string(num_pages - 1), std::string(data));
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(ReadOnlyBufferPoolManagerTest, DatabaseTest) {
+  const std::string db_name = "read_only_db_test.db";
+  const int row_nums = 1000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Txn txn;
+  auto *db = new DBStorageEngine(db_name, true);
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->CreateTable("table-1", schema.get(), &txn, table_info));
+  for (int i = 0; i < row_nums; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i),
+                              Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, nullptr));
+  }
+  delete db;
+
+  // Scenario: a read-only database can not be initialized.
+  EXPECT_THROW(DBStorageEngine(db_name, true, DEFAULT_BUFFER_POOL_SIZE, DEFAULT_BUFFER_POOL_INSTANCES,
+                               ReplacerType::LRU, nullptr, true),
+               std::invalid_argument);
+
+  // Scenario: the catalog is loaded from the mapping, and every row can be scanned.
+  db = new DBStorageEngine(db_name, false, DEFAULT_BUFFER_POOL_SIZE, DEFAULT_BUFFER_POOL_INSTANCES, ReplacerType::LRU,
+                           nullptr, true);
+  ASSERT_TRUE(db->bpm_->IsReadOnly());
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->GetTable("table-1", table_info));
+  TableHeap *table_heap = table_info->GetTableHeap();
+  int count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); iter++) {
+    EXPECT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    count++;
+  }
+  EXPECT_EQ(row_nums, count);
+
+  // Scenario: the database can not be modified.
+  std::vector<Field> fields{Field(TypeId::kTypeInt, row_nums),
+                            Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
+  Row row(fields);
+  EXPECT_FALSE(table_heap->InsertTuple(row, nullptr));
+  TableInfo *other_table_info = nullptr;
+  EXPECT_EQ(DB_FAILED, db->catalog_mgr_->CreateTable("table-2", schema.get(), &txn, other_table_info));
+  EXPECT_EQ(DB_FAILED, db->catalog_mgr_->DropTable("table-1"));
+  delete db;
+}
@@ -0,0 +1,167 @@
+#include "buffer/segmented_buffer_pool_manager.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "common/instance.h"
+#include "gtest/gtest.h"
+
+TEST(SegmentedBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "segmented_bpm_test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 20;
+
+  remove(db_name.c_str());
+  SegmentedBufferPoolManager::RemoveSegmentFiles(db_name);
+  auto *disk_manager = new DiskManager(db_name);
+  BufferPoolManager *bpm = new SegmentedBufferPoolManager(buffer_pool_size, disk_manager);
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+
+  // Scenario: each segment gets a file of its own, and its page ids carry the segment id.
+  segment_id_t segments[2];
+  for (int i = 0; i < 2; i++) {
+    segments[i] = bpm->CreateSegment();
+    EXPECT_EQ(i + 1, segments[i]);
+    EXPECT_TRUE(std::filesystem::exists(SegmentedBufferPoolManager::GetSegmentFileName(db_name, segments[i])));
+  }
+  page_id_t page_id_temp;
+  std::vector<page_id_t> page_ids[2];
+  for (int i = 0; i < 2; i++) {
+    auto *page = bpm->NewPageInSegment(segments[i], page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(DiskManager::MakePageId(segments[i], 0), page_id_temp);
+    page_ids[i].push_back(page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "segment %u page %d", segments[i], page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: pages created near a page of a segment stay in it, and are evicted to and read back from its file.
+  for (int j = 1; j < num_pages; j++) {
+    for (int i = 0; i < 2; i++) {
+      auto *page = bpm->NewPageNear(page_id_temp, page_ids[i].back());
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(segments[i], DiskManager::SegmentOf(page_id_temp));
+      page_ids[i].push_back(page_id_temp);
+      snprintf(page->GetData(), PAGE_SIZE, "segment %u page %d", segments[i], page_id_temp);
+      EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+    }
+  }
+  auto *page = bpm->NewPage(page_id_temp);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, page_id_temp);
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  for (int i = 0; i < 2; i++) {
+    for (auto page_id : page_ids[i]) {
+      EXPECT_FALSE(bpm->IsPageFree(page_id));
+      page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("segment " + std::to_string(segments[i]) + " page " + std::to_string(page_id),
+                std::string(page->GetData()));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  delete bpm;
+  delete disk_manager;
+
+  // Scenario: the segment files are opened again along with the database file.
+  disk_manager = new DiskManager(db_name);
+  bpm = new SegmentedBufferPoolManager(buffer_pool_size, disk_manager);
+  for (int i = 0; i < 2; i++) {
+    page = bpm->FetchPage(page_ids[i].back());
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("segment " + std::to_string(segments[i]) + " page " + std::to_string(page_ids[i].back()),
+              std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i].back(), false));
+  }
+
+  // Scenario: dropping a segment removes its file without touching the other segments, and its id is reused.
+  EXPECT_FALSE(bpm->DropSegment(MAIN_SEGMENT_ID));
+  EXPECT_TRUE(bpm->DropSegment(segments[0]));
+  EXPECT_FALSE(bpm->DropSegment(segments[0]));
+  EXPECT_FALSE(std::filesystem::exists(SegmentedBufferPoolManager::GetSegmentFileName(db_name, segments[0])));
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[0].front()));
+  EXPECT_EQ(nullptr, bpm->NewPageNear(page_id_temp, page_ids[0].front()));
+  for (auto page_id : page_ids[1]) {
+    page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("segment " + std::to_string(segments[1]) + " page " + std::to_string(page_id),
+              std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(segments[0], bpm->CreateSegment());
+  EXPECT_TRUE(bpm->IsPageFree(page_ids[0].front()));
+  delete bpm;
+  delete disk_manager;
+
+  // Scenario: a buffer pool without segment files keeps every page in the main file.
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  EXPECT_EQ(MAIN_SEGMENT_ID, bpm->CreateSegment());
+  EXPECT_FALSE(bpm->DropSegment(segments[1]));
+  page = bpm->NewPageInSegment(MAIN_SEGMENT_ID, page_id_temp);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(MAIN_SEGMENT_ID, DiskManager::SegmentOf(page_id_temp));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  delete bpm;
+  delete disk_manager;
+
+  remove(db_name.c_str());
+  SegmentedBufferPoolManager::RemoveSegmentFiles(db_name);
+}
+
+TEST(SegmentedBufferPoolManagerTest, DatabaseTest) {
+  const std::string db_name = "segmented_db_test.db";
+  const std::string db_file = "./databases/" + db_name;
+  const int row_nums = 1000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Txn txn;
+  auto *db = new DBStorageEngine(db_name, true, DEFAULT_BUFFER_POOL_SIZE, DEFAULT_BUFFER_POOL_INSTANCES,
+                                 ReplacerType::LRU, nullptr, false, true);
+  TableInfo *table_info = nullptr;
+  IndexInfo *index_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->CreateTable("table-1", schema.get(), &txn, table_info));
+  for (int i = 0; i < row_nums; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i),
+                              Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, nullptr));
+  }
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->CreateIndex("table-1", "index-1", {"id"}, &txn, index_info, "bptree"));
+
+  // Scenario: the table and its index are stored in segment files of their own.
+  segment_id_t table_segment = table_info->GetTableHeap()->GetSegmentId();
+  EXPECT_NE(MAIN_SEGMENT_ID, table_segment);
+  EXPECT_TRUE(std::filesystem::exists(SegmentedBufferPoolManager::GetSegmentFileName(db_file, table_segment)));
+  EXPECT_TRUE(std::filesystem::exists(SegmentedBufferPoolManager::GetSegmentFileName(db_file, table_segment + 1)));
+  delete db;
+
+  // Scenario: the database is opened with its segment files, and every row can be scanned and looked up.
+  db = new DBStorageEngine(db_name, false);
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->GetTable("table-1", table_info));
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->GetIndex("table-1", "index-1", index_info));
+  int count = 0;
+  for (auto iter = table_info->GetTableHeap()->Begin(nullptr); iter != table_info->GetTableHeap()->End(); iter++) {
+    EXPECT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    count++;
+  }
+  EXPECT_EQ(row_nums, count);
+  std::vector<Field> key_fields{Field(TypeId::kTypeInt, row_nums / 2)};
+  Row key(key_fields);
+  std::vector<RowId> result;
+  EXPECT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, result, nullptr));
+  EXPECT_EQ(1, result.size());
+
+  // Scenario: dropping the table removes the files of the table and of its index.
+  EXPECT_EQ(DB_SUCCESS, db->catalog_mgr_->DropTable("table-1"));
+  EXPECT_FALSE(SegmentedBufferPoolManager::HasSegmentFiles(db_file));
+  EXPECT_EQ(DB_TABLE_NOT_EXIST, db->catalog_mgr_->GetTable("table-1", table_info));
+  delete db;
+  db = new DBStorageEngine(db_name, false);
+  EXPECT_EQ(DB_TABLE_NOT_EXIST, db->catalog_mgr_->GetTable("table-1", table_info));
+  delete db;
+}
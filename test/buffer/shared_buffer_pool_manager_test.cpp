@@ -0,0 +1,84 @@
+#include "buffer/shared_buffer_pool_manager.h"
+
+#include <cstdio>
+#include <string>
+
+#include "gtest/gtest.h"
+
+TEST(SharedBufferPoolManagerTest, SampleTest) {
+  const std::string db_names[] = {"shared_bpm_test_0.db", "shared_bpm_test_1.db"};
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 6;
+
+  DiskManager *disk_managers[2];
+  for (int i = 0; i < 2; i++) {
+    remove(db_names[i].c_str());
+    disk_managers[i] = new DiskManager(db_names[i]);
+  }
+  auto *shared_pool = new BufferPoolManager(buffer_pool_size, nullptr, ReplacerType::LRU_K);
+  BufferPoolManager *bpms[2];
+  for (int i = 0; i < 2; i++) {
+    bpms[i] = new SharedBufferPoolManager(shared_pool, disk_managers[i]);
+    EXPECT_EQ(buffer_pool_size, bpms[i]->GetPoolSize());
+  }
+  EXPECT_NE(static_cast<SharedBufferPoolManager *>(bpms[0])->GetFileId(),
+            static_cast<SharedBufferPoolManager *>(bpms[1])->GetFileId());
+
+  // Scenario: both databases allocate the same page ids, which are cached as different pages.
+  page_id_t page_id_temp;
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < num_pages / 2; j++) {
+      auto *page = bpms[i]->NewPage(page_id_temp);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(j, page_id_temp);
+      snprintf(page->GetData(), PAGE_SIZE, "db %d page %d", i, page_id_temp);
+    }
+  }
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < num_pages / 2; j++) {
+      auto *page = bpms[i]->FetchPage(j);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("db " + std::to_string(i) + " page " + std::to_string(j), std::string(page->GetData()));
+      EXPECT_TRUE(bpms[i]->UnpinPage(j, true));
+    }
+  }
+
+  // Scenario: one busy database can use the frames left by the other, evicting its pages.
+  for (int j = num_pages / 2; j < num_pages * 2; j++) {
+    auto *page = bpms[0]->NewPage(page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "db 0 page %d", page_id_temp);
+    EXPECT_TRUE(bpms[0]->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_TRUE(bpms[1]->GetResidentPageIds().empty());
+  EXPECT_EQ(buffer_pool_size, bpms[0]->GetResidentPageIds().size());
+  for (int j = 0; j < num_pages / 2; j++) {
+    auto *page = bpms[1]->FetchPage(j);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("db 1 page " + std::to_string(j), std::string(page->GetData()));
+    EXPECT_TRUE(bpms[1]->UnpinPage(j, false));
+  }
+  EXPECT_TRUE(bpms[0]->CheckAllUnpinned());
+  EXPECT_TRUE(bpms[1]->CheckAllUnpinned());
+
+  // Scenario: closing a database writes its pages back and frees their frames for the others.
+  delete bpms[1];
+  EXPECT_EQ(buffer_pool_size - bpms[0]->GetResidentPageIds().size(), num_pages / 2);
+  char data[PAGE_SIZE];
+  disk_managers[1]->ReadPage(0, data);
+  EXPECT_EQ("db 1 page 0", std::string(data));
+  bpms[1] = new SharedBufferPoolManager(shared_pool, disk_managers[1]);
+  auto *page = bpms[1]->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("db 1 page 1", std::string(page->GetData()));
+  EXPECT_TRUE(bpms[1]->UnpinPage(1, false));
+
+  for (int i = 0; i < 2; i++) {
+    delete bpms[i];
+  }
+  delete shared_pool;
+  for (int i = 0; i < 2; i++) {
+    delete disk_managers[i];
+    remove(db_names[i].c_str());
+  }
+}
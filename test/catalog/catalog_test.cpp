@@ -126,4 +126,81 @@ TEST(CatalogTest, CatalogIndexTest) {
     ASSERT_EQ(rid.Get(), ret_02[i].Get());
   }
   delete db_02;
-}
\ No newline at end of file
+}
+TEST(CatalogTest, CatalogCompactTest) {
+  const int row_nums = 2000;
+  auto *db = new DBStorageEngine(db_file_name, true);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Txn txn;
+  TableInfo *table_info = nullptr;
+  IndexInfo *index_info = nullptr;
+  auto insert_rows = [&](TableInfo *info) {
+    for (int i = 0; i < row_nums; i++) {
+      std::vector<Field> fields{Field(TypeId::kTypeInt, i),
+                                Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
+      Row row(fields);
+      ASSERT_TRUE(info->GetTableHeap()->InsertTuple(row, nullptr));
+    }
+  };
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->CreateTable("table-0", schema.get(), &txn, table_info));
+  insert_rows(table_info);
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->CreateTable("table-1", schema.get(), &txn, table_info));
+  insert_rows(table_info);
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->CreateIndex("table-1", "index-1", {"id"}, &txn, index_info, "bptree"));
+  page_id_t first_page_id = table_info->GetTableHeap()->GetFirstPageId();
+  auto check_rows = [&](DBStorageEngine *engine) {
+    ASSERT_EQ(DB_SUCCESS, engine->catalog_mgr_->GetTable("table-1", table_info));
+    ASSERT_EQ(DB_SUCCESS, engine->catalog_mgr_->GetIndex("table-1", "index-1", index_info));
+    int count = 0;
+    for (auto iter = table_info->GetTableHeap()->Begin(nullptr); iter != table_info->GetTableHeap()->End(); iter++) {
+      EXPECT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+      count++;
+    }
+    EXPECT_EQ(row_nums, count);
+    for (int i = 0; i < row_nums; i += 7) {
+      std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+      Row key(key_fields);
+      std::vector<RowId> result;
+      ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, result, nullptr));
+      ASSERT_EQ(1, result.size());
+      Row row(result[0]);
+      ASSERT_TRUE(table_info->GetTableHeap()->GetTuple(&row, nullptr));
+      EXPECT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(Field(TypeId::kTypeInt, i)));
+    }
+  };
+
+  // Scenario: the pages of a table and its index move into the space of a dropped table, and the file shrinks.
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->DropTable("table-0"));
+  db->bpm_->FlushAllPages();
+  size_t file_size = db->disk_mgr_->GetFileSize();
+  EXPECT_TRUE(db->bpm_->CheckAllUnpinned());
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->Compact());
+  EXPECT_LT(db->disk_mgr_->GetFileSize(), file_size);
+  // the free space map moves along with the table, so no live page is left past the space freed by table-0
+  page_id_t live_pages = 0;
+  page_id_t last_live_page = INVALID_PAGE_ID;
+  for (page_id_t i = 0; i < static_cast<page_id_t>(DiskManager::BITMAP_SIZE); i++) {
+    if (!db->disk_mgr_->IsPageFree(i)) {
+      live_pages++;
+      last_live_page = i;
+    }
+  }
+  EXPECT_EQ(live_pages, last_live_page + 1);
+  EXPECT_EQ((last_live_page + 3) * PAGE_SIZE, db->disk_mgr_->GetFileSize());  // after the meta page and the bitmap
+  EXPECT_LT(table_info->GetTableHeap()->GetFirstPageId(), first_page_id);
+  check_rows(db);
+
+  // Scenario: the new place of the table and of the root of its index is found again after a restart.
+  delete db;
+  db = new DBStorageEngine(db_file_name, false);
+  check_rows(db);
+
+  // Scenario: rows are inserted after the last page of the compacted table.
+  std::vector<Field> fields{Field(TypeId::kTypeInt, row_nums),
+                            Field(TypeId::kTypeChar, const_cast<char *>("minisql"), 7, true)};
+  Row row(fields);
+  EXPECT_TRUE(table_info->GetTableHeap()->InsertTuple(row, nullptr));
+  delete db;
+}
@@ -1,6 +1,7 @@
 //
 // Created by njz on 2023/1/26.
 //
+#include "executor/executors/seq_scan_executor.h"
 #include "executor/plans/delete_plan.h"
 #include "executor/plans/insert_plan.h"
 #include "executor/plans/seq_scan_plan.h"
@@ -115,6 +116,101 @@ TEST_F(ExecutorTest, SimpleRawInsertTest) {
   ASSERT_TRUE(result_set[0].GetField(2)->CompareEquals(Field(kTypeFloat, static_cast<float>(2.33))));
 }
 
+// INSERT INTO table-1 VALUES (1000, "aaa", 2.33), ..., (3999, "aaa", 2.33), (4000, ...), (4000, ...), (5000, ...);
+TEST_F(ExecutorTest, MultiRowInsertTest) {
+  TableInfo *table_info;
+  GetExecutorContext()->GetCatalog()->GetTable("table-1", table_info);
+  IndexInfo *index_info = nullptr;
+  std::vector<std::string> index_keys{"id"};
+  ASSERT_EQ(DB_SUCCESS, GetExecutorContext()->GetCatalog()->CreateIndex("table-1", "index-1", index_keys, GetTxn(),
+                                                                        index_info, "bptree"));
+  std::vector<int> ids;
+  for (int i = 1000; i < 4000; i++) {
+    ids.push_back(i);
+  }
+  ids.insert(ids.end(), {4000, 4000, 5000});
+  std::vector<std::vector<AbstractExpressionRef>> raw_values;
+  for (int id : ids) {
+    raw_values.push_back({MakeConstantValueExpression(Field(kTypeInt, id)),
+                          MakeConstantValueExpression(Field(kTypeChar, const_cast<char *>("aaa"), 3, false)),
+                          MakeConstantValueExpression(Field(kTypeFloat, static_cast<float>(2.33)))});
+  }
+  auto value_plan = std::make_shared<ValuesPlanNode>(nullptr, raw_values);
+  auto insert_plan = std::make_shared<InsertPlanNode>(nullptr, value_plan, "table-1");
+
+  // The rows are inserted batch by batch, up to the second row whose key is 4000, which is undone with the rows after
+  // it in its batch.
+  std::vector<Row> result_set{};
+  GetExecutionEngine()->ExecutePlan(insert_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(3001, result_set.size());
+  result_set.clear();
+  const Schema *schema = table_info->GetSchema();
+  auto scan_plan = make_shared<SeqScanPlanNode>(schema, table_info->GetTableName(), nullptr);
+  GetExecutionEngine()->ExecutePlan(scan_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(4001, result_set.size());
+  for (int id : {1000, 2500, 3999, 4000}) {
+    std::vector<RowId> rids;
+    Fields key_fields{Field(kTypeInt, id)};
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(Row(key_fields), rids, GetTxn()));
+    ASSERT_EQ(1, rids.size());
+    Row row(rids[0]);
+    ASSERT_TRUE(table_info->GetTableHeap()->GetTuple(&row, GetTxn()));
+    ASSERT_TRUE(row.GetField(0)->CompareEquals(Field(kTypeInt, id)));
+  }
+  std::vector<RowId> rids;
+  Fields key_fields{Field(kTypeInt, 5000)};
+  index_info->GetIndex()->ScanKey(Row(key_fields), rids, GetTxn());
+  ASSERT_TRUE(rids.empty());
+}
+
+// SELECT id, name FROM table-1 WHERE id < 15000, scanned in parallel
+TEST_F(ExecutorTest, ParallelSeqScanTest) {
+  TableInfo *table_info;
+  GetExecutorContext()->GetCatalog()->GetTable("table-1", table_info);
+  std::vector<Row> rows;
+  for (int i = 1000; i < 20000; i++) {
+    Fields fields{Field(kTypeInt, i), Field(kTypeChar, const_cast<char *>("minisql"), 7, false),
+                  Field(kTypeFloat, static_cast<float>(i))};
+    rows.emplace_back(fields);
+  }
+  ASSERT_EQ(rows.size(), table_info->GetTableHeap()->BulkInsert(rows, GetTxn()));
+  const Schema *schema = table_info->GetSchema();
+  auto col_a = MakeColumnValueExpression(*schema, 0, "id");
+  auto col_b = MakeColumnValueExpression(*schema, 0, "name");
+  auto const15000 = MakeConstantValueExpression(Field(kTypeInt, 15000));
+  auto predicate = MakeComparisonExpression(col_a, const15000, "<");
+  auto out_schema = MakeOutputSchema({{"id", col_a}, {"name", col_b}});
+  auto plan = make_shared<SeqScanPlanNode>(out_schema, table_info->GetTableName(), predicate);
+
+  auto scan = [&](size_t num_workers, size_t limit) {
+    std::vector<Row> result_set;
+    SeqScanExecutor executor(GetExecutorContext(), plan.get(), num_workers);
+    executor.Init();
+    Row row;
+    RowId rid;
+    while (result_set.size() < limit && executor.Next(&row, &rid)) {
+      EXPECT_EQ(rid, row.GetRowId());
+      result_set.push_back(row);
+    }
+    return result_set;
+  };
+  // Scenario: the parallel scan yields the rows of the sequential scan, in the same order.
+  auto expected = scan(1, SIZE_MAX);
+  ASSERT_EQ(15000, expected.size());
+  for (size_t num_workers : {2, 4, 16}) {
+    auto result_set = scan(num_workers, SIZE_MAX);
+    ASSERT_EQ(expected.size(), result_set.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+      ASSERT_EQ(expected[i].GetRowId(), result_set[i].GetRowId());
+      ASSERT_TRUE(result_set[i].GetField(0)->CompareEquals(*expected[i].GetField(0)));
+      ASSERT_TRUE(result_set[i].GetField(1)->CompareEquals(*expected[i].GetField(1)));
+    }
+  }
+  // Scenario: a parallel scan which is not run to its end stops its workers.
+  ASSERT_EQ(100, scan(4, 100).size());
+  ASSERT_EQ(10000, scan(4, 10000).size());
+}
+
 // UPDATE table-1 SET name = "minisql" where id = 500;
 TEST_F(ExecutorTest, SimpleUpdateTest) {
   // Construct a sequential scan of the table
@@ -102,3 +102,55 @@ TEST(TupleTest, RowTest) {
   ASSERT_TRUE(table_page.MarkDelete(row.GetRowId(), nullptr, nullptr, nullptr));
   table_page.ApplyDelete(row.GetRowId(), nullptr, nullptr);
 }
+
+TEST(TupleTest, RowViewTest) {
+  TablePage table_page;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  std::vector<Field> fields = {Field(TypeId::kTypeInt, 188), Field(TypeId::kTypeChar),
+                               Field(TypeId::kTypeFloat, 19.99f)};
+  std::vector<Field> fields2 = {Field(TypeId::kTypeInt, 189),
+                                Field(TypeId::kTypeChar, const_cast<char *>("minisql"), strlen("minisql"), false),
+                                Field(TypeId::kTypeFloat, 29.99f)};
+  Row row(fields);
+  Row row2(fields2);
+  table_page.Init(0, INVALID_PAGE_ID, nullptr, nullptr);
+  ASSERT_TRUE(table_page.InsertTuple(row, schema.get(), nullptr, nullptr, nullptr));
+  ASSERT_TRUE(table_page.InsertTuple(row2, schema.get(), nullptr, nullptr, nullptr));
+
+  // Scenario: the fields are read in any order from the tuple in the page, null fields included.
+  RowView view;
+  view.Reset(row.GetRowId(), table_page.GetTupleData(row.GetRowId()), schema.get());
+  EXPECT_EQ(row.GetRowId(), view.GetRowId());
+  for (int i = 2; i >= 0; i--) {
+    EXPECT_EQ(fields[i].IsNull(), view.IsNull(i));
+    if (!fields[i].IsNull()) {
+      EXPECT_EQ(CmpBool::kTrue, view.GetField(i).CompareEquals(fields[i]));
+    }
+  }
+  view.Reset(row2.GetRowId(), table_page.GetTupleData(row2.GetRowId()), schema.get());
+  for (size_t i = 0; i < fields2.size(); i++) {
+    EXPECT_EQ(CmpBool::kTrue, view.GetField(i).CompareEquals(fields2[i]));
+  }
+  // A char field points into the page unless it is asked to manage its data.
+  EXPECT_GE(view.GetField(1).GetData(), table_page.GetData());
+  EXPECT_LT(view.GetField(1).GetData(), table_page.GetData() + PAGE_SIZE);
+  Field owned = view.GetField(1, true);
+  EXPECT_TRUE(owned.GetData() < table_page.GetData() || owned.GetData() >= table_page.GetData() + PAGE_SIZE);
+
+  // Scenario: the row copied out of the view is the row which was inserted.
+  Row copy;
+  view.ToRow(copy);
+  EXPECT_EQ(row2.GetRowId(), copy.GetRowId());
+  ASSERT_EQ(3, copy.GetFieldCount());
+  for (size_t i = 0; i < fields2.size(); i++) {
+    EXPECT_EQ(CmpBool::kTrue, copy.GetField(i)->CompareEquals(fields2[i]));
+  }
+
+  // Scenario: a deleted tuple can not be viewed.
+  ASSERT_TRUE(table_page.MarkDelete(row.GetRowId(), nullptr, nullptr, nullptr));
+  table_page.ApplyDelete(row.GetRowId(), nullptr, nullptr);
+  EXPECT_EQ(nullptr, table_page.GetTupleData(row.GetRowId()));
+}
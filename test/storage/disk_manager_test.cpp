@@ -1,6 +1,12 @@
 #include "storage/disk_manager.h"
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -56,4 +62,432 @@ TEST(DiskManagerTest, FreePageAllocationTest) {
   EXPECT_EQ(extent_nums * DiskManager::BITMAP_SIZE - 5, meta_page->GetAllocatedPages());
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 2, meta_page->GetExtentUsedPage(0));
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 3, meta_page->GetExtentUsedPage(1));
-}
\ No newline at end of file
+}
+
+TEST(DiskManagerTest, BitmapWriteBackTest) {
+  std::string db_name = "disk_bitmap_test.db";
+  const uint32_t num_pages = DiskManager::BITMAP_SIZE + 100;
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  for (uint32_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+  }
+
+  // Scenario: freed pages around 64-bit word boundaries are reused lowest first, in both extents.
+  std::vector<page_id_t> freed = {63, 64, 200, DiskManager::BITMAP_SIZE - 1, DiskManager::BITMAP_SIZE + 1};
+  for (auto page_id : freed) {
+    disk_mgr->DeAllocatePage(page_id);
+    EXPECT_TRUE(disk_mgr->IsPageFree(page_id));
+  }
+  for (auto page_id : freed) {
+    EXPECT_EQ(page_id, disk_mgr->AllocatePage());
+  }
+  EXPECT_EQ(num_pages, disk_mgr->AllocatePage());
+
+  // Scenario: the bitmaps and the meta page are written back when the file is closed.
+  disk_mgr->DeAllocatePage(64);
+  disk_mgr->DeAllocatePage(DiskManager::BITMAP_SIZE + 2);
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name);
+  auto *meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr->GetMetaData());
+  EXPECT_EQ(2, meta_page->GetExtentNums());
+  EXPECT_EQ(num_pages + 1 - 2, meta_page->GetAllocatedPages());
+  EXPECT_TRUE(disk_mgr->IsPageFree(64));
+  EXPECT_FALSE(disk_mgr->IsPageFree(65));
+  EXPECT_TRUE(disk_mgr->IsPageFree(num_pages + 1));
+  EXPECT_EQ(64, disk_mgr->AllocatePage());
+  EXPECT_EQ(DiskManager::BITMAP_SIZE + 2, disk_mgr->AllocatePage());
+  EXPECT_EQ(num_pages + 1, disk_mgr->AllocatePage());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+TEST(DiskManagerTest, ConcurrentPageIOTest) {
+  std::string db_name = "disk_io_test.db";
+  const int num_threads = 4;
+  const int pages_per_thread = 64;
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+
+  // Scenario: pages beyond the end of the file read as zeroes.
+  char data[PAGE_SIZE];
+  memset(data, 1, PAGE_SIZE);
+  disk_mgr->ReadPage(100, data);
+  EXPECT_EQ(0, data[0]);
+  EXPECT_EQ(0, data[PAGE_SIZE - 1]);
+
+  // Scenario: threads write and read back disjoint pages concurrently.
+  std::vector<std::thread> threads;
+  std::vector<int> errors(num_threads, 0);
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      char buf[PAGE_SIZE];
+      for (int i = t; i < num_threads * pages_per_thread; i += num_threads) {
+        memset(buf, i % 128, PAGE_SIZE);
+        disk_mgr->WritePage(i, buf);
+      }
+      for (int i = t; i < num_threads * pages_per_thread; i += num_threads) {
+        disk_mgr->ReadPage(i, buf);
+        if (buf[0] != i % 128 || buf[PAGE_SIZE - 1] != i % 128) {
+          errors[t]++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < num_threads; t++) {
+    EXPECT_EQ(0, errors[t]);
+  }
+
+  // Scenario: the pages survive closing and reopening the file.
+  disk_mgr->Sync();
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name);
+  disk_mgr->ReadPage(num_threads * pages_per_thread - 1, data);
+  EXPECT_EQ((num_threads * pages_per_thread - 1) % 128, data[0]);
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, BatchPageIOTest) {
+  std::string db_name = "disk_batch_io_test.db";
+  // more pages than the io_uring queue holds, so that the batch is submitted in several rounds
+  const int num_pages = IO_URING_QUEUE_DEPTH * 3 + 7;
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+
+  // Scenario: a batch of pages is written and read back, in a different order.
+  std::vector<char> buffer(num_pages * PAGE_SIZE);
+  std::vector<PageIORequest> requests;
+  for (int i = 0; i < num_pages; i++) {
+    memset(buffer.data() + i * PAGE_SIZE, i % 128, PAGE_SIZE);
+    requests.push_back({i, buffer.data() + i * PAGE_SIZE});
+  }
+  disk_mgr->WritePages(requests);
+  std::fill(buffer.begin(), buffer.end(), -1);
+  std::reverse(requests.begin(), requests.end());
+  disk_mgr->ReadPages(requests);
+  int errors = 0;
+  for (int i = 0; i < num_pages; i++) {
+    if (buffer[i * PAGE_SIZE] != i % 128 || buffer[(i + 1) * PAGE_SIZE - 1] != i % 128) {
+      errors++;
+    }
+  }
+  EXPECT_EQ(0, errors);
+
+  // Scenario: when a batch writes a page twice, the last write wins.
+  char first[PAGE_SIZE];
+  char last[PAGE_SIZE];
+  memset(first, 'f', PAGE_SIZE);
+  memset(last, 'l', PAGE_SIZE);
+  disk_mgr->WritePages({{3, first}, {2, buffer.data()}, {3, last}});
+  disk_mgr->ReadPage(3, first);
+  EXPECT_EQ('l', first[0]);
+
+  // Scenario: when a batch reads a page twice, both buffers get the page.
+  char copies[3][PAGE_SIZE];
+  memset(copies, 0, sizeof(copies));
+  disk_mgr->ReadPages({{7, copies[0]}, {8, copies[1]}, {7, copies[2]}});
+  EXPECT_EQ(7, copies[0][0]);
+  EXPECT_EQ(7, copies[0][PAGE_SIZE - 1]);
+  EXPECT_EQ(8, copies[1][0]);
+  EXPECT_EQ(7, copies[2][0]);
+  EXPECT_EQ(7, copies[2][PAGE_SIZE - 1]);
+
+  // Scenario: pages beyond the end of the file read as zeroes in a batch too.
+  char data[2][PAGE_SIZE];
+  memset(data, 1, sizeof(data));
+  disk_mgr->ReadPages({{num_pages - 1, data[0]}, {num_pages + 10, data[1]}});
+  EXPECT_EQ((num_pages - 1) % 128, data[0][0]);
+  EXPECT_EQ(0, data[1][0]);
+  EXPECT_EQ(0, data[1][PAGE_SIZE - 1]);
+
+  // Scenario: a single page read sees the batch writes.
+  disk_mgr->ReadPage(5, data[0]);
+  EXPECT_EQ(5, data[0][PAGE_SIZE - 1]);
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, DirectIOTest) {
+  std::string db_name = "disk_direct_io_test.db";
+  const int num_pages = 16;
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name, true);
+
+  // Scenario: aligned and unaligned buffers are both written and read back, one by one and in a batch.
+  alignas(PAGE_SIZE) char aligned[num_pages][PAGE_SIZE];
+  std::vector<char> unaligned(PAGE_SIZE + 1);
+  std::vector<PageIORequest> requests;
+  for (int i = 0; i < num_pages; i++) {
+    memset(aligned[i], i + 1, PAGE_SIZE);
+    requests.push_back({i, aligned[i]});
+  }
+  disk_mgr->WritePages(requests);
+  memset(unaligned.data() + 1, 100, PAGE_SIZE);
+  disk_mgr->WritePage(num_pages, unaligned.data() + 1);
+  memset(aligned, 0, sizeof(aligned));
+  disk_mgr->ReadPages(requests);
+  for (int i = 0; i < num_pages; i++) {
+    EXPECT_EQ(i + 1, aligned[i][0]);
+    EXPECT_EQ(i + 1, aligned[i][PAGE_SIZE - 1]);
+  }
+  disk_mgr->ReadPages({{num_pages, unaligned.data() + 1}, {0, aligned[0]}});
+  EXPECT_EQ(100, unaligned[PAGE_SIZE]);
+  EXPECT_EQ(1, aligned[0][0]);
+
+  // Scenario: the pages are on disk, and the meta page is kept, when the file is reopened without direct I/O.
+  page_id_t page_id = disk_mgr->AllocatePage();
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name, false);
+  EXPECT_FALSE(disk_mgr->IsDirectIO());
+  EXPECT_FALSE(disk_mgr->IsPageFree(page_id));
+  disk_mgr->ReadPage(num_pages, aligned[0]);
+  EXPECT_EQ(100, aligned[0][PAGE_SIZE - 1]);
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, AllocationHintTest) {
+  std::string db_name = "disk_hint_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+
+  // Scenario: two segments growing side by side each start a run of their own and stay contiguous in it.
+  page_id_t table_page = disk_mgr->AllocatePageNear(INVALID_PAGE_ID);
+  page_id_t index_page = disk_mgr->AllocatePageNear(INVALID_PAGE_ID);
+  EXPECT_EQ(0, table_page);
+  EXPECT_EQ(ALLOCATION_RUN_PAGES, index_page);
+  for (int i = 1; i < ALLOCATION_RUN_PAGES; i++) {
+    ASSERT_EQ(table_page + 1, disk_mgr->AllocatePageNear(table_page));
+    ASSERT_EQ(index_page + 1, disk_mgr->AllocatePageNear(index_page));
+    table_page++;
+    index_page++;
+  }
+
+  // Scenario: a full run is followed by the next run if it is free, otherwise by a new run.
+  EXPECT_EQ(2 * ALLOCATION_RUN_PAGES, disk_mgr->AllocatePageNear(index_page));
+  EXPECT_EQ(3 * ALLOCATION_RUN_PAGES, disk_mgr->AllocatePageNear(table_page));
+
+  // Scenario: a page freed in a run is reused by the segment which grows from it.
+  disk_mgr->DeAllocatePage(10);
+  EXPECT_EQ(10, disk_mgr->AllocatePageNear(5));
+
+  // Scenario: the file is preallocated up to the end of the runs in use.
+  EXPECT_GE(std::filesystem::file_size(db_name), (4 * ALLOCATION_RUN_PAGES + 2) * PAGE_SIZE);
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, AllocationHintUsedRunTest) {
+  std::string db_name = "disk_hint_used_run_test.db";
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  page_id_t table_page = disk_mgr->AllocatePageNear(INVALID_PAGE_ID);
+  for (int i = 1; i < ALLOCATION_RUN_PAGES; i++) {
+    ASSERT_EQ(table_page + 1, disk_mgr->AllocatePageNear(table_page));
+    table_page++;
+  }
+  page_id_t index_page = disk_mgr->AllocatePageNear(INVALID_PAGE_ID);
+  ASSERT_EQ(ALLOCATION_RUN_PAGES, index_page);
+  ASSERT_EQ(index_page + 1, disk_mgr->AllocatePageNear(index_page));
+  disk_mgr->DeAllocatePage(index_page);
+
+  // Scenario: a full run is not followed into the next run when that run is partly in use, even if its first page
+  // is free, as the run belongs to another segment.
+  EXPECT_EQ(2 * ALLOCATION_RUN_PAGES, disk_mgr->AllocatePageNear(table_page));
+  EXPECT_EQ(index_page + 2, disk_mgr->AllocatePageNear(index_page + 1));
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, SpaceReclamationTest) {
+  std::string db_name = "disk_reclamation_test.db";
+  const int num_pages = 3 * ALLOCATION_RUN_PAGES;
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name);
+  auto allocated_bytes = [&db_name]() {
+    struct stat stat_buf;
+    stat(db_name.c_str(), &stat_buf);
+    return static_cast<size_t>(stat_buf.st_blocks) * 512;
+  };
+  char data[PAGE_SIZE];
+  char buf[PAGE_SIZE];
+  for (int i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+    snprintf(data, PAGE_SIZE, "page %d", i);
+    disk_mgr->WritePage(i, data);
+  }
+  disk_mgr->Sync();
+
+  // Scenario: the space of a run is given back once all its pages are freed and the bitmap is durable.
+  size_t before = allocated_bytes();
+  for (int i = ALLOCATION_RUN_PAGES; i < 2 * ALLOCATION_RUN_PAGES; i++) {
+    disk_mgr->DeAllocatePage(i);
+  }
+  disk_mgr->Sync();
+  EXPECT_LE(allocated_bytes() + ALLOCATION_RUN_PAGES * PAGE_SIZE, before);
+  disk_mgr->ReadPage(ALLOCATION_RUN_PAGES, buf);
+  EXPECT_EQ(0, buf[0]);
+  disk_mgr->ReadPage(2 * ALLOCATION_RUN_PAGES, buf);
+  EXPECT_EQ("page " + std::to_string(2 * ALLOCATION_RUN_PAGES), std::string(buf));
+
+  // Scenario: a page is moved to the lowest free page before it only.
+  disk_mgr->DeAllocatePage(5);
+  EXPECT_EQ(5, disk_mgr->AllocatePageBelow(num_pages - 1));
+  EXPECT_EQ(INVALID_PAGE_ID, disk_mgr->AllocatePageBelow(3));
+  EXPECT_EQ(ALLOCATION_RUN_PAGES, disk_mgr->AllocatePageBelow(num_pages - 1));
+  disk_mgr->DeAllocatePage(ALLOCATION_RUN_PAGES);
+
+  // Scenario: the free pages at the end of the file are cut off, and pages are allocated after the last one again.
+  for (int i = 2 * ALLOCATION_RUN_PAGES; i < num_pages; i++) {
+    disk_mgr->DeAllocatePage(i);
+  }
+  disk_mgr->DeAllocatePage(ALLOCATION_RUN_PAGES - 1);
+  disk_mgr->TruncateFile();
+  EXPECT_EQ((ALLOCATION_RUN_PAGES + 1) * PAGE_SIZE, std::filesystem::file_size(db_name));
+  delete disk_mgr;
+  disk_mgr = new DiskManager(db_name);
+  disk_mgr->ReadPage(ALLOCATION_RUN_PAGES - 2, buf);
+  EXPECT_EQ("page " + std::to_string(ALLOCATION_RUN_PAGES - 2), std::string(buf));
+  EXPECT_EQ(ALLOCATION_RUN_PAGES - 1, disk_mgr->AllocatePage());
+
+  // Scenario: a file without any page left shrinks to its meta page.
+  for (int i = 0; i < ALLOCATION_RUN_PAGES; i++) {
+    disk_mgr->DeAllocatePage(i);
+  }
+  disk_mgr->TruncateFile();
+  EXPECT_EQ(PAGE_SIZE, std::filesystem::file_size(db_name));
+  EXPECT_EQ(0, disk_mgr->AllocatePage());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, CompressionTest) {
+  std::string db_name = "disk_compression_test.db";
+  const int num_pages = 200;
+  remove(db_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name, false, false, true);
+  ASSERT_TRUE(disk_mgr->IsCompressed());
+  auto fill = [](char *data, int page_id, int round) {
+    for (int j = 0; j < PAGE_SIZE; j++) {
+      data[j] = static_cast<char>("minisql "[j % 8] + (j % 64 == 0 ? page_id + round : 0));
+    }
+  };
+
+  // Scenario: repetitive pages are written one by one and in a batch, read back, and take a fraction of the space.
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<PageIORequest> requests;
+  for (int i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr->AllocatePage());
+    fill(pages[i].data(), i, 0);
+    if (i % 2 == 0) {
+      disk_mgr->WritePage(i, pages[i].data());
+    } else {
+      requests.push_back({i, pages[i].data()});
+    }
+  }
+  disk_mgr->WritePages(requests);
+  char data[PAGE_SIZE];
+  for (int i = 0; i < num_pages; i++) {
+    disk_mgr->ReadPage(i, data);
+    ASSERT_EQ(0, memcmp(pages[i].data(), data, PAGE_SIZE));
+  }
+  disk_mgr->ReadPage(num_pages, data);
+  EXPECT_EQ(0, data[0]);
+  delete disk_mgr;
+  EXPECT_LT(std::filesystem::file_size(db_name), num_pages * PAGE_SIZE / 4);
+
+  // Scenario: the format is kept when the file is reopened, whatever is asked for.
+  disk_mgr = new DiskManager(db_name, true);
+  EXPECT_TRUE(disk_mgr->IsCompressed());
+  EXPECT_FALSE(disk_mgr->IsDirectIO());
+  EXPECT_FALSE(disk_mgr->IsPageFree(num_pages - 1));
+  EXPECT_TRUE(disk_mgr->IsPageFree(num_pages));
+  std::vector<char> buffers(num_pages * PAGE_SIZE);
+  requests.clear();
+  for (int i = 0; i < num_pages; i++) {
+    requests.push_back({i, buffers.data() + i * PAGE_SIZE});
+  }
+  disk_mgr->ReadPages(requests);
+  for (int i = 0; i < num_pages; i++) {
+    ASSERT_EQ(0, memcmp(pages[i].data(), buffers.data() + i * PAGE_SIZE, PAGE_SIZE));
+  }
+
+  // Scenario: incompressible pages are stored as they are, and the space of rewritten pages is reused.
+  uintmax_t file_size = 0;
+  for (int round = 1; round <= 6; round++) {
+    for (int i = 0; i < num_pages; i++) {
+      if (round % 2 == 0) {
+        fill(pages[i].data(), i, round);
+      } else {
+        std::generate(pages[i].begin(), pages[i].end(), std::rand);
+      }
+      disk_mgr->WritePage(i, pages[i].data());
+    }
+    disk_mgr->Sync();
+    if (round == 3) {
+      file_size = std::filesystem::file_size(db_name);
+    }
+  }
+  EXPECT_LE(std::filesystem::file_size(db_name), file_size + 4 * PAGE_SIZE);
+  for (int i = 0; i < num_pages; i++) {
+    disk_mgr->ReadPage(i, data);
+    ASSERT_EQ(0, memcmp(pages[i].data(), data, PAGE_SIZE));
+  }
+
+  // Scenario: deallocated pages read back as zeroes once they are reallocated.
+  disk_mgr->DeAllocatePage(5);
+  EXPECT_EQ(5, disk_mgr->AllocatePage());
+  disk_mgr->ReadPage(5, data);
+  EXPECT_EQ(0, data[0]);
+  delete disk_mgr;
+
+  // Scenario: plain files are not compressed.
+  remove(db_name.c_str());
+  disk_mgr = new DiskManager(db_name, false, false, false);
+  EXPECT_FALSE(disk_mgr->IsCompressed());
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, CompressionCrashTest) {
+  std::string db_name = "disk_compression_crash_test.db";
+  std::string crash_name = "disk_compression_crash_copy.db";
+  remove(db_name.c_str());
+  remove(crash_name.c_str());
+  auto *disk_mgr = new DiskManager(db_name, false, false, true);
+  ASSERT_EQ(0, disk_mgr->AllocatePage());
+  char old_data[PAGE_SIZE];
+  for (int j = 0; j < PAGE_SIZE; j++) {
+    old_data[j] = static_cast<char>("minisql "[j % 8] + j / 64);
+  }
+  disk_mgr->WritePage(0, old_data);
+  disk_mgr->Sync();
+
+  // Scenario: a page rewritten with a smaller compressed image is still read as its old image after a crash which
+  // leaves the page location map on disk as of the last sync.
+  char new_data[PAGE_SIZE];
+  memset(new_data, 'x', PAGE_SIZE);
+  disk_mgr->WritePage(0, new_data);
+  std::filesystem::copy_file(db_name, crash_name);
+  char data[PAGE_SIZE];
+  disk_mgr->ReadPage(0, data);
+  EXPECT_EQ(0, memcmp(new_data, data, PAGE_SIZE));
+  delete disk_mgr;
+
+  disk_mgr = new DiskManager(crash_name, false);
+  ASSERT_TRUE(disk_mgr->IsCompressed());
+  disk_mgr->ReadPage(0, data);
+  EXPECT_EQ(0, memcmp(old_data, data, PAGE_SIZE));
+  delete disk_mgr;
+
+  // Scenario: the new image is read once the map has been synced.
+  disk_mgr = new DiskManager(db_name, false);
+  disk_mgr->ReadPage(0, data);
+  EXPECT_EQ(0, memcmp(new_data, data, PAGE_SIZE));
+  delete disk_mgr;
+  remove(db_name.c_str());
+  remove(crash_name.c_str());
+}
@@ -0,0 +1,52 @@
+#include "storage/page_compressor.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(PageCompressorTest, RoundTripTest) {
+  std::vector<std::vector<char>> pages;
+  pages.emplace_back(PAGE_SIZE, 0);
+  pages.emplace_back(PAGE_SIZE);
+  for (int i = 0; i < PAGE_SIZE; i++) {
+    pages.back()[i] = "minisql"[i % 7];
+  }
+  pages.emplace_back(PAGE_SIZE);
+  for (int i = 0; i < PAGE_SIZE; i++) {
+    pages.back()[i] = static_cast<char>(i % 64 == 0 ? std::rand() : i / 64);
+  }
+  pages.emplace_back(PAGE_SIZE);
+  for (auto &c : pages.back()) {
+    c = static_cast<char>(std::rand());
+  }
+  char compressed[2 * PAGE_SIZE];
+  char data[PAGE_SIZE];
+
+  // Scenario: every kind of page decompresses to itself, and repetitive ones shrink a lot.
+  for (size_t i = 0; i < pages.size(); i++) {
+    size_t size = PageCompressor::Compress(pages[i].data(), compressed, sizeof(compressed));
+    ASSERT_NE(0, size);
+    if (i < 2) {
+      EXPECT_LT(size, PAGE_SIZE / 16);
+    }
+    memset(data, 1, PAGE_SIZE);
+    ASSERT_TRUE(PageCompressor::Decompress(compressed, size, data));
+    EXPECT_EQ(0, memcmp(pages[i].data(), data, PAGE_SIZE));
+  }
+
+  // Scenario: random data does not fit in less than a page.
+  EXPECT_EQ(0, PageCompressor::Compress(pages.back().data(), compressed, PAGE_SIZE));
+
+  // Scenario: truncated or damaged data is rejected.
+  size_t size = PageCompressor::Compress(pages[2].data(), compressed, sizeof(compressed));
+  ASSERT_NE(0, size);
+  EXPECT_FALSE(PageCompressor::Decompress(compressed, size / 2, data));
+  for (size_t i = 0; i < size; i++) {
+    std::string damaged(compressed, size);
+    damaged[i] = static_cast<char>(damaged[i] ^ 0x5A);
+    PageCompressor::Decompress(damaged.data(), size, data);  // must not crash
+  }
+}
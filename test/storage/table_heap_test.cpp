@@ -1,5 +1,6 @@
 #include "storage/table_heap.h"
 
+#include <set>
 #include <unordered_map>
 #include <vector>
 
@@ -61,6 +62,380 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   }
   ASSERT_EQ(size, 0);
 }
+
+TEST(TableHeapTest, BulkInsertTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 5000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  Fields first_fields{Field(TypeId::kTypeInt, -1), Field(TypeId::kTypeChar, characters, 1, true)};
+  Row first_row(first_fields);
+  ASSERT_TRUE(table_heap->InsertTuple(first_row, nullptr));
+
+  // Scenario: the rows fill the last page of the table, then new pages, in the order in which they are given.
+  std::vector<Row> rows;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, i % 64 + 1, true)};
+    rows.emplace_back(fields);
+  }
+  ASSERT_EQ(row_nums, table_heap->BulkInsert(rows, nullptr));
+  EXPECT_EQ(first_row.GetRowId().GetPageId(), rows[0].GetRowId().GetPageId());
+  int count = -1;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); iter++, count++) {
+    ASSERT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    if (count >= 0) {
+      EXPECT_EQ(rows[count].GetRowId().Get(), iter->GetRowId().Get());
+    }
+  }
+  EXPECT_EQ(row_nums, count);
+
+  // Scenario: single inserts append after the pages written by the bulk insert.
+  Fields last_fields{Field(TypeId::kTypeInt, row_nums), Field(TypeId::kTypeChar, characters, 64, true)};
+  Row last_row(last_fields);
+  ASSERT_TRUE(table_heap->InsertTuple(last_row, nullptr));
+  EXPECT_GE(last_row.GetRowId().GetPageId(), rows.back().GetRowId().GetPageId());
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, TableViewIteratorTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 3000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  std::vector<std::string> names;
+  for (int i = 0; i < row_nums; i++) {
+    names.push_back(std::string(i % 64, 'a' + i % 26));
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, names[i].data(), names[i].size(), true),
+                  i % 7 == 0 ? Field(TypeId::kTypeFloat) : Field(TypeId::kTypeFloat, static_cast<float>(i))};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  Row deleted_row(RowId(table_heap->GetFirstPageId(), 1));
+  ASSERT_TRUE(table_heap->GetTuple(&deleted_row, nullptr));
+  ASSERT_TRUE(table_heap->MarkDelete(deleted_row.GetRowId(), nullptr));
+  table_heap->ApplyDelete(deleted_row.GetRowId(), nullptr);
+
+  // Scenario: the view iterator yields the same rows as the row iterator, read in place from the pinned page.
+  auto iter = table_heap->Begin(nullptr);
+  int count = 0;
+  for (auto view_iter = table_heap->BeginView(); !view_iter.IsEnd(); ++view_iter, iter++, count++) {
+    ASSERT_NE(table_heap->End(), iter);
+    ASSERT_EQ(iter->GetRowId(), view_iter->GetRowId());
+    EXPECT_FALSE(bpm_->CheckAllUnpinned());
+    for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+      EXPECT_EQ(iter->GetField(i)->IsNull(), view_iter->IsNull(i));
+      if (!iter->GetField(i)->IsNull()) {
+        EXPECT_EQ(CmpBool::kTrue, view_iter->GetField(i).CompareEquals(*iter->GetField(i)));
+      }
+    }
+  }
+  EXPECT_EQ(table_heap->End(), iter);
+  EXPECT_EQ(row_nums - 1, count);
+
+  // Scenario: the page of the current row is unpinned once the iterator leaves it, is moved from or is destroyed.
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  {
+    auto view_iter = table_heap->BeginView();
+    auto row_iter = table_heap->Begin(nullptr);
+    for (int i = 0; i < row_nums / 2; i++) {
+      ++view_iter;
+      ++row_iter;
+    }
+    TableViewIterator moved_iter(std::move(view_iter));
+    EXPECT_TRUE(view_iter.IsEnd());
+    EXPECT_EQ(row_iter->GetRowId(), moved_iter->GetRowId());
+    EXPECT_EQ(CmpBool::kTrue, moved_iter->GetField(0).CompareEquals(*row_iter->GetField(0)));
+  }
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+
+  // Scenario: the iterator fails, rather than ending as if the table had no more rows, when a page can not be fetched.
+  {
+    std::vector<page_id_t> pinned;
+    page_id_t page_id;
+    while (bpm_->NewPage(page_id) != nullptr) {
+      pinned.push_back(page_id);
+    }
+    auto view_iter = table_heap->BeginView();
+    EXPECT_TRUE(view_iter.IsEnd());
+    EXPECT_TRUE(view_iter.IsFailed());
+    for (auto pinned_page_id : pinned) {
+      bpm_->UnpinPage(pinned_page_id, false);
+      bpm_->DeletePage(pinned_page_id);
+    }
+  }
+  EXPECT_FALSE(table_heap->BeginView().IsFailed());
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, TableMorselQueueTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 5000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  std::string name(32, 'a');
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name.data(), name.size(), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  std::vector<RowId> rids;
+  for (auto iter = table_heap->BeginView(); !iter.IsEnd(); ++iter) {
+    rids.push_back(iter->GetRowId());
+  }
+  ASSERT_EQ(row_nums, rids.size());
+
+  // Scenario: the morsels are numbered in chain order and hold the rows of the table in order, each row once.
+  TableMorselQueue queue(table_heap, 4);
+  std::vector<std::vector<RowId>> morsels;
+  TableViewIterator iter;
+  size_t morsel_id;
+  while (queue.Next(iter, morsel_id)) {
+    ASSERT_EQ(morsels.size(), morsel_id);
+    std::set<page_id_t> pages;
+    morsels.emplace_back();
+    for (; !iter.IsEnd(); ++iter) {
+      morsels.back().push_back(iter->GetRowId());
+      pages.insert(iter->GetRowId().GetPageId());
+    }
+    EXPECT_GE(4, pages.size());
+  }
+  EXPECT_EQ(queue.GetMorselCount(), morsels.size());
+  EXPECT_FALSE(queue.Next(iter, morsel_id));
+  EXPECT_LT(1, morsels.size());
+  std::vector<RowId> morsel_rids;
+  for (auto &morsel : morsels) {
+    morsel_rids.insert(morsel_rids.end(), morsel.begin(), morsel.end());
+  }
+  EXPECT_EQ(rids, morsel_rids);
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+
+  // Scenario: the pages of a morsel which is dropped before it is scanned to its end are unpinned.
+  {
+    TableMorselQueue drop_queue(table_heap, 4);
+    ASSERT_TRUE(drop_queue.Next(iter, morsel_id));
+    ++iter;
+    EXPECT_FALSE(bpm_->CheckAllUnpinned());
+    iter = TableViewIterator();
+  }
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, PageDirectoryTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  ASSERT_TRUE(table_heap->HasPageDirectory());
+  ASSERT_EQ(1, table_heap->GetPageCount());
+  std::string name(48, 'a');
+  std::vector<Row> rows;
+  for (int i = 0; i < 4000; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name.data(), name.size(), true)};
+    rows.emplace_back(fields);
+  }
+  ASSERT_EQ(rows.size(), table_heap->BulkInsert(rows, nullptr));
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(table_heap->InsertTuple(rows[i], nullptr));
+  }
+  std::vector<page_id_t> chain;
+  for (page_id_t page_id = table_heap->GetFirstPageId(); page_id != INVALID_PAGE_ID;) {
+    auto page = reinterpret_cast<TablePage *>(bpm_->FetchPage(page_id));
+    chain.push_back(page_id);
+    page_id_t next_page_id = page->GetNextPageId();
+    bpm_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+
+  // Scenario: the directory holds the pages of the table in chain order, and any range of them is found directly.
+  ASSERT_EQ(chain.size(), table_heap->GetPageCount());
+  EXPECT_EQ(chain, table_heap->GetPageIds(0, SIZE_MAX));
+  EXPECT_EQ(std::vector<page_id_t>(chain.begin() + 3, chain.begin() + 7), table_heap->GetPageIds(3, 7));
+  EXPECT_EQ(std::vector<page_id_t>{chain.back()}, table_heap->GetPageIds(chain.size() - 1, chain.size() + 5));
+  EXPECT_TRUE(table_heap->GetPageIds(chain.size(), chain.size() + 1).empty());
+
+  // Scenario: the directory is kept with the table, and is the same when the table is opened again.
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t free_space_map_page_id = table_heap->GetFreeSpaceMapPageId();
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, free_space_map_page_id);
+  ASSERT_EQ(chain.size(), table_heap->GetPageCount());
+  EXPECT_EQ(chain, table_heap->GetPageIds(0, SIZE_MAX));
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 2000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  ASSERT_NE(INVALID_PAGE_ID, table_heap->GetFreeSpaceMapPageId());
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  auto count_pages = [&]() {
+    std::set<page_id_t> pages;
+    for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); iter++) {
+      pages.insert(iter->GetRowId().GetPageId());
+    }
+    return pages.size();
+  };
+  size_t num_pages = count_pages();
+
+  // Scenario: the space of rows deleted in the middle of the table is reused, instead of growing the table.
+  std::set<page_id_t> freed_pages;
+  for (int i = row_nums / 4; i < row_nums / 2; i++) {
+    ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+    table_heap->ApplyDelete(rids[i], nullptr);
+    freed_pages.insert(rids[i].GetPageId());
+  }
+  freed_pages.insert(rids.back().GetPageId());  // the room left in the last page is used too
+  for (int i = row_nums / 4; i < row_nums / 2; i++) {
+    Fields fields{Field(TypeId::kTypeInt, row_nums + i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    EXPECT_EQ(1, freed_pages.count(row.GetRowId().GetPageId()));
+  }
+  EXPECT_EQ(num_pages, count_pages());
+  page_id_t first_page_id = table_heap->GetFirstPageId();
+  page_id_t free_space_map_page_id = table_heap->GetFreeSpaceMapPageId();
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+
+  // Scenario: the free space map is kept in the database file, and read back when the table is opened again.
+  disk_mgr_ = new DiskManager(db_file_name);
+  bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr, free_space_map_page_id);
+  EXPECT_EQ(free_space_map_page_id, table_heap->GetFreeSpaceMapPageId());
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, 2 * row_nums + i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  size_t num_pages_grown = count_pages();
+  EXPECT_LE(num_pages_grown, 2 * num_pages);
+
+  // Scenario: a table opened without a free space map gets one built from its pages, which finds the deleted space.
+  int num_deleted = 0;
+  for (; rids[num_deleted].GetPageId() == first_page_id; num_deleted++) {
+    ASSERT_TRUE(table_heap->MarkDelete(rids[num_deleted], nullptr));
+    table_heap->ApplyDelete(rids[num_deleted], nullptr);
+  }
+  delete table_heap;
+  table_heap = TableHeap::Create(bpm_, first_page_id, schema.get(), nullptr, nullptr);
+  EXPECT_NE(INVALID_PAGE_ID, table_heap->GetFreeSpaceMapPageId());
+  EXPECT_NE(free_space_map_page_id, table_heap->GetFreeSpaceMapPageId());
+  for (int i = 0; i < num_deleted; i++) {
+    Fields fields{Field(TypeId::kTypeInt, 3 * row_nums + i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  EXPECT_EQ(num_pages_grown, count_pages());
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+TEST(TableHeapTest, FreeSpaceMapFullPoolTest) {
+  remove(db_file_name.c_str());
+  const size_t buffer_pool_size = 16;
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+
+  // Scenario: with two free frames, the last page and a new page fit but the page of the free space map does not, so
+  // the insert which needs a new page fails instead of linking a page missing from the page directory.
+  std::vector<page_id_t> pinned;
+  page_id_t page_id;
+  while (pinned.size() + 2 < buffer_pool_size && bpm_->NewPage(page_id) != nullptr) {
+    pinned.push_back(page_id);
+  }
+  ASSERT_EQ(buffer_pool_size - 2, pinned.size());
+  int inserted = 0;
+  while (true) {
+    Fields fields{Field(TypeId::kTypeInt, inserted), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    if (!table_heap->InsertTuple(row, nullptr)) {
+      break;
+    }
+    inserted++;
+  }
+  EXPECT_LT(0, inserted);
+  EXPECT_EQ(1, table_heap->GetPageCount());
+  for (auto pinned_page_id : pinned) {
+    bpm_->UnpinPage(pinned_page_id, false);
+    bpm_->DeletePage(pinned_page_id);
+  }
+
+  // Scenario: once frames are free again, the insert goes to a new page recorded in the page directory.
+  Fields fields{Field(TypeId::kTypeInt, inserted), Field(TypeId::kTypeChar, characters, 64, true)};
+  Row row(fields);
+  ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  inserted++;
+  EXPECT_EQ(2, table_heap->GetPageCount());
+  int count = 0;
+  for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); iter++) {
+    count++;
+  }
+  EXPECT_EQ(inserted, count);
+  EXPECT_TRUE(bpm_->CheckAllUnpinned());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+  remove(db_file_name.c_str());
+}
+
 /*
 // 测试了迭代器,updatetuple
 TEST(TableHeapTest, TableHeapSampleTest_1) {